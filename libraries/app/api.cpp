@@ -27,6 +27,7 @@
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/impacted.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -78,7 +79,7 @@ namespace graphene { namespace app {
     {
        if( api_name == "database_api" )
        {
-          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ) );
+          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), _app.subscriptions() );
        }
        else if( api_name == "block_api" )
        {
@@ -120,6 +121,7 @@ namespace graphene { namespace app {
     vector<optional<signed_block>> block_api::get_blocks(uint32_t block_num_from, uint32_t block_num_to)const
     {
        FC_ASSERT( block_num_to >= block_num_from );
+       FC_ASSERT( block_num_to - block_num_from < 1000 );
        vector<optional<signed_block>> res;
        for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
           res.push_back(_db.fetch_block_by_number(block_num));
@@ -155,8 +157,7 @@ namespace graphene { namespace app {
 
     void network_broadcast_api::broadcast_transaction(const signed_transaction& trx)
     {
-       trx.validate();
-       _app.chain_database()->push_transaction(trx);
+       _app.chain_database()->admit_transaction(trx);
        _app.p2p_node()->broadcast_transaction(trx);
     }
 
@@ -168,9 +169,8 @@ namespace graphene { namespace app {
 
     void network_broadcast_api::broadcast_transaction_with_callback(confirmation_callback cb, const signed_transaction& trx)
     {
-       trx.validate();
        _callbacks[trx.id()] = cb;
-       _app.chain_database()->push_transaction(trx);
+       _app.chain_database()->admit_transaction(trx);
        _app.p2p_node()->broadcast_transaction(trx);
     }
 
@@ -195,6 +195,16 @@ namespace graphene { namespace app {
        return _app.p2p_node()->get_connected_peers();
     }
 
+    transaction_admission_stats network_node_api::get_transaction_admission_stats() const
+    {
+       return _app.chain_database()->get_transaction_admission_stats();
+    }
+
+    vector<block_event_queue::consumer_status> network_node_api::get_block_event_consumer_status() const
+    {
+       return _app.chain_database()->block_events().get_consumer_status();
+    }
+
     std::vector<net::potential_peer_record> network_node_api::get_potential_peers() const
     {
        return _app.p2p_node()->get_potential_peers();
@@ -381,12 +391,7 @@ namespace graphene { namespace app {
                   result.push_back( aobj->owner );
                   break;
                } case impl_transaction_object_type:{
-                  const auto& aobj = dynamic_cast<const transaction_object*>(obj);
-                  assert( aobj != nullptr );
-                  flat_set<account_id_type> impacted;
-                  transaction_get_impacted_accounts( aobj->trx, impacted );
-                  result.reserve( impacted.size() );
-                  for( auto& item : impacted ) result.emplace_back(item);
+                  // only the id of the transaction is kept
                   break;
                } case impl_blinded_balance_object_type:{
                   const auto& aobj = dynamic_cast<const blinded_balance_object*>(obj);
@@ -440,6 +445,19 @@ namespace graphene { namespace app {
           ++count;
        }
 
+       if( count < limit )
+       {
+          // older fills may have been pruned to the market history archive
+          auto plugin = std::dynamic_pointer_cast<graphene::market_history::market_history_plugin>(
+                           _app.get_plugin( "market_history" ) );
+          if( plugin )
+          {
+             const int64_t sequence = result.empty() ? std::numeric_limits<int64_t>::min() : result.back().key.sequence;
+             auto archived = plugin->get_archived_fill_history( a, b, sequence, limit - count );
+             std::move( archived.begin(), archived.end(), std::back_inserter( result ) );
+          }
+       }
+
        return result;
     }
 
@@ -479,31 +497,7 @@ namespace graphene { namespace app {
                                                                        operation_history_id_type stop,
                                                                        unsigned limit) const
     {
-       if (account_object::is_system_account(account)) {
-          return vector<operation_history_object>();
-       }      
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();
-       FC_ASSERT( limit <= 100 );
-       vector<operation_history_object> result;
-       const auto& stats = account(db).statistics(db);
-       if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
-       if( start == operation_history_id_type() )
-          start = node->operation_id;
-
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-          if( node->operation_id.instance.value <= start.instance.value ) {
-
-             if(node->operation_id(db).op.which() == operation_id)
-               result.push_back( node->operation_id(db) );
-             }
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else node = &node->next(db);
-       }
-       return result;
+       return get_account_history_operations2( account, vector<int>{ operation_id }, start, stop, limit );
     }
 
     vector<operation_history_object> history_api::get_account_history_operations2( account_id_type account, 
@@ -521,23 +515,30 @@ namespace graphene { namespace app {
        vector<operation_history_object> result;
        const auto& stats = account(db).statistics(db);
        if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
        if( start == operation_history_id_type() )
-          start = node->operation_id;
+          start = stats.most_recent_op(db).operation_id;
 
-       set<int> filter_operations(operation_ids.begin(), operation_ids.end());
+       const auto& history_idx = dynamic_cast<const primary_index<account_transaction_history_index>&>(
+                                    db.get_index_type<account_transaction_history_index>() );
+       const auto& type_idx = history_idx.get_secondary_index<graphene::account_history::account_history_op_type_index>();
 
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
+       // the newest operations of each type, merged newest first
+       set<int> filter_operations(operation_ids.begin(), operation_ids.end());
+       vector<operation_history_id_type> ids;
+       for( int operation_id : filter_operations )
        {
-          if( node->operation_id.instance.value <= start.instance.value ) {
-             int operation_id = node->operation_id(db).op.which();
-             if ( filter_operations.find(operation_id) != filter_operations.end() )
-               result.push_back( node->operation_id(db) );
-             }
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else node = &node->next(db);
+          auto typed = type_idx.get_operations( account, operation_id, start, stop, limit );
+          ids.insert( ids.end(), typed.begin(), typed.end() );
        }
+       std::sort( ids.begin(), ids.end(), []( operation_history_id_type a, operation_history_id_type b ) {
+          return a.instance.value > b.instance.value;
+       });
+       if( ids.size() > limit )
+          ids.resize( limit );
+
+       result.reserve( ids.size() );
+       for( const auto& id : ids )
+          result.push_back( id(db) );
        return result;
     }    
 
@@ -686,60 +687,55 @@ namespace graphene { namespace app {
     asset_api::asset_api(graphene::chain::database& db) : _db(db) { }
     asset_api::~asset_api() { }
 
+    static const asset_holder_count_index& get_asset_holder_counts( const graphene::chain::database& db )
+    {
+      return dynamic_cast<const primary_index<account_balance_index>&>( db.get_index_type<account_balance_index>() )
+                .get_secondary_index<asset_holder_count_index>();
+    }
+
+    static account_asset_balance make_account_asset_balance( const graphene::chain::database& db,
+                                                             const account_balance_object& bal )
+    {
+      const account_object& account = bal.owner(db);
+
+      account_asset_balance aab;
+      aab.name       = account.name;
+      aab.account_id = account.id;
+      aab.amount     = bal.balance.value;
+      return aab;
+    }
+
     vector<account_asset_balance> asset_api::get_asset_holders( asset_id_type asset_id ) const {
 
       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
       auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
 
       vector<account_asset_balance> result;
+      result.reserve( get_asset_holder_counts( _db ).get_holder_count( asset_id ) );
 
-      for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
-      {
-        if( bal.balance.value == 0 ) continue;
-
-        auto account = _db.find(bal.owner);
-
-        account_asset_balance aab;
-        aab.name       = account->name;
-        aab.account_id = account->id;
-        aab.amount     = bal.balance.value;
-
-        result.push_back(aab);
-      }
+      // balances are ordered largest first, so the holders end where the zero balances start
+      for( auto itr = range.first; itr != range.second && itr->balance != 0; ++itr )
+        result.push_back( make_account_asset_balance( _db, *itr ) );
 
       return result;
     }
     // get number of asset holders.
     int asset_api::get_asset_holders_count( asset_id_type asset_id ) const {
-
-      const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-      auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-            
-      int count = boost::distance(range) - 1;
-
-      return count;
+      return get_asset_holder_counts( _db ).get_holder_count( asset_id );
     }
     // function to get vector of system assets with holders count.
     vector<asset_holders> asset_api::get_all_asset_holders() const {
-            
-      vector<asset_holders> result;
-            
-      vector<asset_id_type> total_assets;
-      for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
-      {
-        const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
 
-        asset_id_type asset_id;
-        asset_id = dasset_obj.id;
+      const auto& counts = get_asset_holder_counts( _db );
+      const auto& assets = _db.get_index_type<asset_index>().indices();
 
-        const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-        auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-        int count = boost::distance(range) - 1;
-                
+      vector<asset_holders> result;
+      result.reserve( assets.size() );
+      for( const asset_object& asset_obj : assets )
+      {
         asset_holders ah;
-        ah.asset_id       = asset_id;
-        ah.count     = count;
+        ah.asset_id  = asset_obj.id;
+        ah.count     = counts.get_holder_count( asset_obj.id );
 
         result.push_back(ah);
       }
@@ -747,4 +743,28 @@ namespace graphene { namespace app {
       return result;
     }
 
+    asset_holders_page asset_api::get_asset_holders_page( asset_id_type asset_id,
+                                                          optional<asset_holders_cursor> start,
+                                                          uint32_t limit )const
+    {
+      FC_ASSERT( limit <= 1000 );
+
+      const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+      auto itr = start.valid() ? bal_idx.upper_bound( boost::make_tuple( asset_id, start->amount, start->account_id ) )
+                               : bal_idx.lower_bound( boost::make_tuple( asset_id ) );
+      const auto end = bal_idx.upper_bound( boost::make_tuple( asset_id ) );
+
+      asset_holders_page result;
+      result.total_holders = get_asset_holder_counts( _db ).get_holder_count( asset_id );
+      result.holders.reserve( std::min<uint64_t>( limit, result.total_holders ) );
+
+      for( ; itr != end && itr->balance != 0 && result.holders.size() < limit; ++itr )
+        result.holders.push_back( make_account_asset_balance( _db, *itr ) );
+
+      if( itr != end && itr->balance != 0 && !result.holders.empty() )
+        result.next = asset_holders_cursor{ result.holders.back().amount, result.holders.back().account_id };
+
+      return result;
+    }
+
 } } // graphene::app
@@ -266,7 +266,8 @@ namespace detail {
 
       application_impl(application* self)
          : _self(self),
-           _chain_db(std::make_shared<chain::database>())
+           _chain_db(std::make_shared<chain::database>()),
+           _subscriptions(std::make_shared<subscription_registry>(*_chain_db))
       {
       }
 
@@ -361,7 +362,7 @@ namespace detail {
                replay = true;
                replay_reason = "replay-blockchain argument specified";
             }
-            else if( !clean )
+            else if( !clean && !chain::database::has_resume_point( _data_dir / "blockchain" ) )
             {
                replay = true;
                replay_reason = "unclean shutdown detected";
@@ -384,6 +385,10 @@ namespace detail {
             }
          }
 
+         // maintenance during replay benefits from the threads as well
+         if( _options->count("maintenance-threads") )
+            _chain_db->set_maintenance_threads( _options->at("maintenance-threads").as<uint32_t>() );
+
          if( !replay )
          {
             try
@@ -404,6 +409,9 @@ namespace detail {
             ilog( "Replaying blockchain due to: ${reason}", ("reason", replay_reason) );
 
             fc::remove_all( _data_dir / "db_version" );
+            if( _options->count("replay-threads") && _options->count("replay-queue-depth") )
+               _chain_db->set_replay_pipeline( _options->at("replay-threads").as<uint32_t>(),
+                                               _options->at("replay-queue-depth").as<uint32_t>() );
             _chain_db->reindex( _data_dir / "blockchain", initial_state() );
 
             const auto mode = std::ios::out | std::ios::binary | std::ios::trunc;
@@ -413,6 +421,19 @@ namespace detail {
             db_version.close();
          }
 
+         if( _options->count("flush-state-interval") )
+            _chain_db->set_flush_changes_interval( _options->at("flush-state-interval").as<uint32_t>() );
+
+         if( _options->count("signature-recovery-threads") )
+            _chain_db->set_signature_recovery_threads( _options->at("signature-recovery-threads").as<uint32_t>() );
+
+         if( _options->count("recent-transaction-cache-size") )
+            _chain_db->set_recent_transaction_cache_size( _options->at("recent-transaction-cache-size").as<uint32_t>() );
+
+         if( _options->count("transaction-admission-threads") && _options->count("transaction-admission-queue-depth") )
+            _chain_db->set_transaction_admission( _options->at("transaction-admission-threads").as<uint32_t>(),
+                                                  _options->at("transaction-admission-queue-depth").as<uint32_t>() );
+
          if( _options->count("force-validate") )
          {
             ilog( "All transaction signatures will be validated" );
@@ -553,7 +574,7 @@ namespace detail {
             trx_count = 0;
          }
 
-         _chain_db->push_transaction( transaction_message.trx );
+         _chain_db->admit_transaction( transaction_message.trx );
       } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
 
       virtual void handle_message(const message& message_to_process) override
@@ -633,13 +654,15 @@ namespace detail {
         // ilog("Request for item ${id}", ("id", id));
          if( id.item_type == graphene::net::block_message_type )
          {
-            auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
+            // the block is sent as it is stored, peers that sync from us would otherwise cost an unpack and a
+            // pack of every block
+            auto opt_block = _chain_db->fetch_packed_block_by_id(id.item_hash);
             if( !opt_block )
                elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                     ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
             FC_ASSERT( opt_block.valid() );
-            // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-            return block_message(std::move(*opt_block));
+            // ilog("Serving up block #${num}", ("num", block_header::num_from_id(id.item_hash)));
+            return graphene::net::make_packed_block_message( std::move(*opt_block), id.item_hash );
          }
          return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
       } FC_CAPTURE_AND_RETHROW( (id) ) }
@@ -889,6 +912,7 @@ namespace detail {
       api_access _apiaccess;
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
+      std::shared_ptr<subscription_registry>                _subscriptions;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
@@ -932,6 +956,14 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
          ("dbg-init-key", bpo::value<string>(), "Block signing key to use for init witnesses, overrides genesis file")
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
+         ("replay-threads", bpo::value<uint32_t>()->default_value(2), "Number of threads prefetching and hashing blocks during replay, 0 to replay on a single thread")
+         ("replay-queue-depth", bpo::value<uint32_t>()->default_value(64), "Maximum number of blocks prefetched ahead of the block being replayed")
+         ("flush-state-interval", bpo::value<uint32_t>()->default_value(0), "Save the objects changed since the last save every this many seconds so an unclean shutdown does not require a replay, 0 to only save on exit")
+         ("signature-recovery-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads recovering transaction signing keys of incoming blocks before they are applied, 0 to recover while applying")
+         ("maintenance-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads tallying votes during chain maintenance, 0 to tally on a single thread")
+         ("transaction-admission-threads", bpo::value<uint32_t>()->default_value(0), "Number of threads checking transactions from the network and API before they are applied, 0 to check them while applying")
+         ("transaction-admission-queue-depth", bpo::value<uint32_t>()->default_value(1000), "Maximum number of transactions being checked by the admission threads, further ones are rejected")
+         ("recent-transaction-cache-size", bpo::value<uint32_t>()->default_value(GRAPHENE_DEFAULT_RECENT_TRANSACTION_CACHE_SIZE), "Number of recently applied transactions kept to serve to peers and the API by id, 0 to keep none")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -1012,6 +1044,11 @@ std::shared_ptr<chain::database> application::chain_database() const
    return my->_chain_db;
 }
 
+std::shared_ptr<subscription_registry> application::subscriptions() const
+{
+   return my->_subscriptions;
+}
+
 void application::set_block_production(bool producing_blocks)
 {
    my->_is_block_producer = producing_blocks;
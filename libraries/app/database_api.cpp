@@ -25,7 +25,6 @@
 #include <graphene/app/database_api.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/transaction_record/transaction_record_plugin.hpp>
-#include <fc/bloom_filter.hpp>
 #include <fc/smart_ref_impl.hpp>
 
 #include <fc/crypto/hex.hpp>
@@ -48,10 +47,10 @@ namespace graphene { namespace app {
 
 class database_api_impl;
 
-class database_api_impl : public std::enable_shared_from_this<database_api_impl>
+class database_api_impl : public std::enable_shared_from_this<database_api_impl>, public subscription_session
 {
    public:
-      database_api_impl( graphene::chain::database& db );
+      database_api_impl( graphene::chain::database& db, std::shared_ptr<subscription_registry> subscriptions );
       ~database_api_impl();
 
       // Objects
@@ -67,6 +66,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       optional<block_header> get_block_header(uint32_t block_num)const;
       map<uint32_t, optional<block_header>> get_block_header_batch(const vector<uint32_t> block_nums)const;
       optional<signed_block> get_block(uint32_t block_num)const;
+      optional<vector<char>> get_packed_block(uint32_t block_num)const;
+      block_range get_block_range(uint32_t start, uint32_t limit, bool packed)const;
       processed_transaction get_transaction( uint32_t block_num, uint32_t trx_in_block )const;
 
       // Globals
@@ -112,8 +113,12 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void subscribe_to_market(std::function<void(const variant&)> callback, asset_id_type a, asset_id_type b);
       void unsubscribe_from_market(asset_id_type a, asset_id_type b);
       market_ticker                      get_ticker( const string& base, const string& quote )const;
+      vector<market_ticker>              get_tickers( const vector<std::pair<string,string>>& markets )const;
       market_volume                      get_24_volume( const string& base, const string& quote )const;
       order_book                         get_order_book( const string& base, const string& quote, unsigned limit = 50 )const;
+      order_book                         get_order_book_depth( const string& base, const string& quote, unsigned levels = 50 )const;
+      void subscribe_to_order_book_depth( std::function<void(const variant&)> callback, const string& base, const string& quote, unsigned levels );
+      void unsubscribe_from_order_book_depth( const string& base, const string& quote );
       vector<market_trade>               get_trade_history( const string& base, const string& quote, fc::time_point_sec start, fc::time_point_sec stop, unsigned limit = 100 )const;
 
       // Witnesses
@@ -160,37 +165,21 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       fc::optional<account_deflation_object> get_account_deflation( account_id_type id )const;
 
    //private:
+      /// keys, addresses and the like never show up in object notifications, only objects can be subscribed to
       template<typename T>
-      void subscribe_to_item( const T& i )const
-      {
-         auto vec = fc::raw::pack(i);
-         if( !_subscribe_callback )
-            return;
-
-         if( !is_subscribed_to_item(i) )
-         {
-            idump((i));
-            _subscribe_filter.insert( vec.data(), vec.size() );//(vecconst char*)&i, sizeof(i) );
-         }
-      }
+      void subscribe_to_item( const T& )const {}
 
-      template<typename T>
-      bool is_subscribed_to_item( const T& i )const
+      template<uint8_t SpaceID, uint8_t TypeID, typename T>
+      void subscribe_to_item( const object_id<SpaceID,TypeID,T>& id )const
       {
-         if( !_subscribe_callback )
-            return false;
-
-         return _subscribe_filter.contains( i );
+         subscribe_to_item( object_id_type(id) );
       }
 
-      bool is_impacted_account( const flat_set<account_id_type>& accounts)
+      void subscribe_to_item( object_id_type id )const
       {
-         if( !_subscribed_accounts.size() || !accounts.size() )
-            return false;
-
-         return std::any_of(accounts.begin(), accounts.end(), [this](const account_id_type& account) {
-            return _subscribed_accounts.find(account) != _subscribed_accounts.end();
-         });
+         if( !_subscribe_callback )
+            return;
+         _subscriptions->subscribe_to_object( this, id );
       }
 
       template<typename T>
@@ -208,8 +197,9 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       }
 
       void broadcast_updates( const vector<variant>& updates );
+      virtual void send_object_updates( const vector<variant>& updates ) override { broadcast_updates( updates ); }
       void broadcast_market_updates( const market_queue_type& queue);
-      void handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object);
+      void handle_object_changed(bool full_object, const vector<object_id_type>& ids, std::function<const object*(object_id_type id)> find_object);
 
       /** called every time a block is applied to report the objects that were changed */
       void on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
@@ -217,9 +207,17 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts);
       void on_applied_block();
 
-      bool _notify_remove_create = false;
-      mutable fc::bloom_filter _subscribe_filter;
-      std::set<account_id_type> _subscribed_accounts;
+      order_book build_order_book_depth( const asset_object& base, const asset_object& quote, unsigned levels )const;
+      void send_order_book_depth_updates();
+
+      struct order_book_depth_subscription
+      {
+         std::function<void(const variant&)> callback;
+         unsigned                            levels = 0;
+         uint64_t                            revision = 0;
+         order_book                          last_sent;
+      };
+
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
       std::function<void(const fc::variant&)> _block_applied_callback;
@@ -230,7 +228,11 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       boost::signals2::scoped_connection                                                                                           _applied_block_connection;
       boost::signals2::scoped_connection                                                                                           _pending_trx_connection;
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> >      _market_subscriptions;
+      /// keyed by (base, quote) as the client asked for them, not sorted like a market
+      map< pair<asset_id_type,asset_id_type>, order_book_depth_subscription >            _order_book_depth_subscriptions;
       graphene::chain::database&                                                                                                            _db;
+      /// object and account subscriptions, shared with the other sessions of the application
+      std::shared_ptr<subscription_registry>                                                                                                _subscriptions;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -239,13 +241,16 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-database_api::database_api( graphene::chain::database& db )
-   : my( new database_api_impl( db ) ) {}
+database_api::database_api( graphene::chain::database& db, std::shared_ptr<subscription_registry> subscriptions )
+   : my( new database_api_impl( db, subscriptions ) ) {}
 
 database_api::~database_api() {}
 
-database_api_impl::database_api_impl( graphene::chain::database& db ):_db(db)
+database_api_impl::database_api_impl( graphene::chain::database& db, std::shared_ptr<subscription_registry> subscriptions )
+   :_db(db), _subscriptions(subscriptions)
 {
+   if( !_subscriptions )
+      _subscriptions = std::make_shared<subscription_registry>( _db );
    wlog("creating database api ${x}", ("x",int64_t(this)) );
    _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
                                 on_objects_new(ids, impacted_accounts);
@@ -266,6 +271,7 @@ database_api_impl::database_api_impl( graphene::chain::database& db ):_db(db)
 database_api_impl::~database_api_impl()
 {
    elog("freeing database api ${x}", ("x",int64_t(this)) );
+   _subscriptions->remove_session( this );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -317,17 +323,11 @@ void database_api::set_subscribe_callback( std::function<void(const variant&)> c
 
 void database_api_impl::set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create )
 {
-   //edump((clear_filter));
    _subscribe_callback = cb;
-   _notify_remove_create = notify_remove_create;
-   _subscribed_accounts.clear();
-
-   static fc::bloom_parameters param;
-   param.projected_element_count    = 10000;
-   param.false_positive_probability = 1.0/100;
-   param.maximum_size = 1024*8*8*2;
-   param.compute_optimal_parameters();
-   _subscribe_filter = fc::bloom_filter(param);
+   // a new callback starts over with no subscriptions
+   _subscriptions->remove_session( this );
+   if( _subscribe_callback )
+      _subscriptions->add_session( this, notify_remove_create );
 }
 
 void database_api::set_pending_transaction_callback( std::function<void(const variant&)> cb )
@@ -359,6 +359,7 @@ void database_api_impl::cancel_all_subscriptions()
 {
    set_subscribe_callback( std::function<void(const fc::variant&)>(), true);
    _market_subscriptions.clear();
+   _order_book_depth_subscriptions.clear();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -404,6 +405,45 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
    return _db.fetch_block_by_number(block_num);
 }
 
+optional<vector<char>> database_api::get_packed_block(uint32_t block_num)const
+{
+   return my->get_packed_block( block_num );
+}
+
+optional<vector<char>> database_api_impl::get_packed_block(uint32_t block_num)const
+{
+   return _db.fetch_packed_block_by_number(block_num);
+}
+
+block_range database_api::get_block_range(uint32_t start, uint32_t limit, bool packed)const
+{
+   return my->get_block_range( start, limit, packed );
+}
+
+block_range database_api_impl::get_block_range(uint32_t start, uint32_t limit, bool packed)const
+{
+   FC_ASSERT( limit <= 1000 );
+
+   block_range result;
+   result.first_block_num = start;
+   result.head_block_num = _db.head_block_num();
+   result.last_irreversible_block_num = _db.get_dynamic_global_properties().last_irreversible_block_num;
+
+   const uint32_t count = _db.fetch_packed_block_range( start, limit, database_api::max_block_range_bytes,
+                                                        result.packed_blocks, result.packed_block_sizes );
+   result.next_block_num = start + count;
+   if( !packed )
+   {
+      result.blocks.resize( count );
+      fc::datastream<const char*> ds( result.packed_blocks.data(), result.packed_blocks.size() );
+      for( auto& b : result.blocks )
+         fc::raw::unpack( ds, b );
+      result.packed_blocks.clear();
+      result.packed_block_sizes.clear();
+   }
+   return result;
+}
+
 processed_transaction database_api::get_transaction( uint32_t block_num, uint32_t trx_in_block )const
 {
    return my->get_transaction( block_num, trx_in_block );
@@ -420,10 +460,9 @@ optional<signed_transaction> database_api::get_recent_transaction_by_id( const t
 
 optional<signed_transaction> database_api::get_transaction_by_id( const transaction_id_type& id )const
 {
-    const auto& idx = my->_db.get_index_type<transaction_record::transaction_record_index>().indices().get<transaction_record::by_trx_id>();
-    auto it = idx.find(id);
-    if (it != idx.end()) {
-        return get_transaction(it->block_num, it->trx_in_block);
+    auto record = transaction_record::transaction_record_plugin::find_transaction_record(my->_db, id);
+    if (record) {
+        return get_transaction(record->block_num, record->trx_in_block);
     }
     return optional<signed_transaction>();
 }
@@ -676,8 +715,11 @@ std::map<std::string, full_account> database_api_impl::get_full_accounts( const
 
       if( subscribe )
       {
-         FC_ASSERT( std::distance(_subscribed_accounts.begin(), _subscribed_accounts.end()) < 100 );
-         _subscribed_accounts.insert( account->get_id() );
+         if( _subscribe_callback )
+         {
+            FC_ASSERT( _subscriptions->get_account_subscription_count( this ) < 100 );
+            _subscriptions->subscribe_to_account( this, account->get_id() );
+         }
          subscribe_to_item( account->id );
       }
 
@@ -1208,39 +1250,32 @@ market_ticker database_api_impl::get_ticker( const string& base, const string& q
     result.quote_volume = 0;
 
     try {
-        const fc::time_point_sec now = fc::time_point::now();
-        const fc::time_point_sec yesterday = fc::time_point_sec( now.sec_since_epoch() - 86400 );
-        const auto batch_size = 100;
+        auto base_id = assets[0]->id;
+        auto quote_id = assets[1]->id;
+        if( base_id > quote_id ) std::swap( base_id, quote_id );
 
-        vector<market_trade> trades = get_trade_history( base, quote, now, yesterday, batch_size );
-        if( !trades.empty() )
+        const auto& ticker_idx = _db.get_index_type<graphene::market_history::market_ticker_index>().indices().get<graphene::market_history::by_market>();
+        auto ticker = ticker_idx.find( boost::make_tuple( base_id, quote_id ) );
+        if( ticker != ticker_idx.end() )
         {
-            result.latest = trades[0].price;
-
-            while( !trades.empty() )
-            {
-                for( const market_trade& t: trades )
-                {
-                    result.base_volume += t.value;
-                    result.quote_volume += t.amount;
-                }
-
-                trades = get_trade_history( base, quote, trades.back().date, yesterday, batch_size );
-            }
-
-            const auto last_trade_yesterday = get_trade_history( base, quote, yesterday, fc::time_point_sec(), 1 );
-            if( !last_trade_yesterday.empty() )
+            // the ticker keeps amounts of the asset with the lower id as base
+            const bool flipped = assets[0]->id != ticker->base;
+            auto to_real = [&]( share_type a, const asset_object& asset ) { return double( a.value ) / pow( 10, asset.precision ); };
+            auto price_to_real = [&]( share_type b, share_type q ) {
+               if( flipped ) std::swap( b, q );
+               return to_real( b, *assets[0] ) / to_real( q, *assets[1] );
+            };
+
+            if( ticker->latest_quote != 0 )
+               result.latest = price_to_real( ticker->latest_base, ticker->latest_quote );
+            result.base_volume = to_real( flipped ? ticker->quote_volume : ticker->base_volume, *assets[0] );
+            result.quote_volume = to_real( flipped ? ticker->base_volume : ticker->quote_volume, *assets[1] );
+            if( ticker->base_volume != 0 && ticker->has_day_open() )
             {
-                const auto price_yesterday = last_trade_yesterday[0].price;
+                const auto price_yesterday = price_to_real( ticker->day_open_base, ticker->day_open_quote );
                 result.percent_change = ( (result.latest / price_yesterday) - 1 ) * 100;
             }
         }
-        else
-        {
-            const auto last_trade = get_trade_history( base, quote, now, fc::time_point_sec(), 1 );
-            if( !last_trade.empty() )
-                result.latest = last_trade[0].price;
-        }
 
         const auto orders = get_order_book( base, quote, 1 );
         if( !orders.asks.empty() ) result.lowest_ask = orders.asks[0].price;
@@ -1250,6 +1285,21 @@ market_ticker database_api_impl::get_ticker( const string& base, const string& q
     return result;
 }
 
+vector<market_ticker> database_api::get_tickers( const vector<std::pair<string,string>>& markets )const
+{
+    return my->get_tickers( markets );
+}
+
+vector<market_ticker> database_api_impl::get_tickers( const vector<std::pair<string,string>>& markets )const
+{
+    FC_ASSERT( markets.size() <= 100 );
+    vector<market_ticker> result;
+    result.reserve( markets.size() );
+    for( const auto& market : markets )
+       result.push_back( get_ticker( market.first, market.second ) );
+    return result;
+}
+
 market_volume database_api::get_24_volume( const string& base, const string& quote )const
 {
     return my->get_24_volume( base, quote );
@@ -1323,6 +1373,168 @@ order_book database_api_impl::get_order_book( const string& base, const string&
    return result;
 }
 
+order_book database_api::get_order_book_depth( const string& base, const string& quote, unsigned levels )const
+{
+   return my->get_order_book_depth( base, quote, levels );
+}
+
+order_book database_api_impl::get_order_book_depth( const string& base, const string& quote, unsigned levels )const
+{
+   FC_ASSERT( levels <= 500 );
+
+   auto assets = lookup_asset_symbols( {base, quote} );
+   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+
+   order_book result = build_order_book_depth( *assets[0], *assets[1], levels );
+   result.base = base;
+   result.quote = quote;
+   return result;
+}
+
+order_book database_api_impl::build_order_book_depth( const asset_object& base, const asset_object& quote, unsigned levels )const
+{
+   const auto& depth = dynamic_cast<const primary_index<limit_order_index>&>( _db.get_index_type<limit_order_index>() )
+                          .get_secondary_index<limit_order_depth_index>();
+   const double base_scale = pow( 10, base.precision );
+   const double quote_scale = pow( 10, quote.precision );
+
+   order_book result;
+   result.base = base.symbol;
+   result.quote = quote.symbol;
+
+   // bids sell base for quote, asks sell quote for base
+   if( const auto* bids = depth.get_side( base.id, quote.id ) )
+   {
+      for( auto itr = bids->begin(); itr != bids->end() && result.bids.size() < levels; ++itr )
+      {
+         order level;
+         level.price = ( itr->first.base.amount.value / base_scale ) / ( itr->first.quote.amount.value / quote_scale );
+         level.base = itr->second.value / base_scale;
+         level.quote = ( asset( itr->second, base.id ) * itr->first ).amount.value / quote_scale;
+         result.bids.push_back( level );
+      }
+   }
+   if( const auto* asks = depth.get_side( quote.id, base.id ) )
+   {
+      for( auto itr = asks->begin(); itr != asks->end() && result.asks.size() < levels; ++itr )
+      {
+         order level;
+         level.price = ( itr->first.quote.amount.value / base_scale ) / ( itr->first.base.amount.value / quote_scale );
+         level.quote = itr->second.value / quote_scale;
+         level.base = ( asset( itr->second, quote.id ) * itr->first ).amount.value / base_scale;
+         result.asks.push_back( level );
+      }
+   }
+   return result;
+}
+
+void database_api::subscribe_to_order_book_depth( std::function<void(const variant&)> callback,
+                                                  const string& base, const string& quote, unsigned levels )
+{
+   my->subscribe_to_order_book_depth( callback, base, quote, levels );
+}
+
+void database_api_impl::subscribe_to_order_book_depth( std::function<void(const variant&)> callback,
+                                                       const string& base, const string& quote, unsigned levels )
+{
+   FC_ASSERT( levels <= 500 );
+
+   auto assets = lookup_asset_symbols( {base, quote} );
+   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+   FC_ASSERT( assets[0]->id != assets[1]->id );
+
+   const auto& depth = dynamic_cast<const primary_index<limit_order_index>&>( _db.get_index_type<limit_order_index>() )
+                          .get_secondary_index<limit_order_depth_index>();
+   order_book_depth_subscription& sub = _order_book_depth_subscriptions[ std::make_pair( assets[0]->id, assets[1]->id ) ];
+   sub.callback = callback;
+   sub.levels = levels;
+   sub.revision = depth.get_revision( std::make_pair( std::min( assets[0]->id, assets[1]->id ), std::max( assets[0]->id, assets[1]->id ) ) );
+   sub.last_sent = build_order_book_depth( *assets[0], *assets[1], levels );
+   sub.last_sent.base = base;
+   sub.last_sent.quote = quote;
+
+   // start the client off with the whole book, then only send what changes
+   auto capture_this = shared_from_this();
+   order_book snapshot = sub.last_sent;
+   fc::async([capture_this,callback,snapshot](){
+      callback( fc::variant( snapshot ) );
+   });
+}
+
+void database_api::unsubscribe_from_order_book_depth( const string& base, const string& quote )
+{
+   my->unsubscribe_from_order_book_depth( base, quote );
+}
+
+void database_api_impl::unsubscribe_from_order_book_depth( const string& base, const string& quote )
+{
+   auto assets = lookup_asset_symbols( {base, quote} );
+   FC_ASSERT( assets[0], "Invalid base asset symbol: ${s}", ("s",base) );
+   FC_ASSERT( assets[1], "Invalid quote asset symbol: ${s}", ("s",quote) );
+   _order_book_depth_subscriptions.erase( std::make_pair( assets[0]->id, assets[1]->id ) );
+}
+
+/** @return the levels of @ref current that differ from @ref previous, and the levels of @ref previous that are gone, with zero amounts */
+static vector<order> order_book_depth_delta( const vector<order>& previous, const vector<order>& current )
+{
+   vector<order> delta;
+   map<double, const order*> previous_by_price;
+   for( const auto& level : previous )
+      previous_by_price[level.price] = &level;
+   for( const auto& level : current )
+   {
+      auto itr = previous_by_price.find( level.price );
+      if( itr == previous_by_price.end() || itr->second->base != level.base || itr->second->quote != level.quote )
+         delta.push_back( level );
+      if( itr != previous_by_price.end() )
+         previous_by_price.erase( itr );
+   }
+   for( const auto& item : previous_by_price )
+      delta.push_back( order{ item.first, 0, 0 } );
+   return delta;
+}
+
+void database_api_impl::send_order_book_depth_updates()
+{
+   const auto& depth = dynamic_cast<const primary_index<limit_order_index>&>( _db.get_index_type<limit_order_index>() )
+                          .get_secondary_index<limit_order_depth_index>();
+
+   vector< pair< std::function<void(const variant&)>, order_book > > updates;
+   for( auto& item : _order_book_depth_subscriptions )
+   {
+      order_book_depth_subscription& sub = item.second;
+      const auto market = std::make_pair( std::min( item.first.first, item.first.second ), std::max( item.first.first, item.first.second ) );
+      const uint64_t revision = depth.get_revision( market );
+      if( revision == sub.revision )
+         continue;
+      sub.revision = revision;
+
+      order_book current = build_order_book_depth( item.first.first(_db), item.first.second(_db), sub.levels );
+      current.base = sub.last_sent.base;
+      current.quote = sub.last_sent.quote;
+      order_book delta;
+      delta.base = current.base;
+      delta.quote = current.quote;
+      delta.bids = order_book_depth_delta( sub.last_sent.bids, current.bids );
+      delta.asks = order_book_depth_delta( sub.last_sent.asks, current.asks );
+      sub.last_sent = std::move( current );
+
+      if( !delta.bids.empty() || !delta.asks.empty() )
+         updates.emplace_back( sub.callback, std::move( delta ) );
+   }
+
+   if( updates.size() )
+   {
+      auto capture_this = shared_from_this();
+      fc::async([capture_this,updates](){
+         for( const auto& update : updates )
+            update.first( fc::variant( update.second ) );
+      });
+   }
+}
+
 vector<market_trade> database_api::get_trade_history( const string& base,
                                                       const string& quote,
                                                       fc::time_point_sec start,
@@ -1348,48 +1560,38 @@ vector<market_trade> database_api_impl::get_trade_history( const string& base,
    auto quote_id = assets[1]->id;
 
    if( base_id > quote_id ) std::swap( base_id, quote_id );
-   const auto& history_idx = _db.get_index_type<graphene::market_history::history_index>().indices().get<by_key>();
-   history_key hkey;
-   hkey.base = base_id;
-   hkey.quote = quote_id;
-   hkey.sequence = std::numeric_limits<int64_t>::min();
+   const auto& history_idx = _db.get_index_type<graphene::market_history::history_index>().indices().get<graphene::market_history::by_market_time>();
 
    auto price_to_real = [&]( const share_type a, int p ) { return double( a.value ) / pow( 10, p ); };
 
    if ( start.sec_since_epoch() == 0 )
       start = fc::time_point_sec( fc::time_point::now() );
 
-   uint32_t count = 0;
-   auto itr = history_idx.lower_bound( hkey );
+   // newest first, starting with the last trade before start
+   auto itr = history_idx.upper_bound( boost::make_tuple( base_id, quote_id, true, start ) );
+   auto end = history_idx.upper_bound( boost::make_tuple( base_id, quote_id, true ) );
    vector<market_trade> result;
+   result.reserve( limit );
 
-   while( itr != history_idx.end() && count < limit && !( itr->key.base != base_id || itr->key.quote != quote_id || itr->time < stop ) )
+   for( ; itr != end && result.size() < limit && itr->time >= stop; ++itr )
    {
-      if( itr->time < start )
-      {
-         market_trade trade;
+      market_trade trade;
 
-         if( assets[0]->id == itr->op.receives.asset_id )
-         {
-            trade.amount = price_to_real( itr->op.pays.amount, assets[1]->precision );
-            trade.value = price_to_real( itr->op.receives.amount, assets[0]->precision );
-         }
-         else
-         {
-            trade.amount = price_to_real( itr->op.receives.amount, assets[1]->precision );
-            trade.value = price_to_real( itr->op.pays.amount, assets[0]->precision );
-         }
-
-         trade.date = itr->time;
-         trade.price = trade.value / trade.amount;
-
-         result.push_back( trade );
-         ++count;
+      if( assets[0]->id == itr->op.receives.asset_id )
+      {
+         trade.amount = price_to_real( itr->op.pays.amount, assets[1]->precision );
+         trade.value = price_to_real( itr->op.receives.amount, assets[0]->precision );
+      }
+      else
+      {
+         trade.amount = price_to_real( itr->op.receives.amount, assets[1]->precision );
+         trade.value = price_to_real( itr->op.pays.amount, assets[0]->precision );
       }
 
-      // Trades are tracked in each direction.
-      ++itr;
-      ++itr;
+      trade.date = itr->time;
+      trade.price = trade.value / trade.amount;
+
+      result.push_back( trade );
    }
 
    return result;
@@ -2110,7 +2312,7 @@ void database_api_impl::broadcast_market_updates( const market_queue_type& queue
 
 void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts)
 {
-   handle_object_changed(_notify_remove_create, false, ids, impacted_accounts,
+   handle_object_changed(false, ids,
       [objs](object_id_type id) -> const object* {
          auto it = std::find_if(
                objs.begin(), objs.end(),
@@ -2126,46 +2328,21 @@ void database_api_impl::on_objects_removed( const vector<object_id_type>& ids, c
 
 void database_api_impl::on_objects_new(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
 {
-   handle_object_changed(_notify_remove_create, true, ids, impacted_accounts,
+   handle_object_changed(true, ids,
       std::bind(&object_database::find_object, &_db, std::placeholders::_1)
    );
 }
 
 void database_api_impl::on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts)
 {
-   handle_object_changed(false, true, ids, impacted_accounts,
+   handle_object_changed(true, ids,
       std::bind(&object_database::find_object, &_db, std::placeholders::_1)
    );
 }
 
-void database_api_impl::handle_object_changed(bool force_notify, bool full_object, const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts, std::function<const object*(object_id_type id)> find_object)
+/** object subscriptions are served by the shared subscription_registry, only market subscriptions are handled here */
+void database_api_impl::handle_object_changed(bool full_object, const vector<object_id_type>& ids, std::function<const object*(object_id_type id)> find_object)
 {
-   if( _subscribe_callback )
-   {
-      vector<variant> updates;
-
-      for(auto id : ids)
-      {
-         if( force_notify || is_subscribed_to_item(id) || is_impacted_account(impacted_accounts) )
-         {
-            if( full_object )
-            {
-               auto obj = find_object(id);
-               if( obj )
-               {
-                  updates.emplace_back( obj->to_variant() );
-               }
-            }
-            else
-            {
-               updates.emplace_back( id );
-            }
-         }
-      }
-
-      broadcast_updates(updates);
-   }
-
    if( _market_subscriptions.size() )
    {
       market_queue_type broadcast_queue;
@@ -2200,6 +2377,9 @@ void database_api_impl::on_applied_block()
       });
    }
 
+   if( _order_book_depth_subscriptions.size() )
+      send_order_book_depth_updates();
+
    if(_market_subscriptions.size() == 0)
       return;
 
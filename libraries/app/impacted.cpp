@@ -253,6 +253,12 @@ struct get_impacted_account_visitor
       _impacted.insert( op.owner );
    }      
 
+   // bulk deflation covers whole id ranges, each owner is impacted by the virtual per-account and per-order
+   // deflation operations it emits
+   void operator()( const account_bulk_deflation_operation& op ) {}
+
+   void operator()( const order_bulk_deflation_operation& op ) {}
+
    void operator()( const construction_capital_create_operation& op ) 
    {
         _impacted.insert( op.account_id );
@@ -82,6 +82,19 @@ namespace graphene { namespace app {
       asset_id_type   asset_id;
       int             count;
    };
+   /** position in the holders of an asset, ordered by balance, of the last holder returned */
+   struct asset_holders_cursor
+   {
+      share_type      amount;
+      account_id_type account_id;
+   };
+   struct asset_holders_page
+   {
+      vector<account_asset_balance>  holders;
+      /** pass back to get the next page, unset after the last holder */
+      optional<asset_holders_cursor> next;
+      uint64_t                       total_holders = 0;
+   };
    
    /**
     * @brief The history_api class implements the RPC API for account history
@@ -169,6 +182,9 @@ namespace graphene { namespace app {
       block_api(graphene::chain::database& db);
       ~block_api();
 
+      /**
+       * @brief Get the blocks block_num_from to block_num_to, at most 1000 of them
+       */
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
 
    private:
@@ -268,6 +284,16 @@ namespace graphene { namespace app {
           */
          std::vector<net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Return the queue depth and rejection counters of the transaction admission threads
+          */
+         transaction_admission_stats get_transaction_admission_stats() const;
+
+         /**
+          * @brief Return how far each consumer of the block event queue is behind the head block
+          */
+         vector<block_event_queue::consumer_status> get_block_event_consumer_status() const;
+
       private:
          application& _app;
    };
@@ -323,6 +349,17 @@ namespace graphene { namespace app {
          int get_asset_holders_count( asset_id_type asset_id )const;
          vector<asset_holders> get_all_asset_holders() const;
 
+         /**
+          * @brief Get the holders of an asset, largest balance first, one page at a time
+          * @param asset_id The asset whose holders should be returned
+          * @param start Cursor returned with the previous page, or unset for the first page
+          * @param limit Maximum number of holders to return (must not exceed 1000)
+          * @return Holders after start, and the cursor of the next page if there are more
+          */
+         asset_holders_page get_asset_holders_page( asset_id_type asset_id,
+                                                    optional<asset_holders_cursor> start = optional<asset_holders_cursor>(),
+                                                    uint32_t limit = 100 )const;
+
       private:
          graphene::chain::database& _db;
    };
@@ -393,6 +430,8 @@ FC_REFLECT( graphene::app::verify_range_proof_rewind_result,
 
 FC_REFLECT( graphene::app::account_asset_balance, (name)(account_id)(amount) );
 FC_REFLECT( graphene::app::asset_holders, (asset_id)(count) );
+FC_REFLECT( graphene::app::asset_holders_cursor, (amount)(account_id) );
+FC_REFLECT( graphene::app::asset_holders_page, (holders)(next)(total_holders) );
 
 FC_API(graphene::app::history_api,
        (get_account_history)
@@ -418,6 +457,8 @@ FC_API(graphene::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_transaction_admission_stats)
+       (get_block_event_consumer_status)
      )
 FC_API(graphene::app::crypto_api,
        (blind_sign)
@@ -434,6 +475,7 @@ FC_API(graphene::app::asset_api,
        (get_asset_holders)
 	   (get_asset_holders_count)
        (get_all_asset_holders)
+       (get_asset_holders_page)
      )
 FC_API(graphene::app::login_api,
        (login)
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/full_account.hpp>
+#include <graphene/app/subscription_registry.hpp>
 
 #include <graphene/chain/protocol/types.hpp>
 
@@ -111,6 +112,23 @@ struct market_trade
    double                     value;
 };
 
+/** a page of consecutive blocks returned by database_api::get_block_range */
+struct block_range
+{
+   uint32_t             first_block_num = 0;
+   /// where the next page starts; equal to first_block_num if no block was returned
+   uint32_t             next_block_num = 0;
+   uint32_t             head_block_num = 0;
+   /// blocks up to this one can no longer be replaced by a fork
+   uint32_t             last_irreversible_block_num = 0;
+   /// if packed was requested, the blocks serialized with fc::raw::pack, one after another
+   vector<char>         packed_blocks;
+   /// the size of each block in packed_blocks
+   vector<uint32_t>     packed_block_sizes;
+   /// if packed was not requested, the blocks
+   vector<signed_block> blocks;
+};
+
 /**
  * @brief The database_api class implements the RPC API for the chain database.
  *
@@ -121,7 +139,11 @@ struct market_trade
 class database_api
 {
    public:
-      database_api(graphene::chain::database& db);
+      /**
+       * @param subscriptions registry shared with the other sessions of the application; a private one is created
+       * if none is given
+       */
+      database_api(graphene::chain::database& db, std::shared_ptr<subscription_registry> subscriptions = std::shared_ptr<subscription_registry>());
       ~database_api();
 
       /////////////
@@ -141,7 +163,7 @@ class database_api
       // Subscriptions //
       ///////////////////
 
-      void set_subscribe_callback( std::function<void(const variant&)> cb, bool clear_filter );
+      void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
       void set_pending_transaction_callback( std::function<void(const variant&)> cb );
       void set_block_applied_callback( std::function<void(const variant& block_id)> cb );
       /**
@@ -177,6 +199,29 @@ class database_api
        */
       optional<signed_block> get_block(uint32_t block_num)const;
 
+      /**
+       * @brief Retrieve a full, signed block serialized in binary form
+       * @param block_num Height of the block to be returned
+       * @return the referenced block as packed by fc::raw::pack, or null if no matching block was found
+       *
+       * This is cheaper for the node than @ref get_block, the block is returned as stored without being decoded.
+       */
+      optional<vector<char>> get_packed_block(uint32_t block_num)const;
+
+      /**
+       * @brief Get consecutive blocks starting at start, for clients reading the whole chain
+       * @param start Number of the first block, i.e. next_block_num of the previous page
+       * @param limit Maximum number of blocks to return (must not exceed 1000); fewer are returned at the head
+       *        block or when the page reaches @ref max_block_range_bytes, though at least one block is returned
+       *        if start is not past the head block
+       * @param packed Return the blocks serialized with fc::raw::pack rather than as objects, which saves
+       *        decoding them on the node
+       */
+      block_range get_block_range(uint32_t start, uint32_t limit, bool packed)const;
+
+      /// the size of the blocks get_block_range returns in one page
+      static const uint64_t max_block_range_bytes = 16 * 1024 * 1024;
+
       /**
        * @brief used to fetch an individual transaction.
        */
@@ -427,6 +472,13 @@ class database_api
        */
       market_ticker get_ticker( const string& base, const string& quote )const;
 
+      /**
+       * @brief Returns the tickers of several markets at once
+       * @param markets Pairs of base and quote asset symbols, capped at 100
+       * @return The market tickers for the past 24 hours, in the order of @ref markets
+       */
+      vector<market_ticker> get_tickers( const vector<std::pair<string,string>>& markets )const;
+
       /**
        * @brief Returns the 24 hour volume for the market assetA:assetB
        * @param a String name of the first asset
@@ -444,6 +496,36 @@ class database_api
        */
       order_book get_order_book( const string& base, const string& quote, unsigned limit = 50 )const;
 
+      /**
+       * @brief Returns the depth of the market base:quote, with the orders at each price added together
+       * @param base String name of the first asset
+       * @param quote String name of the second asset
+       * @param levels Number of price levels to return on each side, capped at 500. Prioritizes most moderate of each
+       * @return Order book of the market with one order per price level
+       */
+      order_book get_order_book_depth( const string& base, const string& quote, unsigned levels = 50 )const;
+
+      /**
+       * @brief Request notification when the depth of the market base:quote changes
+       * @param callback Callback method which is called after each block that changes the top levels of the book
+       * @param base String name of the first asset
+       * @param quote String name of the second asset
+       * @param levels Number of price levels to follow on each side, capped at 500
+       *
+       * The callback is first passed the current depth, as returned by @ref get_order_book_depth. After that it is
+       * passed an order_book holding only the levels that changed; a level with zero base and quote amounts has
+       * gone from the book.
+       */
+      void subscribe_to_order_book_depth( std::function<void(const variant&)> callback,
+                                          const string& base, const string& quote, unsigned levels = 50 );
+
+      /**
+       * @brief Unsubscribe from depth updates of the market base:quote
+       * @param base String name of the first asset
+       * @param quote String name of the second asset
+       */
+      void unsubscribe_from_order_book_depth( const string& base, const string& quote );
+
       /**
        * @brief Returns recent trades for the market assetA:assetB
        * Note: Currentlt, timezone offsets are not supported. The time must be UTC.
@@ -636,6 +718,9 @@ FC_REFLECT( graphene::app::order_book, (base)(quote)(bids)(asks) );
 FC_REFLECT( graphene::app::market_ticker, (base)(quote)(latest)(lowest_ask)(highest_bid)(percent_change)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_volume, (base)(quote)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_trade, (date)(price)(amount)(value) );
+FC_REFLECT( graphene::app::block_range,
+            (first_block_num)(next_block_num)(head_block_num)(last_irreversible_block_num)
+            (packed_blocks)(packed_block_sizes)(blocks) );
 
 FC_API(graphene::app::database_api,
    // Objects
@@ -651,6 +736,8 @@ FC_API(graphene::app::database_api,
    (get_block_header)
    (get_block_header_batch)
    (get_block)
+   (get_packed_block)
+   (get_block_range)
    (get_transaction)
    (get_recent_transaction_by_id)
    (get_transaction_by_id)
@@ -693,6 +780,9 @@ FC_API(graphene::app::database_api,
    // Markets / feeds
    (get_exchange_fee_rate)
    (get_order_book)
+   (get_order_book_depth)
+   (subscribe_to_order_book_depth)
+   (unsubscribe_from_order_book_depth)
    (get_limit_orders)
    (get_call_orders)
    (get_settle_orders)
@@ -700,6 +790,7 @@ FC_API(graphene::app::database_api,
    (subscribe_to_market)
    (unsubscribe_from_market)
    (get_ticker)
+   (get_tickers)
    (get_24_volume)
    (get_trade_history)
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/variant.hpp>
+
+#include <map>
+#include <memory>
+
+namespace graphene { namespace app {
+
+using namespace graphene::chain;
+
+/**
+ * @brief Receives the object notifications of one API session from a subscription_registry
+ */
+class subscription_session
+{
+   public:
+      virtual ~subscription_session(){}
+
+      /**
+       * Called with the objects of one notification the session subscribed to, as variants (or ids, for removed
+       * objects) shared with the other sessions.  It is called in the middle of applying a block and must not
+       * yield.
+       */
+      virtual void send_object_updates( const vector<variant>& updates ) = 0;
+};
+
+/**
+ * @brief The object subscriptions of all API sessions of a database
+ *
+ * Sessions subscribe to objects and accounts here rather than each following every change of the database.  For each
+ * notification of new, changed or removed objects the registry looks the interested sessions up in its reverse
+ * indexes, converts each object to a variant at most once, and hands the same variants to all of them.
+ *
+ * All methods must be called from the thread that applies blocks.
+ */
+class subscription_registry
+{
+   public:
+      explicit subscription_registry( graphene::chain::database& db );
+      ~subscription_registry();
+
+      /**
+       * Starts sending session the objects it subscribes to.
+       * @param notify_remove_create Also send the session every object created or removed
+       */
+      void add_session( subscription_session* session, bool notify_remove_create );
+      /// Stops sending session anything and drops its subscriptions
+      void remove_session( const subscription_session* session );
+
+      /**
+       * Sends session the object whenever it is created, changed or removed; ignored if session was not added.
+       * Sessions subscribe from their const getters, the registry only sends to the pointer given to add_session.
+       */
+      void subscribe_to_object( const subscription_session* session, object_id_type id );
+      /// Sends session every notification the account is impacted by; ignored if session was not added
+      void subscribe_to_account( const subscription_session* session, account_id_type id );
+
+      bool   is_subscribed_to_object( const subscription_session* session, object_id_type id )const;
+      size_t get_account_subscription_count( const subscription_session* session )const;
+      size_t get_session_count()const { return _sessions.size(); }
+
+   private:
+      struct session_subscriptions
+      {
+         subscription_session*     session = nullptr;
+         bool                      notify_remove_create = false;
+         flat_set<object_id_type>  objects;
+         flat_set<account_id_type> accounts;
+      };
+
+      void on_objects( bool removed_or_created, bool full_object, const vector<object_id_type>& ids,
+                       const flat_set<account_id_type>& impacted_accounts,
+                       const std::function<const object*(object_id_type)>& find_object );
+
+      graphene::chain::database&                                         _db;
+      std::map< const subscription_session*, session_subscriptions >     _sessions;
+      std::map< object_id_type, flat_set<const subscription_session*> >  _object_sessions;
+      std::map< account_id_type, flat_set<const subscription_session*> > _account_sessions;
+
+      boost::signals2::scoped_connection                                 _new_connection;
+      boost::signals2::scoped_connection                                 _change_connection;
+      boost::signals2::scoped_connection                                 _removed_connection;
+};
+
+} }
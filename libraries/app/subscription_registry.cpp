@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/subscription_registry.hpp>
+
+namespace graphene { namespace app {
+
+subscription_registry::subscription_registry( graphene::chain::database& db ) : _db(db)
+{
+   _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+      on_objects( true, true, ids, impacted_accounts,
+                  [this]( object_id_type id ) { return _db.find_object( id ); } );
+   });
+   _change_connection = _db.changed_objects.connect([this](const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts) {
+      on_objects( false, true, ids, impacted_accounts,
+                  [this]( object_id_type id ) { return _db.find_object( id ); } );
+   });
+   _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
+      on_objects( true, false, ids, impacted_accounts,
+                  []( object_id_type ) -> const object* { return nullptr; } );
+   });
+}
+
+subscription_registry::~subscription_registry() {}
+
+void subscription_registry::add_session( subscription_session* session, bool notify_remove_create )
+{
+   remove_session( session );
+   auto& subscriptions = _sessions[session];
+   subscriptions.session = session;
+   subscriptions.notify_remove_create = notify_remove_create;
+}
+
+void subscription_registry::remove_session( const subscription_session* session )
+{
+   auto itr = _sessions.find( session );
+   if( itr == _sessions.end() )
+      return;
+   for( const auto& id : itr->second.objects )
+   {
+      auto sessions = _object_sessions.find( id );
+      sessions->second.erase( session );
+      if( sessions->second.empty() )
+         _object_sessions.erase( sessions );
+   }
+   for( const auto& id : itr->second.accounts )
+   {
+      auto sessions = _account_sessions.find( id );
+      sessions->second.erase( session );
+      if( sessions->second.empty() )
+         _account_sessions.erase( sessions );
+   }
+   _sessions.erase( itr );
+}
+
+void subscription_registry::subscribe_to_object( const subscription_session* session, object_id_type id )
+{
+   auto itr = _sessions.find( session );
+   if( itr == _sessions.end() )
+      return;
+   if( itr->second.objects.insert( id ).second )
+      _object_sessions[id].insert( session );
+}
+
+void subscription_registry::subscribe_to_account( const subscription_session* session, account_id_type id )
+{
+   auto itr = _sessions.find( session );
+   if( itr == _sessions.end() )
+      return;
+   if( itr->second.accounts.insert( id ).second )
+      _account_sessions[id].insert( session );
+}
+
+bool subscription_registry::is_subscribed_to_object( const subscription_session* session, object_id_type id )const
+{
+   auto itr = _sessions.find( session );
+   return itr != _sessions.end() && itr->second.objects.count( id );
+}
+
+size_t subscription_registry::get_account_subscription_count( const subscription_session* session )const
+{
+   auto itr = _sessions.find( session );
+   return itr == _sessions.end() ? 0 : itr->second.accounts.size();
+}
+
+void subscription_registry::on_objects( bool removed_or_created, bool full_object, const vector<object_id_type>& ids,
+                                        const flat_set<account_id_type>& impacted_accounts,
+                                        const std::function<const object*(object_id_type)>& find_object )
+{
+   if( _sessions.empty() || ids.empty() )
+      return;
+
+   // sessions following an impacted account are sent every object of the notification
+   flat_set<const subscription_session*> all_objects_sessions;
+   for( const auto& account : impacted_accounts )
+   {
+      auto itr = _account_sessions.find( account );
+      if( itr != _account_sessions.end() )
+         all_objects_sessions.insert( itr->second.begin(), itr->second.end() );
+   }
+   if( removed_or_created )
+      for( const auto& item : _sessions )
+         if( item.second.notify_remove_create )
+            all_objects_sessions.insert( item.first );
+
+   std::map< const subscription_session*, vector<variant> > updates;
+   for( const auto& id : ids )
+   {
+      auto subscribed = _object_sessions.find( id );
+      if( all_objects_sessions.empty() && subscribed == _object_sessions.end() )
+         continue;
+
+      // converted once, the sessions share the variant's contents
+      variant value;
+      if( full_object )
+      {
+         const object* obj = find_object( id );
+         if( obj == nullptr )
+            continue;
+         value = obj->to_variant();
+      }
+      else
+         value = variant( id );
+
+      for( auto session : all_objects_sessions )
+         updates[session].push_back( value );
+      if( subscribed != _object_sessions.end() )
+         for( auto session : subscribed->second )
+            if( !all_objects_sessions.count( session ) )
+               updates[session].push_back( value );
+   }
+
+   for( const auto& item : updates )
+      _sessions[item.first].session->send_object_updates( item.second );
+}
+
+} }
@@ -267,4 +267,44 @@ void account_referrer_index::object_modified( const object& after  )
 {
 }
 
+void asset_holder_count_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( b.balance != 0 )
+      ++holder_count[b.asset_type];
+}
+void asset_holder_count_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_balance_object*>(&obj) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(obj);
+   if( b.balance != 0 && --holder_count[b.asset_type] == 0 )
+      holder_count.erase( b.asset_type );
+}
+void asset_holder_count_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const account_balance_object*>(&before) ); // for debug only
+   held_before_modify = static_cast<const account_balance_object&>(before).balance != 0;
+}
+void asset_holder_count_index::object_modified( const object& after  )
+{
+   assert( dynamic_cast<const account_balance_object*>(&after) ); // for debug only
+   const account_balance_object& b = static_cast<const account_balance_object&>(after);
+   const bool held_after_modify = b.balance != 0;
+   if( held_after_modify == held_before_modify )
+      return;
+   if( held_after_modify )
+      ++holder_count[b.asset_type];
+   else if( --holder_count[b.asset_type] == 0 )
+      holder_count.erase( b.asset_type );
+}
+
+uint64_t asset_holder_count_index::get_holder_count( asset_id_type asset_id )const
+{
+   auto itr = holder_count.find( asset_id );
+   if( itr == holder_count.end() )
+      return 0;
+   return itr->second;
+}
+
 } } // graphene::chain
@@ -28,17 +28,6 @@
 
 namespace graphene { namespace chain {
 
-struct index_entry
-{
-   uint64_t      block_pos = 0;
-   uint32_t      block_size = 0;
-   block_id_type block_id;
-};
- }}
-FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
-
-namespace graphene { namespace chain {
-
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
@@ -206,6 +195,68 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+optional<vector<char>> block_database::fetch_packed( const block_id_type& id )const
+{
+   try
+   {
+      index_entry e;
+      auto index_pos = sizeof(e)*block_header::num_from_id(id);
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      if ( _block_num_to_pos.tellg() <= index_pos )
+         return {};
+
+      _block_num_to_pos.seekg( index_pos );
+      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+
+      if( e.block_id != id || e.block_size == 0 ) return optional<vector<char>>();
+
+      vector<char> data( e.block_size );
+      _blocks.seekg( e.block_pos );
+      _blocks.read( data.data(), e.block_size );
+      FC_ASSERT( _blocks, "Block extends past the end of block_database (maybe corrupt on disk?)" );
+      return data;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   _blocks.clear();
+   return optional<vector<char>>();
+}
+
+optional<vector<char>> block_database::fetch_packed_by_number( uint32_t block_num )const
+{
+   try
+   {
+      index_entry e;
+      auto index_pos = sizeof(e)*block_num;
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      if ( _block_num_to_pos.tellg() <= index_pos )
+         return {};
+
+      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
+      _block_num_to_pos.read( (char*)&e, sizeof(e) );
+
+      if( e.block_size == 0 ) return optional<vector<char>>();
+
+      vector<char> data( e.block_size );
+      _blocks.seekg( e.block_pos );
+      _blocks.read( data.data(), e.block_size );
+      FC_ASSERT( _blocks, "Block extends past the end of block_database (maybe corrupt on disk?)" );
+      return data;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   _blocks.clear();
+   return optional<vector<char>>();
+}
+
 optional<signed_block> block_database::last()const
 {
    try
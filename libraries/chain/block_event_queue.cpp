@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/block_event_queue.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <chrono>
+
+namespace graphene { namespace chain {
+
+block_event_queue::block_event_queue( uint32_t max_queued )
+   : _max_queued( max_queued )
+{
+   FC_ASSERT( max_queued > 0 );
+}
+
+block_event_queue::~block_event_queue()
+{
+   while( !_consumers.empty() )
+      remove_consumer( _consumers.back()->name );
+}
+
+void block_event_queue::set_max_queued( uint32_t max_queued )
+{
+   FC_ASSERT( max_queued > 0 );
+   _max_queued = max_queued;
+}
+
+void block_event_queue::add_consumer( const string& name, handler_type handler )
+{
+   FC_ASSERT( find_consumer( name ) == nullptr, "Block event consumer ${n} already exists", ("n",name) );
+   std::unique_ptr<consumer> c( new consumer );
+   c->name = name;
+   c->handler = std::move( handler );
+   c->thread.reset( new fc::thread( "block_events_" + name ) );
+   c->last_block_num = 0;
+   _consumers.push_back( std::move( c ) );
+}
+
+void block_event_queue::remove_consumer( const string& name )
+{
+   for( auto itr = _consumers.begin(); itr != _consumers.end(); ++itr )
+   {
+      if( (*itr)->name != name )
+         continue;
+      wait_for_queued( **itr, 0 );
+      (*itr)->thread->quit();
+      _consumers.erase( itr );
+      return;
+   }
+}
+
+void block_event_queue::push( std::shared_ptr<const applied_block_event> event )
+{
+   _last_pushed_block_num = event->block_num;
+   for( auto& c : _consumers )
+   {
+      wait_for_queued( *c, _max_queued - 1 );
+      consumer* target = c.get();
+      auto done = std::make_shared< std::promise<void> >();
+      c->queued.push_back( done->get_future() );
+      c->thread->async( [target,event,done]()
+      {
+         try
+         {
+            target->handler( *event );
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Block event consumer ${n} failed to handle block ${b}: ${e}",
+                  ("n",target->name)("b",event->block_num)("e",e.to_detail_string()) );
+         }
+         catch( const std::exception& e )
+         {
+            elog( "Block event consumer ${n} failed to handle block ${b}: ${e}",
+                  ("n",target->name)("b",event->block_num)("e",e.what()) );
+         }
+         catch( ... )
+         {
+            elog( "Block event consumer ${n} failed to handle block ${b}",
+                  ("n",target->name)("b",event->block_num) );
+         }
+         target->last_block_num = event->block_num;
+         done->set_value();
+      }, "block_event" );
+   }
+}
+
+void block_event_queue::wait_until_handled( const string& name )
+{
+   consumer* c = find_consumer( name );
+   if( c != nullptr )
+      wait_for_queued( *c, 0 );
+}
+
+vector<block_event_queue::consumer_status> block_event_queue::get_consumer_status()const
+{
+   vector<consumer_status> result;
+   result.reserve( _consumers.size() );
+   for( const auto& c : _consumers )
+   {
+      consumer_status status;
+      status.name = c->name;
+      status.last_block_num = c->last_block_num;
+      status.head_block_num = _last_pushed_block_num;
+      for( const auto& f : c->queued )
+         if( f.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+            ++status.lag;
+      result.push_back( status );
+   }
+   return result;
+}
+
+block_event_queue::consumer* block_event_queue::find_consumer( const string& name )
+{
+   for( auto& c : _consumers )
+      if( c->name == name )
+         return c.get();
+   return nullptr;
+}
+
+void block_event_queue::wait_for_queued( consumer& c, size_t max_size )
+{
+   while( !c.queued.empty()
+          && ( c.queued.front().wait_for( std::chrono::seconds(0) ) == std::future_status::ready
+               || c.queued.size() > max_size ) )
+   {
+      // blocks the thread rather than yielding, since this runs while a block is applied; the handlers run on
+      // the consumer's own thread and catch their own errors, so this only waits
+      c.queued.front().wait();
+      c.queued.pop_front();
+   }
+}
+
+} }
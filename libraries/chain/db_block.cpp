@@ -38,6 +38,9 @@
 #include <graphene/chain/evaluator.hpp>
 
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <future>
 
 namespace graphene { namespace chain {
 
@@ -79,12 +82,47 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
    return optional<signed_block>();
 }
 
+optional<vector<char>> database::fetch_packed_block_by_id( const block_id_type& id )const
+{
+   auto b = _fork_db.fetch_block( id );
+   if( !b )
+      return _block_id_to_block.fetch_packed(id);
+   return fc::raw::pack( b->data );
+}
+
+optional<vector<char>> database::fetch_packed_block_by_number( uint32_t num )const
+{
+   auto results = _fork_db.fetch_block_by_number(num);
+   if( results.size() == 1 )
+      return fc::raw::pack( results[0]->data );
+   return _block_id_to_block.fetch_packed_by_number(num);
+}
+
+uint32_t database::fetch_packed_block_range( uint32_t first_block_num, uint32_t max_blocks, uint64_t max_bytes,
+                                             vector<char>& data, vector<uint32_t>& sizes )const
+{
+   const uint32_t head = head_block_num();
+   if( first_block_num == 0 || first_block_num > head )
+      return 0;
+   max_blocks = std::min( max_blocks, head - first_block_num + 1 );
+   return _block_id_to_block.fetch_packed_range( first_block_num, max_blocks, max_bytes, data, sizes );
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
-   auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
-   auto itr = index.find(trx_id);
-   FC_ASSERT(itr != index.end());
-   return itr->trx;
+   auto itr = _recent_transactions.find(trx_id);
+   FC_ASSERT(itr != _recent_transactions.end());
+   return itr->second;
+}
+
+void database::set_recent_transaction_cache_size( uint32_t size )
+{
+   _recent_transaction_cache_size = size;
+   while( _recent_transaction_order.size() > size )
+   {
+      _recent_transactions.erase( _recent_transaction_order.front() );
+      _recent_transaction_order.pop_front();
+   }
 }
 
 std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of_fork) const
@@ -120,13 +158,106 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
       detail::without_pending_transactions( *this, std::move(_pending_tx),
       [&]()
       {
-         result = _push_block(new_block);
+         if( !_signature_recovery_threads.empty() && !(skip & (skip_transaction_signatures | skip_authority_check)) )
+         {
+            precomputed_block precomputed = precompute_block( new_block, skip );
+            result = _push_block( new_block, &precomputed );
+         }
+         else
+            result = _push_block(new_block);
+
+         // pending transactions are only restored after this, so the state is exactly that of the head block
+         if( _flush_changes_interval.count() > 0 && fc::time_point::now() >= _next_flush_changes )
+         {
+            flush_changes();
+            _next_flush_changes = fc::time_point::now() + _flush_changes_interval;
+         }
       });
    });
    return result;
 }
 
+void database::set_signature_recovery_threads( uint32_t thread_count )
+{
+   _signature_recovery_threads.clear();
+   for( uint32_t i = 0; i < thread_count; ++i )
+      _signature_recovery_threads.emplace_back( new fc::thread( "sigrecover_" + fc::to_string( uint64_t( i ) ) ) );
+}
+
+precomputed_block database::precompute_block( const signed_block& b, uint32_t skip )const
+{
+   precomputed_block result;
+   result.source = &b;
+   result.id = b.id();
+   const auto& transactions = b.transactions;
+   result.trx_ids.resize( transactions.size() );
+   const bool recover = !_signature_recovery_threads.empty()
+                        && !(skip & (skip_transaction_signatures | skip_authority_check));
+   if( recover )
+      result.signees.resize( transactions.size() );
+
+   const chain_id_type& chain_id = get_chain_id();
+   auto compute = [&result,&transactions,&chain_id,recover]( size_t begin, size_t end )
+   {
+      for( size_t i = begin; i < end; ++i )
+      {
+         result.trx_ids[i] = transactions[i].id();
+         if( !recover )
+            continue;
+         try
+         {
+            result.signees[i] = transactions[i].get_signature_keys( chain_id );
+         }
+         catch( const fc::exception& )
+         {
+            // left unset, _apply_transaction() recovers again and reports the error
+         }
+      }
+   };
+   if( _signature_recovery_threads.empty() )
+   {
+      compute( 0, transactions.size() );
+      result.merkle_root = b.calculate_merkle_root();
+      return result;
+   }
+
+   // Each thread handles a contiguous slice of the transactions while this thread computes the merkle root.  This
+   // runs in the middle of pushing a block, so the wait must block this thread instead of yielding to other tasks
+   // on it, which could push transactions onto the half-pushed state.  fc futures yield, std futures block.
+   const size_t slice = ( transactions.size() + _signature_recovery_threads.size() - 1 ) / _signature_recovery_threads.size();
+   vector< std::promise<void> > done( _signature_recovery_threads.size() );
+   vector< std::future<void> > finished;
+   for( size_t t = 0; t < _signature_recovery_threads.size() && t * slice < transactions.size(); ++t )
+   {
+      finished.push_back( done[t].get_future() );
+      _signature_recovery_threads[t]->async( [&compute,&done,&transactions,slice,t]()
+      {
+         try
+         {
+            compute( t * slice, std::min( ( t + 1 ) * slice, transactions.size() ) );
+            done[t].set_value();
+         }
+         catch( ... )
+         {
+            done[t].set_exception( std::current_exception() );
+         }
+      }, "recover signatures" );
+   }
+   result.merkle_root = b.calculate_merkle_root();
+   // every slice must be finished before an error of one unwinds the result they write to
+   for( auto& f : finished )
+      f.wait();
+   for( auto& f : finished )
+      f.get();
+   return result;
+}
+
 bool database::_push_block(const signed_block& new_block)
+{
+   return _push_block( new_block, nullptr );
+}
+
+bool database::_push_block(const signed_block& new_block, const precomputed_block* precomputed)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
    if( !(skip&skip_fork_db) )
@@ -195,7 +326,10 @@ bool database::_push_block(const signed_block& new_block)
 
    try {
       auto session = _undo_db.start_undo_session();
-      apply_block(new_block, skip);
+      if( precomputed )
+         apply_block(*precomputed, skip);
+      else
+         apply_block(new_block, skip);
       _block_id_to_block.store(new_block.id(), new_block);
       session.commit();
    } catch ( const fc::exception& e ) {
@@ -226,6 +360,82 @@ processed_transaction database::push_transaction( const signed_transaction& trx,
    return result;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
+processed_transaction database::push_transaction( const precomputed_transaction& trx, uint32_t skip )
+{ try {
+   processed_transaction result;
+   detail::with_skip_flags( *this, skip, [&]()
+   {
+      FC_ASSERT( _precomputed_transaction == nullptr );
+      _precomputed_transaction = &trx;
+      try
+      {
+         result = _push_transaction( trx.trx );
+      }
+      catch( ... )
+      {
+         _precomputed_transaction = nullptr;
+         throw;
+      }
+      _precomputed_transaction = nullptr;
+   } );
+   return result;
+} FC_CAPTURE_AND_RETHROW( (trx.trx) ) }
+
+void database::set_transaction_admission( uint32_t thread_count, uint32_t queue_depth )
+{
+   FC_ASSERT( _admission_stats.queue_depth == 0, "transactions are being admitted" );
+   _transaction_admission_threads.clear();
+   for( uint32_t i = 0; i < thread_count; ++i )
+      _transaction_admission_threads.emplace_back( new fc::thread( "admission_" + fc::to_string( uint64_t( i ) ) ) );
+   _admission_stats.max_queue_depth = std::max( queue_depth, 1u );
+}
+
+processed_transaction database::admit_transaction( const signed_transaction& trx, uint32_t skip )
+{
+   if( _transaction_admission_threads.empty() )
+      return push_transaction( trx, skip );
+
+   // only tasks of this thread touch the counters, so they need no synchronization
+   if( _admission_stats.queue_depth >= _admission_stats.max_queue_depth )
+   {
+      ++_admission_stats.rejected_queue_full;
+      FC_THROW( "Transaction admission queue is full", ("queue_depth",_admission_stats.queue_depth) );
+   }
+   ++_admission_stats.queue_depth;
+
+   precomputed_transaction precomputed;
+   try
+   {
+      const chain_id_type chain_id = get_chain_id();
+      const bool recover = !(skip & (skip_transaction_signatures | skip_authority_check));
+      auto& thread = *_transaction_admission_threads[ _next_admission_thread++ % _transaction_admission_threads.size() ];
+      precomputed = thread.async( [&trx,&chain_id,recover]()
+      {
+         return precomputed_transaction( trx, chain_id, recover );
+      }, "admit transaction" ).wait();
+   }
+   catch( ... )
+   {
+      --_admission_stats.queue_depth;
+      ++_admission_stats.rejected_invalid;
+      throw;
+   }
+
+   try
+   {
+      auto result = push_transaction( precomputed, skip );
+      --_admission_stats.queue_depth;
+      ++_admission_stats.admitted;
+      return result;
+   }
+   catch( ... )
+   {
+      --_admission_stats.queue_depth;
+      ++_admission_stats.rejected_apply;
+      throw;
+   }
+}
+
 processed_transaction database::_push_transaction( const signed_transaction& trx )
 {
    // If this is the first transaction pushed after applying a block, start a new undo session.
@@ -506,7 +716,10 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
    {
       auto itr = _checkpoints.find( block_num );
       if( itr != _checkpoints.end() )
-         FC_ASSERT( next_block.id() == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block.id()) );
+      {
+         const block_id_type next_block_id = applying_block_id( next_block );
+         FC_ASSERT( next_block_id == itr->second, "Block did not match checkpoint", ("checkpoint",*itr)("block_id",next_block_id) );
+      }
 
       if( _checkpoints.rbegin()->first >= block_num )
          skip = ~0;// WE CAN SKIP ALMOST EVERYTHING
@@ -519,13 +732,39 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
    return;
 }
 
+void database::apply_block( const precomputed_block& next_block, uint32_t skip )
+{
+   FC_ASSERT( _precomputed_block == nullptr );
+   _precomputed_block = &next_block;
+   try
+   {
+      apply_block( next_block.get_block(), skip );
+   }
+   catch( ... )
+   {
+      _precomputed_block = nullptr;
+      throw;
+   }
+   _precomputed_block = nullptr;
+}
+
+block_id_type database::applying_block_id( const signed_block& next_block )const
+{
+   if( _precomputed_block && &_precomputed_block->get_block() == &next_block )
+      return _precomputed_block->id;
+   return next_block.id();
+}
+
 void database::_apply_block( const signed_block& next_block )
 { try {
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
+   _applied_trx_ids.clear();
+   _applied_trx_ids.reserve( next_block.transactions.size() );
 
-   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
+   FC_ASSERT( (skip & skip_merkle_check) || next_block.transaction_merkle_root ==
+              ( _precomputed_block ? _precomputed_block->merkle_root : next_block.calculate_merkle_root() ), "", ("next_block.transaction_merkle_root",next_block.transaction_merkle_root)("calc",next_block.calculate_merkle_root())("next_block",next_block)("id",next_block.id()) );
 
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
@@ -544,10 +783,12 @@ void database::_apply_block( const signed_block& next_block )
        * when building a block.
        */
       apply_transaction( trx, skip );
+      _applied_trx_ids.push_back( _current_trx_id );
       ++_current_trx_in_block;
    }
 
-   update_global_dynamic_data(next_block);
+   const block_id_type next_block_id = applying_block_id( next_block );
+   update_global_dynamic_data(next_block, next_block_id);
    update_signing_witness(signing_witness, next_block);
    update_last_irreversible_block();
 
@@ -555,7 +796,7 @@ void database::_apply_block( const signed_block& next_block )
    if( maint_needed )
       perform_chain_maintenance(next_block, global_props);
 
-   create_block_summary(next_block);
+   create_block_summary(next_block, next_block_id);
    clear_expired_transactions();
    clear_expired_proposals();
    clear_expired_orders();
@@ -574,6 +815,8 @@ void database::_apply_block( const signed_block& next_block )
 
    // notify observers that the block has been applied
    applied_block( next_block ); //emit
+   if( _block_events.has_consumers() )
+      push_block_event( next_block );
    _applied_ops.clear();
 
    notify_changed_objects();
@@ -595,12 +838,20 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
 { try {
    uint32_t skip = get_node_properties().skip_flags;
 
-   if( true || !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
+   // a precomputed transaction has been validated by admit_transaction()
+   const precomputed_transaction* precomputed_trx =
+      ( _precomputed_transaction && &trx == &_precomputed_transaction->trx ) ? _precomputed_transaction : nullptr;
+   if( precomputed_trx == nullptr && ( true || !(skip&skip_validate) ) )   /* issue #505 explains why this skip_flag is disabled */
       trx.validate();
 
    auto& trx_idx = get_mutable_index_type<transaction_index>();
    const chain_id_type& chain_id = get_chain_id();
-   auto trx_id = trx.id();
+   // use the values computed ahead of time if trx is part of the precomputed block being applied
+   const bool precomputed = _precomputed_block && _current_trx_in_block < _precomputed_block->trx_ids.size()
+                            && &trx == &_precomputed_block->get_block().transactions[_current_trx_in_block];
+   auto trx_id = precomputed ? _precomputed_block->trx_ids[_current_trx_in_block]
+                             : precomputed_trx ? precomputed_trx->id : trx.id();
+   _current_trx_id = trx_id;
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end() );
    transaction_evaluation_state eval_state(this);
@@ -611,7 +862,15 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       auto get_active = [&]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [&]( account_id_type id ) { return &id(*this).owner;  };
-      trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      if( precomputed && _current_trx_in_block < _precomputed_block->signees.size()
+          && _precomputed_block->signees[_current_trx_in_block].valid() )
+         graphene::chain::verify_authority( trx.operations, *_precomputed_block->signees[_current_trx_in_block],
+                                            get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      else if( precomputed_trx && precomputed_trx->signees.valid() )
+         graphene::chain::verify_authority( trx.operations, *precomputed_trx->signees,
+                                            get_active, get_owner, get_global_properties().parameters.max_authority_depth );
+      else
+         trx.verify_authority( chain_id, get_active, get_owner, get_global_properties().parameters.max_authority_depth );
    }
 
    //Skip all manner of expiration and TaPoS checking if we're on block 1; It's impossible that the transaction is
@@ -638,7 +897,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    {
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
-         transaction.trx = trx;
+         transaction.expiration = trx.expiration;
       });
    }
 
@@ -659,6 +918,19 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
    auto range = index.equal_range( boost::make_tuple( GRAPHENE_TEMP_ACCOUNT ) );
    std::for_each(range.first, range.second, [](const account_balance_object& b) { FC_ASSERT(b.balance == 0); });
 
+   // only once the transaction has applied, a failed one is not a valid answer; the cache is not undone with the
+   // block, a transaction that was popped stays a valid answer
+   if( !(skip & skip_transaction_dupe_check) && _recent_transaction_cache_size > 0
+       && _recent_transactions.emplace( trx_id, trx ).second )
+   {
+      _recent_transaction_order.push_back( trx_id );
+      if( _recent_transaction_order.size() > _recent_transaction_cache_size )
+      {
+         _recent_transactions.erase( _recent_transaction_order.front() );
+         _recent_transaction_order.pop_front();
+      }
+   }
+
    return ptrx;
 } FC_CAPTURE_AND_RETHROW( (trx) ) }
 
@@ -702,11 +974,11 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    return witness;
 }
 
-void database::create_block_summary(const signed_block& next_block)
+void database::create_block_summary(const signed_block& next_block, const block_id_type& next_block_id)
 {
    block_summary_id_type sid(next_block.block_num() & 0xffff );
    modify( sid(*this), [&](block_summary_object& p) {
-         p.block_id = next_block.id();
+         p.block_id = next_block_id;
    });
 }
 
@@ -26,6 +26,7 @@
 #include <graphene/chain/protocol/deflation.hpp>
 #include <graphene/chain/deflation_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/hardfork.hpp>
 
 using namespace fc;
 
@@ -46,27 +47,83 @@ namespace graphene { namespace chain {
             return tx;
         }
 
+        if (head_block_time() >= HARDFORK_BULK_DEFLATION_TIME) {
+            generate_bulk_deflation_operations(*dlft_it, tx);
+        } else {
+            generate_deflation_operations(*dlft_it, tx);
+        }
+
+        //set tx params
+        auto dyn_props = get_dynamic_global_properties();
+        tx.set_reference_block(dyn_props.head_block_id);
+        tx.set_expiration( dyn_props.time + fc::seconds(30) );
+        return tx;
+    }
+
+    void database::generate_bulk_deflation_operations(const deflation_object &dflt, signed_transaction &tx) {
+        if (!dflt.order_cleared) {
+            order_bulk_deflation_operation op;
+            op.deflation_id = dflt.id;
+            op.first = dflt.order_cursor;
+            if (dflt.last_order < dflt.order_cursor) {
+                // last_order was removed before the cursor reached it, the operation only clears order deflation
+                op.last = dflt.order_cursor;
+            } else {
+                // the range ends at the last of the next GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION orders
+                const auto &order_idx = get_index_type<limit_order_index>().indices().get<by_id>();
+                auto order_it = order_idx.lower_bound(dflt.order_cursor);
+                op.last = dflt.last_order;
+                for (uint32_t i = 0; order_it != order_idx.end() && limit_order_id_type(order_it->id) < dflt.last_order; ++order_it) {
+                    if (++i == GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION) {
+                        op.last = order_it->id;
+                        break;
+                    }
+                }
+            }
+            tx.operations.push_back(op);
+        }
+
+        if (!dflt.balance_cleared) {
+            account_bulk_deflation_operation op;
+            op.deflation_id = dflt.id;
+            op.first = dflt.account_cursor;
+            op.last = std::min(dflt.last_account, dflt.account_cursor + (GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION - 1));
+            tx.operations.push_back(op);
+        }
+
+        ilog("bulk deflation running: ${id}, account_cursor:${account_cursor}, last_account:${last_account}, "
+                "order_cursor:${order_cursor}, last_order:${last_order}, total:${total_amount}",
+            ("id", dflt.id)
+            ("account_cursor", dflt.account_cursor)
+            ("last_account", dflt.last_account)
+            ("order_cursor", dflt.order_cursor)
+            ("last_order", dflt.last_order)
+            ("total_amount", dflt.total_amount)
+        );
+    }
+
+    void database::generate_deflation_operations(const deflation_object &dflt, signed_transaction &tx) {
         int op_cnt = 0;
-        if (!dlft_it->order_cleared) {
+        if (!dflt.order_cleared) {
             // do order deflation
             const auto &order_dflt_idx = get_index_type<order_deflation_index>().indices().get<by_order>();
             const auto &order_idx = get_index_type<limit_order_index>().indices().get<by_id>();
-            auto order_it = order_idx.lower_bound(dlft_it->order_cursor);
-            if (order_it == order_idx.end() || limit_order_id_type(order_it->id) > dlft_it->last_order) {
+            auto order_it = order_idx.lower_bound(dflt.order_cursor);
+            if (order_it == order_idx.end() || limit_order_id_type(order_it->id) > dflt.last_order) {
                 // this check is necessary for last_order may be cleared by now
                 ilog("deflation: last_order has been passed.");
-                modify(*dlft_it, [&](deflation_object &obj){
+                modify(dflt, [&](deflation_object &obj){
                     obj.order_cleared = true;
                 });
             } else {
                 for (; op_cnt < GRAPHENE_DEFAULT_MAX_DEFLATION_OPERATIONS_PER_BLOCK 
                             && order_it != order_idx.end()
-                            && (limit_order_id_type(order_it->id) < dlft_it->last_order
-                                || limit_order_id_type(order_it->id) == dlft_it->last_order); 
+                            && (limit_order_id_type(order_it->id) < dflt.last_order
+                                || limit_order_id_type(order_it->id) == dflt.last_order); 
                         ++order_it) {
                     op_cnt += 1;
                     order_deflation_operation op;
-                    op.deflation_id = dlft_it->id;
+                    op.deflation_id = dflt.id;
                     op.order = order_it->id;
                     // owner & amount only for history
                     op.owner = order_it->seller;
@@ -75,7 +132,7 @@ namespace graphene { namespace chain {
                         if (order_dflt_it != order_dflt_idx.end() && order_dflt_it->cleared) {
                             op.amount = order_dflt_it->frozen;
                         } else {
-                            uint128_t amount = uint128_t(order_it->for_sale.value) * dlft_it->rate / GRAPHENE_DEFLATION_RATE_SCALE;
+                            uint128_t amount = uint128_t(order_it->for_sale.value) * dflt.rate / GRAPHENE_DEFLATION_RATE_SCALE;
                             op.amount = int64_t(amount.to_uint64());
                         }
                     } else {
@@ -86,27 +143,27 @@ namespace graphene { namespace chain {
             }
         }
 
-        if (!dlft_it->balance_cleared && op_cnt < GRAPHENE_DEFAULT_MAX_DEFLATION_OPERATIONS_PER_BLOCK) {
+        if (!dflt.balance_cleared && op_cnt < GRAPHENE_DEFAULT_MAX_DEFLATION_OPERATIONS_PER_BLOCK) {
             // do account balance deflation
             const auto &acc_dflt_idx = get_index_type<account_deflation_index>().indices().get<by_owner>();
             const auto &acc_idx = get_index_type<account_index>().indices().get<by_id>();
-            for ( auto acc_it = acc_idx.find(dlft_it->account_cursor); 
+            for ( auto acc_it = acc_idx.find(dflt.account_cursor); 
                     op_cnt < GRAPHENE_DEFAULT_MAX_DEFLATION_OPERATIONS_PER_BLOCK 
                         && acc_it != acc_idx.end() 
-                        && ( account_id_type(acc_it->id) < dlft_it->last_account 
-                            || account_id_type(acc_it->id) == dlft_it->last_account
+                        && ( account_id_type(acc_it->id) < dflt.last_account 
+                            || account_id_type(acc_it->id) == dflt.last_account
                     ); 
                     ++acc_it ) {
                 op_cnt += 1;
                 account_deflation_operation op;
-                op.deflation_id = dlft_it->id;
+                op.deflation_id = dflt.id;
                 op.owner = acc_it->id;
 
                 const auto &acc_dflt_it = acc_dflt_idx.find(acc_it->id);
                 if (acc_dflt_it != acc_dflt_idx.end() && acc_dflt_it->cleared) {
                     op.amount = acc_dflt_it->frozen;
                 } else {
-                    uint128_t amount = uint128_t(get_balance(op.owner, asset_id_type(0)).amount.value)* dlft_it->rate / GRAPHENE_DEFLATION_RATE_SCALE;
+                    uint128_t amount = uint128_t(get_balance(op.owner, asset_id_type(0)).amount.value)* dflt.rate / GRAPHENE_DEFLATION_RATE_SCALE;
                     op.amount = int64_t(amount.to_uint64());
                 }
                 tx.operations.push_back(op);
@@ -118,21 +175,15 @@ namespace graphene { namespace chain {
                 "order_cursor:${order_cursor}, last_order:${last_order}, order_cleared:${order_cleared}, "
                 "total:${total_amount}", 
             ("op_cnt", op_cnt)
-            ("id", dlft_it->id)
-            ("account_cursor", dlft_it->account_cursor)
-            ("last_account", dlft_it->last_account)
-            ("balance_cleared", dlft_it->balance_cleared)
-            ("order_cursor", dlft_it->order_cursor)
-            ("last_order", dlft_it->last_order)
-            ("order_cleared", dlft_it->order_cleared)
-            ("total_amount", dlft_it->total_amount)
+            ("id", dflt.id)
+            ("account_cursor", dflt.account_cursor)
+            ("last_account", dflt.last_account)
+            ("balance_cleared", dflt.balance_cleared)
+            ("order_cursor", dflt.order_cursor)
+            ("last_order", dflt.last_order)
+            ("order_cleared", dflt.order_cleared)
+            ("total_amount", dflt.total_amount)
         );
-
-        //set tx params
-        auto dyn_props = get_dynamic_global_properties();
-        tx.set_reference_block(dyn_props.head_block_id);
-        tx.set_expiration( dyn_props.time + fc::seconds(30) );
-        return tx;
     }
 
     processed_transaction database::apply_deflation(const processed_transaction &tx) {
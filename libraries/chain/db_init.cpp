@@ -198,6 +198,8 @@ void database::initialize_evaluators()
    register_evaluator<deflation_evaluator>();
    register_evaluator<account_deflation_evaluator>();
    register_evaluator<order_deflation_evaluator>();
+   register_evaluator<account_bulk_deflation_evaluator>();
+   register_evaluator<order_bulk_deflation_evaluator>();
 }
 
 void database::initialize_indexes()
@@ -215,7 +217,8 @@ void database::initialize_indexes()
 
    add_index< primary_index<committee_member_index> >();
    add_index< primary_index<witness_index> >();
-   add_index< primary_index<limit_order_index > >();
+   auto limit_order_idx = add_index< primary_index<limit_order_index > >();
+   limit_order_idx->add_secondary_index<limit_order_depth_index>();
    add_index< primary_index<call_order_index > >();
 
    auto prop_index = add_index< primary_index<proposal_index > >();
@@ -233,7 +236,8 @@ void database::initialize_indexes()
 
    //Implementation object indexes
    add_index< primary_index<transaction_index                             > >();
-   add_index< primary_index<account_balance_index                         > >();
+   auto bal_index = add_index< primary_index<account_balance_index        > >();
+   bal_index->add_secondary_index<asset_holder_count_index>();
    add_index< primary_index<asset_bitasset_data_index                     > >();
    add_index< primary_index<simple_index<global_property_object          >> >();
    add_index< primary_index<simple_index<dynamic_global_property_object  >> >();
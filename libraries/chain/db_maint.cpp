@@ -25,6 +25,7 @@
 #include <boost/multiprecision/integer.hpp>
 
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
 #include <fc/uint128.hpp>
 
 #include <graphene/chain/database.hpp>
@@ -51,6 +52,8 @@
 // #include <fc/real128.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include <future>
+
 #define CC_VOTE_START_TIME "20171214T000000"
 #define CC_SECOND_VOTE_START_TIME "20180301T000000"
 
@@ -98,6 +101,89 @@ void database::perform_account_maintenance(std::tuple<Types...> helpers)
       detail::for_each(helpers, a, detail::gen_seq<sizeof...(Types)>());
 }
 
+void database::set_maintenance_threads( uint32_t thread_count )
+{
+   _maintenance_threads.clear();
+   for( uint32_t i = 0; i < thread_count; ++i )
+      _maintenance_threads.emplace_back( new fc::thread( "maintenance_" + fc::to_string( uint64_t( i ) ) ) );
+}
+
+template<class TallyHelper, class FeeHelper>
+void database::perform_sharded_account_maintenance(TallyHelper& tally_helper, FeeHelper& fee_helper)
+{
+   const auto& idx = get_index_type<account_index>().indices().get<by_name>();
+   vector<const account_object*> accounts;
+   accounts.reserve(idx.size());
+   for( const account_object& a : idx )
+      accounts.push_back(&a);
+
+   // tally the stake every account has before any fees are processed, each thread taking a contiguous range of
+   // accounts into its own buffers
+   vector<uint64_t> stakes(accounts.size());
+   const size_t shard_size = (accounts.size() + _maintenance_threads.size() - 1) / _maintenance_threads.size();
+   vector<TallyHelper> shards;
+   for( size_t t = 0; t < _maintenance_threads.size() && t * shard_size < accounts.size(); ++t )
+      shards.push_back(tally_helper);
+   // This runs in the middle of applying a block, so the wait must block this thread instead of yielding to other
+   // tasks on it, which could push transactions onto the half-applied state.  fc futures yield, std futures block.
+   vector< std::promise<void> > done(shards.size());
+   vector< std::future<void> > finished;
+   for( size_t t = 0; t < shards.size(); ++t )
+   {
+      finished.push_back( done[t].get_future() );
+      _maintenance_threads[t]->async( [&accounts,&stakes,&shards,&done,shard_size,t]()
+      {
+         try
+         {
+            TallyHelper& shard = shards[t];
+            const size_t end = std::min((t + 1) * shard_size, accounts.size());
+            for( size_t i = t * shard_size; i < end; ++i )
+            {
+               if( !shard.counts(*accounts[i]) )
+                  continue;
+               stakes[i] = shard.get_voting_stake(*accounts[i]);
+               shard.add(*accounts[i], stakes[i]);
+            }
+            done[t].set_value();
+         }
+         catch( ... )
+         {
+            done[t].set_exception( std::current_exception() );
+         }
+      }, "tally votes" );
+   }
+   // every shard must be finished before an error of one unwinds the buffers they use
+   for( auto& f : finished )
+      f.wait();
+   for( auto& f : finished )
+      f.get();
+   for( const auto& shard : shards )
+      tally_helper.merge(shard);
+
+   // Fees are processed serially in name order.  The serial pass tallies each account just before its own fees, so
+   // the cashback that fees of earlier accounts deposit to later ones is part of their stake; correct the stake of
+   // such accounts before their turn.
+   flat_set<account_id_type> cashback_recipients;
+   for( size_t i = 0; i < accounts.size(); ++i )
+   {
+      const account_object& a = *accounts[i];
+      if( cashback_recipients.find(a.id) != cashback_recipients.end() && tally_helper.counts(a) )
+      {
+         const uint64_t stake = tally_helper.get_voting_stake(a);
+         if( stake != stakes[i] )
+            tally_helper.add(a, stake - stakes[i]);
+      }
+      const auto& stats = a.statistics(*this);
+      if( stats.pending_fees > 0 || stats.pending_vested_fees > 0 )
+      {
+         cashback_recipients.insert(a.lifetime_referrer);
+         cashback_recipients.insert(a.referrer);
+         cashback_recipients.insert(a.registrar);
+      }
+      fee_helper(a);
+   }
+}
+
 /// @brief A visitor for @ref worker_type which calls pay_worker on the worker within
 struct worker_pay_visitor
 {
@@ -846,64 +932,87 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       database& d;
       const global_property_object& props;
 
+      vector<uint64_t> vote_tally;
+      vector<uint64_t> witness_count_histogram;
+      vector<uint64_t> committee_count_histogram;
+      uint64_t         total_voting_stake = 0;
+
       vote_tally_helper(database& d, const global_property_object& gpo)
          : d(d), props(gpo)
       {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._total_voting_stake = 0;
+         vote_tally.resize(props.next_available_vote_id);
+         witness_count_histogram.resize(props.parameters.maximum_witness_count / 2 + 1);
+         committee_count_histogram.resize(props.parameters.maximum_committee_count / 2 + 1);
+      }
+
+      bool counts(const account_object& stake_account)const {
+         return props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time());
+      }
+
+      uint64_t get_voting_stake(const account_object& stake_account)const {
+         const auto& stats = stake_account.statistics(d);
+         return stats.total_core_in_orders.value
+               + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
+               + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
       }
 
       void operator()(const account_object& stake_account) {
-         if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
-         {
-            // There may be a difference between the account whose stake is voting and the one specifying opinions.
-            // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
-            // specifying the opinions.
-            const account_object& opinion_account =
-                  (stake_account.options.voting_account ==
-                   GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
-                                     : d.get(stake_account.options.voting_account);
-
-            const auto& stats = stake_account.statistics(d);
-            uint64_t voting_stake = stats.total_core_in_orders.value
-                  + (stake_account.cashback_vb.valid() ? (*stake_account.cashback_vb)(d).balance.amount.value: 0)
-                  + d.get_balance(stake_account.get_id(), asset_id_type()).amount.value;
-
-            for( vote_id_type id : opinion_account.options.votes )
-            {
-               uint32_t offset = id.instance();
-               // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
-            }
+         if( counts(stake_account) )
+            add(stake_account, get_voting_stake(stake_account));
+      }
 
-            if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_witness_count
-               // are turned into votes for maximum_witness_count.
-               //
-               // in particular, this takes care of the case where a
-               // member was voting for a high number, then the
-               // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
-            }
-            if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
-            {
-               uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
-               // votes for a number greater than maximum_committee_count
-               // are turned into votes for maximum_committee_count.
-               //
-               // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
-            }
+      /// Sums are taken modulo 2^64, so adding the difference between two stakes of an account replaces one with the other
+      void add(const account_object& stake_account, uint64_t voting_stake) {
+         // There may be a difference between the account whose stake is voting and the one specifying opinions.
+         // Usually they're the same, but if the stake account has specified a voting_account, that account is the one
+         // specifying the opinions.
+         const account_object& opinion_account =
+               (stake_account.options.voting_account ==
+                GRAPHENE_PROXY_TO_SELF_ACCOUNT)? stake_account
+                                  : d.get(stake_account.options.voting_account);
+
+         for( vote_id_type id : opinion_account.options.votes )
+         {
+            uint32_t offset = id.instance();
+            // if they somehow managed to specify an illegal offset, ignore it.
+            if( offset < vote_tally.size() )
+               vote_tally[offset] += voting_stake;
+         }
 
-            d._total_voting_stake += voting_stake;
+         if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
+                                       witness_count_histogram.size() - 1);
+            // votes for a number greater than maximum_witness_count
+            // are turned into votes for maximum_witness_count.
+            //
+            // in particular, this takes care of the case where a
+            // member was voting for a high number, then the
+            // parameter was lowered.
+            witness_count_histogram[offset] += voting_stake;
+         }
+         if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
+         {
+            uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
+                                       committee_count_histogram.size() - 1);
+            // votes for a number greater than maximum_committee_count
+            // are turned into votes for maximum_committee_count.
+            //
+            // same rationale as for witnesses
+            committee_count_histogram[offset] += voting_stake;
          }
+
+         total_voting_stake += voting_stake;
+      }
+
+      void merge(const vote_tally_helper& other) {
+         for( size_t i = 0; i < vote_tally.size(); ++i )
+            vote_tally[i] += other.vote_tally[i];
+         for( size_t i = 0; i < witness_count_histogram.size(); ++i )
+            witness_count_histogram[i] += other.witness_count_histogram[i];
+         for( size_t i = 0; i < committee_count_histogram.size(); ++i )
+            committee_count_histogram[i] += other.committee_count_histogram[i];
+         total_voting_stake += other.total_voting_stake;
       }
    } tally_helper(*this, gpo);
    struct process_fees_helper {
@@ -918,10 +1027,18 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
    } fee_helper(*this, gpo);
 
-   perform_account_maintenance(std::tie(
-      tally_helper,
-      fee_helper
-      ));
+   if( _maintenance_threads.empty() )
+      perform_account_maintenance(std::tie(
+         tally_helper,
+         fee_helper
+         ));
+   else
+      perform_sharded_account_maintenance(tally_helper, fee_helper);
+
+   _vote_tally_buffer = std::move(tally_helper.vote_tally);
+   _witness_count_histogram_buffer = std::move(tally_helper.witness_count_histogram);
+   _committee_count_histogram_buffer = std::move(tally_helper.committee_count_histogram);
+   _total_voting_stake = tally_helper.total_voting_stake;
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
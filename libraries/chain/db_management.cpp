@@ -28,7 +28,10 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/thread.hpp>
 
+#include <atomic>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -46,6 +49,62 @@ database::~database()
    clear_pending();
 }
 
+namespace {
+   /// checks skipped when applying blocks from our own block log
+   const uint32_t replay_skip_flags = database::skip_witness_signature |
+                                      database::skip_transaction_signatures |
+                                      database::skip_transaction_dupe_check |
+                                      database::skip_tapos_check |
+                                      database::skip_witness_schedule_check |
+                                      database::skip_authority_check;
+
+   /// a block read, unpacked and hashed by a replay worker thread
+   struct prefetched_block
+   {
+      optional<precomputed_block> block;
+      fc::time_point              ready;
+   };
+}
+
+void database::set_flush_changes_interval( uint32_t seconds )
+{
+   _flush_changes_interval = fc::seconds( seconds );
+   _next_flush_changes = fc::time_point::now() + _flush_changes_interval;
+}
+
+namespace {
+   fc::path resume_point_file( const fc::path& data_dir )
+   {
+      return data_dir / "object_database" / "resume_point";
+   }
+}
+
+void database::flush_changes()
+{
+   const fc::path resume_point = resume_point_file( get_data_dir() );
+   const fc::path tmp = get_data_dir() / "object_database" / "resume_point.tmp";
+   // the state on disk is not a valid resume point while it is being written
+   fc::remove_all( resume_point );
+   object_database::flush_changes();
+   {
+      std::ofstream out( tmp.generic_string(), std::ofstream::out | std::ofstream::trunc );
+      FC_ASSERT( out );
+      out << head_block_num() << ' ' << head_block_id().str();
+   }
+   fc::rename( tmp, resume_point );
+}
+
+bool database::has_resume_point( const fc::path& data_dir )
+{
+   return has_snapshot( data_dir ) && fc::exists( resume_point_file( data_dir ) );
+}
+
+void database::set_replay_pipeline( uint32_t worker_threads, uint32_t queue_depth )
+{
+   _replay_worker_threads = worker_threads;
+   _replay_queue_depth = std::max( queue_depth, 1u );
+}
+
 void database::reindex(fc::path data_dir, const genesis_state_type& initial_allocation)
 { try {
    ilog( "reindexing blockchain" );
@@ -61,42 +120,134 @@ void database::reindex(fc::path data_dir, const genesis_state_type& initial_allo
    }
 
    const auto last_block_num = last_block->block_num();
+   const uint32_t skip = replay_skip_flags;
+
+   auto drop_blocks_after_gap = [&]( uint32_t i )
+   {
+      wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
+      uint32_t dropped_count = 0;
+      while( true )
+      {
+         fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
+         // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
+         if( !last_id.valid() )
+            break;
+         // we've caught up to the gap
+         if( block_header::num_from_id( *last_id ) <= i )
+            break;
+         _block_id_to_block.remove( *last_id );
+         dropped_count++;
+      }
+      wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
+   };
 
    ilog( "Replaying blocks..." );
    _undo_db.disable();
-   for( uint32_t i = 1; i <= last_block_num; ++i )
+   if( _replay_worker_threads == 0 )
    {
-      if( i % 10000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
-      if( !block.valid() )
+      for( uint32_t i = 1; i <= last_block_num; ++i )
       {
-         wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
-         uint32_t dropped_count = 0;
-         while( true )
+         if( i % 10000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
+         fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
+         if( !block.valid() )
          {
-            fc::optional< block_id_type > last_id = _block_id_to_block.last_id();
-            // this can trigger if we attempt to e.g. read a file that has block #2 but no block #1
-            if( !last_id.valid() )
-               break;
-            // we've caught up to the gap
-            if( block_header::num_from_id( *last_id ) <= i )
-               break;
-            _block_id_to_block.remove( *last_id );
-            dropped_count++;
+            drop_blocks_after_gap( i );
+            break;
          }
-         wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
-         break;
+         apply_block( *block, skip );
       }
-      apply_block(*block, skip_witness_signature |
-                          skip_transaction_signatures |
-                          skip_transaction_dupe_check |
-                          skip_tapos_check |
-                          skip_witness_schedule_check |
-                          skip_authority_check);
+   }
+   else
+   {
+      // Worker threads read, unpack and hash the next _replay_queue_depth blocks while this
+      // thread applies them in order.  Times are in microseconds; fetch and hash are summed
+      // over all workers, stall is time the apply thread waited for the head of the queue
+      // and queued is time prefetched blocks waited for the apply thread.
+      std::atomic<int64_t> fetch_time( 0 );
+      std::atomic<int64_t> hash_time( 0 );
+      int64_t apply_time = 0;
+      int64_t stall_time = 0;
+      int64_t queued_time = 0;
+
+      vector< std::unique_ptr<fc::thread> > workers;
+      for( uint32_t t = 0; t < _replay_worker_threads; ++t )
+         workers.emplace_back( new fc::thread( "replay_" + fc::to_string( uint64_t( t ) ) ) );
+
+      std::deque< fc::future< std::shared_ptr<prefetched_block> > > queue;
+      uint32_t next_to_fetch = 1;
+      auto prefetch_next = [&]()
+      {
+         const uint32_t num = next_to_fetch++;
+         queue.push_back( workers[ num % workers.size() ]->async( [this,num,&fetch_time,&hash_time]()
+         {
+            auto result = std::make_shared<prefetched_block>();
+            auto fetch_start = fc::time_point::now();
+            fc::optional< signed_block > block = _block_id_to_block.fetch_by_number( num );
+            auto fetch_end = fc::time_point::now();
+            fetch_time += ( fetch_end - fetch_start ).count();
+            if( block.valid() )
+            {
+               result->block = precomputed_block( std::move( *block ) );
+               result->ready = fc::time_point::now();
+               hash_time += ( result->ready - fetch_end ).count();
+            }
+            else
+               result->ready = fetch_end;
+            return result;
+         }, "replay prefetch" ) );
+      };
+
+      while( next_to_fetch <= last_block_num && queue.size() < _replay_queue_depth )
+         prefetch_next();
+
+      auto interval_start = fc::time_point::now();
+      for( uint32_t i = 1; i <= last_block_num; ++i )
+      {
+         auto wait_start = fc::time_point::now();
+         std::shared_ptr<prefetched_block> next = queue.front().wait();
+         queue.pop_front();
+         auto wait_end = fc::time_point::now();
+         stall_time += ( wait_end - wait_start ).count();
+         queued_time += std::max<int64_t>( ( wait_start - next->ready ).count(), 0 );
+
+         if( !next->block.valid() )
+         {
+            for( auto& f : queue )
+               f.wait();
+            queue.clear();
+            drop_blocks_after_gap( i );
+            break;
+         }
+
+         if( next_to_fetch <= last_block_num )
+            prefetch_next();
+
+         apply_block( *next->block, skip );
+         apply_time += ( fc::time_point::now() - wait_end ).count();
+
+         if( i % 10000 == 0 )
+         {
+            auto now = fc::time_point::now();
+            std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
+            ilog( "Replay at block ${i}: ${r} blocks/s, ${q} blocks queued",
+                  ("i",i)("r",uint64_t(10000 * 1000000.0 / std::max<int64_t>( (now - interval_start).count(), 1 )))("q",queue.size()) );
+            interval_start = now;
+         }
+      }
+
+      for( auto& w : workers )
+         w->quit();
+
+      ilog( "Replay pipeline: ${n} worker(s), queue depth ${d}; fetch ${f} ms, hash ${h} ms, apply ${a} ms, apply stalled ${s} ms, prefetched blocks queued ${q} ms",
+            ("n",_replay_worker_threads)("d",_replay_queue_depth)
+            ("f",fetch_time.load() / 1000)("h",hash_time.load() / 1000)("a",apply_time / 1000)
+            ("s",stall_time / 1000)("q",queued_time / 1000) );
    }
    _undo_db.enable();
    auto end = fc::time_point::now();
-   ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+   ilog( "Done reindexing, elapsed time: ${t} sec, ${r} blocks/s",
+         ("t",double((end-start).count())/1000000.0 )
+         ("r",uint64_t(head_block_num() * 1000000.0 / std::max<int64_t>( (end-start).count(), 1 ))) );
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
 void database::wipe(const fc::path& data_dir, bool include_blocks)
@@ -114,6 +265,18 @@ void database::open(
 {
    try
    {
+      // only a state saved by flush_changes() after this open may be resumed from after an unclean shutdown
+      optional< std::pair<uint32_t,block_id_type> > resume_point;
+      if( fc::exists( resume_point_file( data_dir ) ) )
+      {
+         std::ifstream in( resume_point_file( data_dir ).generic_string() );
+         uint32_t num = 0;
+         std::string id;
+         in >> num >> id;
+         resume_point = std::make_pair( num, block_id_type( id ) );
+         fc::remove_all( resume_point_file( data_dir ) );
+      }
+
       object_database::open(data_dir);
 
       _block_id_to_block.open(data_dir / "database" / "block_num_to_block");
@@ -121,7 +284,36 @@ void database::open(
       if( !find(global_property_id_type()) )
          init_genesis(genesis_loader());
 
+      if( resume_point.valid() )
+      {
+         FC_ASSERT( head_block_num() == resume_point->first && head_block_id() == resume_point->second,
+                    "Object database does not match the state saved at its resume point",
+                    ("resume_point",*resume_point)("head_block_num",head_block_num())("head_block_id",head_block_id()) );
+         FC_ASSERT( head_block_num() == 0 || _block_id_to_block.contains( head_block_id() ),
+                    "The block the object database was saved at is not in the block log",
+                    ("head_block_num",head_block_num())("head_block_id",head_block_id()) );
+      }
+
       fc::optional<signed_block> last_block = _block_id_to_block.last();
+      if( last_block.valid() && head_block_num() > 0 && last_block->block_num() > head_block_num()
+          && _block_id_to_block.contains( head_block_id() ) )
+      {
+         // The object database was restored from a snapshot taken before the last block was stored,
+         // catch up by applying the missing blocks from the block log.
+         ilog( "Object database is at block ${h}, applying blocks up to ${n} from the block log",
+               ("h",head_block_num())("n",last_block->block_num()) );
+         const uint32_t last_block_num = last_block->block_num();
+         _undo_db.disable();
+         for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
+         {
+            fc::optional< signed_block > block = _block_id_to_block.fetch_by_number( i );
+            if( !block.valid() || block->previous != head_block_id() )
+               break;
+            apply_block( *block, replay_skip_flags );
+         }
+         _undo_db.enable();
+         last_block = _block_id_to_block.fetch_optional( head_block_id() );
+      }
       if( last_block.valid() )
       {
          _fork_db.start_block( *last_block );
@@ -176,6 +368,8 @@ void database::close(bool rewind)
    // DB state (issue #336).
    clear_pending();
 
+   if( get_data_dir() != fc::path() )
+      fc::remove_all( resume_point_file( get_data_dir() ) );
    object_database::flush();
    object_database::close();
 
@@ -258,6 +258,12 @@ struct get_impacted_account_visitor
        _impacted.insert( op.owner );
     }
 
+    // bulk deflation covers whole id ranges, each owner is impacted by the virtual per-account and per-order
+    // deflation operations it emits
+    void operator()( const account_bulk_deflation_operation& op ) {}
+
+    void operator()( const order_bulk_deflation_operation& op ) {}
+
     void operator()( const account_create_by_transfer_operation& op )
     {
         _impacted.insert( op.from );
@@ -435,9 +441,7 @@ void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accoun
               accounts.insert( aobj->owner );
               break;
            } case impl_transaction_object_type:{
-              const auto& aobj = dynamic_cast<const transaction_object*>(obj);
-              assert( aobj != nullptr );
-              transaction_get_impacted_accounts( aobj->trx, accounts, db );
+              // only the id of the transaction is kept, its accounts are reported with its operations
               break;
            } case impl_blinded_balance_object_type:{
               const auto& aobj = dynamic_cast<const blinded_balance_object*>(obj);
@@ -499,7 +503,13 @@ void database::notify_changed_objects()
         for( const auto& item : head_undo.old_values )
         {
           changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted);
+          auto obj = find_object(item.first);
+          if(obj != nullptr)
+          {
+            // the relevant accounts are those of the value before the change
+            auto old_obj = _undo_db.head_old_value(*obj);
+            get_relevant_accounts(old_obj ? old_obj.get() : obj, changed_accounts_impacted);
+          }
         }
 
         changed_objects(changed_ids, changed_accounts_impacted);
@@ -524,4 +534,47 @@ void database::notify_changed_objects()
    }
 } FC_CAPTURE_AND_LOG( (0) ) }
 
+void database::push_block_event( const signed_block& b )
+{
+   auto event = std::make_shared<applied_block_event>();
+   event->block = b;
+   event->block_num = b.block_num();
+   event->applied_operations = _applied_ops;
+   event->transaction_ids = _applied_trx_ids;
+   if( _undo_db.enabled() )
+   {
+      const auto& head_undo = _undo_db.head();
+      event->new_objects.reserve( head_undo.new_ids.size() );
+      for( const auto& id : head_undo.new_ids )
+      {
+         auto obj = find_object( id );
+         if( obj != nullptr )
+            event->new_objects.emplace_back( obj->clone() );
+      }
+      event->changed_objects.reserve( head_undo.old_values.size() );
+      for( const auto& item : head_undo.old_values )
+      {
+         auto obj = find_object( item.first );
+         if( obj != nullptr )
+            event->changed_objects.emplace_back( obj->clone() );
+      }
+      event->removed_objects.reserve( head_undo.removed.size() );
+      for( const auto& item : head_undo.removed )
+         event->removed_objects.emplace_back( item.second->clone() );
+   }
+   _block_events.push( std::move( event ) );
+}
+
+flat_set<account_id_type> applied_block_event::get_impacted_accounts()const
+{
+   flat_set<account_id_type> result;
+   for( const auto& obj : new_objects )
+      get_relevant_accounts( obj.get(), result );
+   for( const auto& obj : changed_objects )
+      get_relevant_accounts( obj.get(), result );
+   for( const auto& obj : removed_objects )
+      get_relevant_accounts( obj.get(), result );
+   return result;
+}
+
 } }
@@ -27,10 +27,109 @@
 #include <graphene/chain/deflation_object.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/hardfork.hpp>
 
 using namespace fc;
 
 namespace graphene { namespace chain {
+
+    namespace {
+        /**
+         * Applies deflation @p dflt to the core balance of @p owner. @p record and @p balance are the
+         * account's deflation record and core balance, nullptr if the account has none.
+         * @return the amount deflated, including the amount frozen before the deflation reached the account
+         */
+        share_type deflate_account( database& d, const deflation_object& dflt, account_id_type owner,
+                                    const account_deflation_object* record, const account_balance_object* balance ) {
+            bool cleared = false;
+            share_type frozen = 0;
+
+            // update account deflation object
+            if (record) {
+                cleared = record->cleared;
+                frozen = record->frozen;
+                d.modify(*record, [&](account_deflation_object &obj) {
+                    obj.last_deflation_id = dflt.id;
+                    obj.frozen = 0;
+                    obj.cleared = false;
+                });
+            } else {
+                d.create<account_deflation_object>( [&]( account_deflation_object &obj){
+                    obj.owner = owner;
+                    obj.last_deflation_id = dflt.id;
+                    obj.frozen = 0;
+                    obj.cleared = false;
+                });
+            }
+
+            // update account balance
+            share_type deflation_amount = 0;
+            if (!cleared && balance) {
+                uint128_t amount = uint128_t(balance->balance.value) * dflt.rate / GRAPHENE_DEFLATION_RATE_SCALE;
+                deflation_amount = amount.to_uint64();
+                if (deflation_amount > 0) {
+                    d.modify(*balance, [&](account_balance_object &obj) {
+                        obj.adjust_balance(-asset(deflation_amount, asset_id_type(0)));
+                    });
+                }
+            }
+            return deflation_amount + frozen;
+        }
+
+        /**
+         * Applies deflation @p dflt to @p order if it sells the core asset. @p record is the order's
+         * deflation record, nullptr if it has none.
+         * @return the amount deflated, including the amount frozen before the deflation reached the order
+         */
+        share_type deflate_order( database& d, const deflation_object& dflt, const limit_order_object& order,
+                                  const order_deflation_object* record ) {
+            // filter all non PIC orders first
+            if (order.sell_price.base.asset_id != asset_id_type(0)) {
+                return 0;
+            }
+
+            bool cleared = false;
+            share_type frozen = 0;
+
+            // update order deflation object
+            if (record) {
+                cleared = record->cleared;
+                frozen = record->frozen;
+                d.modify(*record, [&](order_deflation_object &obj) {
+                    obj.last_deflation_id = dflt.id;
+                    obj.frozen = 0;
+                    obj.cleared = false;
+                });
+            } else {
+                d.create<order_deflation_object>([&](order_deflation_object &obj){
+                    obj.order = order.id;
+                    obj.last_deflation_id = dflt.id;
+                    obj.frozen = 0;
+                    obj.cleared = false;
+                });
+            }
+
+            // update order balance
+            share_type deflation_amount = 0;
+            if (!cleared) {
+                uint128_t amount = uint128_t(order.for_sale.value) * dflt.rate / GRAPHENE_DEFLATION_RATE_SCALE;
+                deflation_amount = int64_t(amount.to_uint64());
+                if (deflation_amount > 0) {
+                    d.modify(order, [&](limit_order_object &obj){
+                        obj.for_sale -= deflation_amount;
+                    });
+                    // adjust total_core_in_orders of account
+                    d.pay_order(order.seller(d), asset(0), asset(deflation_amount));
+                    const auto& balances = order.seller(d).statistics(d);
+                    d.modify( balances, [&]( account_statistics_object& b ){
+                        b.total_core_in_orders -= deflation_amount;
+                    });
+                }
+            }
+            return deflation_amount + frozen;
+        }
+    }
     
     void_result deflation_evaluator::do_evaluate( const deflation_operation& op ) {
         try {
@@ -171,42 +270,16 @@ namespace graphene { namespace chain {
 
         const auto &acc_dflt_idx = db().get_index_type<account_deflation_index>().indices().get<by_owner>();
         const auto &acc_dflt_it = acc_dflt_idx.find(op.owner);
+        const auto &bal_idx = db().get_index_type<account_balance_index>().indices().get<by_account_asset>();
+        const auto &bal_it = bal_idx.find(boost::make_tuple(op.owner, asset_id_type(0)));
 
-        bool cleared = false;
-        share_type frozen = 0;
-
-        // update account deflation object
-        if (acc_dflt_it != acc_dflt_idx.end()) {
-            cleared = acc_dflt_it->cleared;
-            frozen = acc_dflt_it->frozen;
-            db().modify(*acc_dflt_it, [&](account_deflation_object &obj) {
-                obj.last_deflation_id = op.deflation_id;
-                obj.frozen = 0;
-                obj.cleared = false;
-            });
-        } else {
-            db().create<account_deflation_object>( [&]( account_deflation_object &obj){
-                obj.owner = op.owner;
-                obj.last_deflation_id = op.deflation_id;
-                obj.frozen = 0;
-                obj.cleared = false;
-            });
-        }
-
-        // update account balance
-        share_type deflation_amount = 0;
-        if (!cleared) {
-            auto balance = db().get_balance(op.owner, asset_id_type(0));
-            uint128_t amount = uint128_t(balance.amount.value)* dflt_it->rate / GRAPHENE_DEFLATION_RATE_SCALE;
-            deflation_amount = amount.to_uint64();
-        }
-        if (deflation_amount > 0) {
-            db().adjust_balance(op.owner, -asset(deflation_amount, asset_id_type(0)));
-        }
+        share_type deflation_amount = deflate_account(db(), *dflt_it, op.owner,
+                acc_dflt_it != acc_dflt_idx.end() ? &*acc_dflt_it : nullptr,
+                bal_it != bal_idx.end() ? &*bal_it : nullptr);
 
         db().modify(*dflt_it, [&](deflation_object &obj){
             obj.account_cursor = op.owner + 1;
-            obj.total_amount += (deflation_amount + frozen);
+            obj.total_amount += deflation_amount;
             if (op.owner == dflt_it->last_account) {
                 obj.balance_cleared = true;
             }
@@ -257,65 +330,223 @@ namespace graphene { namespace chain {
 
         auto &order_idx = db().get_index_type<limit_order_index>().indices().get<by_id>();
         const auto &order_it = order_idx.find(op.order);
-        // filter all non PIC orders first
-        if (order_it->sell_price.base.asset_id != asset_id_type(0)) {
-            db().modify(*dflt_it, [&](deflation_object &obj){
-                obj.order_cursor = op.order + 1;
-                if (op.order == dflt_it->last_order) {
-                    obj.order_cleared = true;
-                }
-            });
-            return void_result();
-        }
-
         const auto &order_dflt_idx = db().get_index_type<order_deflation_index>().indices().get<by_order>();
         const auto &order_dflt_it = order_dflt_idx.find(op.order);
 
-        bool cleared = false;
-        share_type frozen = 0;
-
-        // update order deflation object
-        if (order_dflt_it != order_dflt_idx.end()) {
-            cleared = order_dflt_it->cleared;
-            frozen = order_dflt_it->frozen;
-            db().modify(*order_dflt_it, [&](order_deflation_object &obj) {
-                obj.last_deflation_id = op.deflation_id;
-                obj.frozen = 0;
-                obj.cleared = false;
-            });
-        } else {
-            db().create<order_deflation_object>([&](order_deflation_object &obj){
-                obj.order = op.order;
-                obj.last_deflation_id = op.deflation_id;
-                obj.frozen = 0;
-                obj.cleared = false;
-            });
-        }
+        share_type deflation_amount = deflate_order(db(), *dflt_it, *order_it,
+                order_dflt_it != order_dflt_idx.end() ? &*order_dflt_it : nullptr);
 
-        // update order balance
-        share_type deflation_amount = 0;
-        if (!cleared) {
-            uint128_t amount = uint128_t(order_it->for_sale.value) * dflt_it->rate / GRAPHENE_DEFLATION_RATE_SCALE;
-            deflation_amount = int64_t(amount.to_uint64());
-            if (deflation_amount > 0) {
-                db().modify(*order_it, [&](limit_order_object &obj){
-                    obj.for_sale -= deflation_amount;
-                });
-                // adjust total_core_in_orders of account
-                db().pay_order(order_it->seller(db()), asset(0), asset(deflation_amount));
-                const auto& balances = order_it->seller(db()).statistics(db());
-                db().modify( balances, [&]( account_statistics_object& b ){
-                    b.total_core_in_orders -= deflation_amount;
-                });                
-            }
-        }
         db().modify(*dflt_it, [&](deflation_object &obj){
             obj.order_cursor = op.order + 1;
-            obj.total_amount += (deflation_amount + frozen);
+            obj.total_amount += deflation_amount;
             if (op.order == dflt_it->last_order) {
                 obj.order_cleared = true;
             }
         });
         return void_result();
     }    
+
+    void_result account_bulk_deflation_evaluator::do_evaluate( const account_bulk_deflation_operation& op ) {
+        try {
+            FC_ASSERT(
+                db().head_block_time() >= HARDFORK_BULK_DEFLATION_TIME,
+                "bulk deflation is not enabled before ${t}",
+                ("t", HARDFORK_BULK_DEFLATION_TIME)
+            );
+            auto &dflt_idx = db().get_index_type<deflation_index>().indices().get<by_id>();
+            const auto &dflt_it = dflt_idx.find(op.deflation_id);
+            FC_ASSERT(
+                dflt_it != dflt_idx.end(),
+                "deflation object not found for this account deflation. defaltion_object_id:${dflt_id}",
+                ("dflt_id", op.deflation_id)
+            );
+            FC_ASSERT(
+                dflt_it->balance_cleared == false,
+                "account deflation is already cleared"
+            );
+            FC_ASSERT(
+                op.first == dflt_it->account_cursor,
+                "bulk deflation should start at account ${cursor}, got ${acc}",
+                ("cursor", dflt_it->account_cursor)
+                ("acc", op.first)
+            );
+            FC_ASSERT(
+                !(dflt_it->last_account < op.last),
+                "bulk deflation passes the last account ${last}, got ${acc}",
+                ("last", dflt_it->last_account)
+                ("acc", op.last)
+            );
+            FC_ASSERT(
+                op.last.instance.value - op.first.instance.value < GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION,
+                "bulk deflation covers more than ${max} accounts",
+                ("max", GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION)
+            );
+            _deflation = &*dflt_it;
+            return void_result();
+    } FC_CAPTURE_AND_RETHROW((op)) }
+
+    asset account_bulk_deflation_evaluator::do_apply( const account_bulk_deflation_operation& op ) {
+        database& d = db();
+        const auto &acc_idx = d.get_index_type<account_index>().indices().get<by_id>();
+        const auto &bal_idx = d.get_index_type<account_balance_index>().indices().get<by_account_asset>();
+        const auto &acc_dflt_idx = d.get_index_type<account_deflation_index>().indices().get<by_owner>();
+
+        // accounts, their balances and their deflation records are all ordered by account id,
+        // so the range is deflated in one merged walk instead of a lookup per account
+        auto bal_it = bal_idx.lower_bound(boost::make_tuple(op.first));
+        auto acc_dflt_it = acc_dflt_idx.lower_bound(op.first);
+        share_type total = 0;
+        for (auto acc_it = acc_idx.lower_bound(op.first);
+                acc_it != acc_idx.end() && !(op.last < account_id_type(acc_it->id));
+                ++acc_it) {
+            const account_id_type owner = acc_it->id;
+            while (bal_it != bal_idx.end() && bal_it->owner < owner) {
+                ++bal_it;
+            }
+            while (acc_dflt_it != acc_dflt_idx.end() && acc_dflt_it->owner < owner) {
+                ++acc_dflt_it;
+            }
+            const account_deflation_object* record = nullptr;
+            if (acc_dflt_it != acc_dflt_idx.end() && acc_dflt_it->owner == owner) {
+                FC_ASSERT(
+                    acc_dflt_it->last_deflation_id < op.deflation_id,
+                    "accout: ${acc} last_deflation_id: ${acc_dflt_id} is not smaller than deflation: ${dflt_id}",
+                    ("acc", owner)
+                    ("acc_dflt_id", acc_dflt_it->last_deflation_id)
+                    ("dflt_id", op.deflation_id)
+                );
+                record = &*acc_dflt_it;
+            }
+            // core is the first asset of every account
+            const account_balance_object* balance = nullptr;
+            if (bal_it != bal_idx.end() && bal_it->owner == owner && bal_it->asset_type == asset_id_type(0)) {
+                balance = &*bal_it;
+            }
+            const share_type amount = deflate_account(d, *_deflation, owner, record, balance);
+            if (amount > 0) {
+                // recorded in the owner's history as a per-account deflation would be
+                account_deflation_operation vop;
+                vop.deflation_id = op.deflation_id;
+                vop.owner = owner;
+                vop.amount = amount;
+                d.push_applied_operation(vop);
+            }
+            total += amount;
+        }
+
+        d.modify(*_deflation, [&](deflation_object &obj){
+            obj.account_cursor = op.last + 1;
+            obj.total_amount += total;
+            if (op.last == obj.last_account) {
+                obj.balance_cleared = true;
+            }
+        });
+        return asset(total, asset_id_type(0));
+    }
+
+    void_result order_bulk_deflation_evaluator::do_evaluate( const order_bulk_deflation_operation& op ) {
+        try {
+            FC_ASSERT(
+                db().head_block_time() >= HARDFORK_BULK_DEFLATION_TIME,
+                "bulk deflation is not enabled before ${t}",
+                ("t", HARDFORK_BULK_DEFLATION_TIME)
+            );
+            auto &dflt_idx = db().get_index_type<deflation_index>().indices().get<by_id>();
+            const auto &dflt_it = dflt_idx.find(op.deflation_id);
+            FC_ASSERT(
+                dflt_it != dflt_idx.end(),
+                "deflation object not found for this order deflation. defaltion_object_id:${dflt_id}",
+                ("dflt_id", op.deflation_id)
+            );
+            FC_ASSERT(
+                dflt_it->order_cleared == false,
+                "order deflation is already cleared"
+            );
+            FC_ASSERT(
+                op.first == dflt_it->order_cursor,
+                "bulk deflation should start at order ${cursor}, got ${order}",
+                ("cursor", dflt_it->order_cursor)
+                ("order", op.first)
+            );
+            if (dflt_it->last_order < op.first) {
+                // the cursor passed a last order that was removed, only the empty range clears order deflation
+                FC_ASSERT(
+                    op.last == op.first,
+                    "bulk deflation past the last order ${last} should end at ${cursor}, got ${order}",
+                    ("last", dflt_it->last_order)
+                    ("cursor", op.first)
+                    ("order", op.last)
+                );
+            } else {
+                FC_ASSERT(
+                    !(dflt_it->last_order < op.last),
+                    "bulk deflation passes the last order ${last}, got ${order}",
+                    ("last", dflt_it->last_order)
+                    ("order", op.last)
+                );
+            }
+            _deflation = &*dflt_it;
+            return void_result();
+    } FC_CAPTURE_AND_RETHROW((op)) }
+
+    asset order_bulk_deflation_evaluator::do_apply( const order_bulk_deflation_operation& op ) {
+        database& d = db();
+        if (_deflation->last_order < op.first) {
+            d.modify(*_deflation, [&](deflation_object &obj){
+                obj.order_cleared = true;
+            });
+            return asset(0, asset_id_type(0));
+        }
+
+        const auto &order_idx = d.get_index_type<limit_order_index>().indices().get<by_id>();
+        const auto &order_dflt_idx = d.get_index_type<order_deflation_index>().indices().get<by_order>();
+
+        // orders and their deflation records are both ordered by order id, see account_bulk_deflation_evaluator
+        auto order_dflt_it = order_dflt_idx.lower_bound(op.first);
+        share_type total = 0;
+        uint32_t count = 0;
+        for (auto order_it = order_idx.lower_bound(op.first);
+                order_it != order_idx.end() && !(op.last < limit_order_id_type(order_it->id));
+                ++order_it) {
+            FC_ASSERT(
+                ++count <= GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION,
+                "bulk deflation covers more than ${max} orders",
+                ("max", GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION)
+            );
+            const limit_order_id_type order = order_it->id;
+            while (order_dflt_it != order_dflt_idx.end() && order_dflt_it->order < order) {
+                ++order_dflt_it;
+            }
+            const order_deflation_object* record = nullptr;
+            if (order_dflt_it != order_dflt_idx.end() && order_dflt_it->order == order) {
+                FC_ASSERT(
+                    order_dflt_it->last_deflation_id < op.deflation_id,
+                    "order: ${order} last_deflation_id: ${order_dflt_id} is not smaller than deflation: ${dflt_id}",
+                    ("order", order)
+                    ("order_dflt_id", order_dflt_it->last_deflation_id)
+                    ("dflt_id", op.deflation_id)
+                );
+                record = &*order_dflt_it;
+            }
+            const share_type amount = deflate_order(d, *_deflation, *order_it, record);
+            if (amount > 0) {
+                order_deflation_operation vop;
+                vop.deflation_id = op.deflation_id;
+                vop.order = order;
+                vop.owner = order_it->seller;
+                vop.amount = amount;
+                d.push_applied_operation(vop);
+            }
+            total += amount;
+        }
+
+        d.modify(*_deflation, [&](deflation_object &obj){
+            obj.order_cursor = op.last + 1;
+            obj.total_amount += total;
+            if (op.last == obj.last_order) {
+                obj.order_cleared = true;
+            }
+        });
+        return asset(total, asset_id_type(0));
+    }
 }} // graphene::chain
@@ -25,11 +25,8 @@
 #include <graphene/chain/incentive_evaluator.hpp>
 #include <graphene/chain/protocol/construction_capital.hpp>
 #include <graphene/chain/construction_capital_object.hpp>
-#include <fc/real128.hpp>
 #include <graphene/chain/protocol/types.hpp>
 
-using namespace fc;
-
 namespace graphene { namespace chain {
 
     void_result incentive_evaluator::do_evaluate( const incentive_operation& op ) {
@@ -43,16 +40,12 @@ namespace graphene { namespace chain {
                 ("cc", op.ccid)
             );
             const auto& gpo = db().get_global_properties();
-            real128 amount0 = real128(it->amount.value) / real128(it->total_periods);
-            real128 amount1 = real128(it->amount.value)
-                * real128(it->period) / real128(GRAPHENE_SECONDS_PER_YEAR) 
-                * real128(gpo.parameters.issuance_rate) / real128(GRAPHENE_ISSUANCE_RATE_SCALE);
-            real128 amount = amount0 + amount1;
+            share_type amount = db().get_incentive_scheduler().payout(*it, gpo.parameters.issuance_rate);
             //check if incentive amount is valid
             FC_ASSERT(
-                amount.to_uint64() == op.amount,
+                amount == op.amount,
                 "incentive amount invalid, should be ${should}, got ${got}",
-                ("should", amount.to_uint64())
+                ("should", amount)
                 ("got", op.amount)
             );            
             //check if has unreleased incentive period(s)
@@ -111,7 +104,7 @@ namespace graphene { namespace chain {
         // wlog("incentive run, cc: ${cc}", ("cc", *it));
         //if release of this construction capital is done, 
         if (it->achieved >= it->total_periods) {
-            wlog("incentive done, cc: ${cc}", ("cc", *it));
+            dlog("incentive done, cc: ${cc}", ("cc", *it));
             db().remove(*it);
         }
         return void_result();
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/incentive_scheduler.hpp>
+#include <graphene/chain/construction_capital_object.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <fc/real128.hpp>
+
+namespace graphene { namespace chain {
+
+share_type incentive_scheduler::compute_payout( const construction_capital_object& cc, uint32_t issuance_rate )
+{
+   using fc::real128;
+   // pay back save money by period
+   real128 amount0 = real128(cc.amount.value) / real128(cc.total_periods);
+   // pay interest
+   real128 amount1 = real128(cc.amount.value)
+      * real128(cc.period) / real128(GRAPHENE_SECONDS_PER_YEAR)
+      * real128(issuance_rate) / real128(GRAPHENE_ISSUANCE_RATE_SCALE);
+   return (amount0 + amount1).to_uint64();
+}
+
+share_type incentive_scheduler::payout( const construction_capital_object& cc, uint32_t issuance_rate )const
+{
+   auto itr = _payouts.find( cc.id.instance() );
+   if( itr != _payouts.end() )
+   {
+      const cached_payout& cached = itr->second;
+      if( cached.amount == cc.amount && cached.period == cc.period
+          && cached.total_periods == cc.total_periods && cached.issuance_rate == issuance_rate )
+         return cached.payout;
+   }
+   return compute_payout( cc, issuance_rate );
+}
+
+share_type incentive_scheduler::cache_payout( const construction_capital_object& cc, uint32_t issuance_rate )
+{
+   cached_payout& cached = _payouts[cc.id.instance()];
+   cached.amount = cc.amount;
+   cached.period = cc.period;
+   cached.total_periods = cc.total_periods;
+   cached.issuance_rate = issuance_rate;
+   cached.payout = compute_payout( cc, issuance_rate );
+   return cached.payout;
+}
+
+vector<incentive_operation> incentive_scheduler::schedule( const database& db )
+{
+   const auto& params = db.get_global_properties().parameters;
+   const size_t limit = params.max_incentive_operations_per_block;
+   const auto& cc_idx = db.get_index_type<construction_capital_index>().indices();
+
+   _payouts.clear();
+   vector<incentive_operation> ops;
+
+   auto add_op = [&]( const construction_capital_object& cc, share_type amount, uint8_t reason ) {
+      incentive_operation op;
+      op.amount = amount;
+      op.ccid = cc.id;
+      op.reason = reason;
+      ops.push_back( op );
+   };
+
+   // incentives of construction capital whose period has elapsed, earliest first
+   auto select_periods = [&]() {
+      const auto& by_slot = cc_idx.get<by_next_slot>();
+      const auto end = by_slot.upper_bound( db.head_block_time() );
+      for( auto itr = by_slot.begin(); itr != end && ops.size() < limit; ++itr )
+         add_op( *itr, cache_payout( *itr, params.issuance_rate ), 0 );
+   };
+
+   // incentives accelerated by construction capital votes, most pending first
+   auto select_votes = [&]() {
+      const auto& by_pend = cc_idx.get<by_pending>();
+      for( auto itr = by_pend.rbegin(); itr != by_pend.rend() && itr->pending > 0 && ops.size() < limit; ++itr )
+      {
+         const share_type amount = cache_payout( *itr, params.issuance_rate );
+         for( uint16_t i = 0; i < itr->pending && ops.size() < limit; ++i )
+            add_op( *itr, amount, 1 );
+      }
+   };
+
+   if( _votes_first )
+   {
+      select_votes();
+      select_periods();
+   }
+   else
+   {
+      select_periods();
+      select_votes();
+   }
+
+   if( ops.size() >= limit )
+      _votes_first = !_votes_first;
+
+   return ops;
+}
+
+} }
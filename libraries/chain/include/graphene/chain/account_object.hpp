@@ -326,6 +326,26 @@ namespace graphene { namespace chain {
          map< account_id_type, set<account_id_type> > referred_by;
    };
 
+   /**
+    *  @brief This secondary index keeps the number of accounts holding a non-zero balance of each asset, so that
+    *  it can be served without walking every balance of the asset.
+    */
+   class asset_holder_count_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** @return the number of accounts with a non-zero balance of asset_id */
+         uint64_t get_holder_count( asset_id_type asset_id )const;
+
+      private:
+         map< asset_id_type, uint64_t > holder_count;
+         bool                           held_before_modify = false;
+   };
+
    struct by_account_asset;
    struct by_asset_balance;
    /**
@@ -361,7 +381,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
+   typedef dense_generic_index<account_balance_object, account_balance_object_multi_index_type> account_balance_index;
 
    struct by_name{};
 
@@ -379,7 +399,7 @@ namespace graphene { namespace chain {
    /**
     * @ingroup object_index
     */
-   typedef generic_index<account_object, account_multi_index_type> account_index;
+   typedef dense_generic_index<account_object, account_multi_index_type> account_index;
 
 }}
 
@@ -26,6 +26,17 @@
 #include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace chain {
+   /**
+    * Fixed size record stored in the "index" file at offset sizeof(index_entry) * block_num,
+    * shared by all block_database backends.
+    */
+   struct index_entry
+   {
+      uint64_t      block_pos = 0;
+      uint32_t      block_size = 0;
+      block_id_type block_id;
+   };
+
    class block_database 
    {
       public:
@@ -41,6 +52,9 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// @return the block as it is stored, i.e. serialized with fc::raw::pack, without unpacking it
+         optional<vector<char>> fetch_packed( const block_id_type& id )const;
+         optional<vector<char>> fetch_packed_by_number( uint32_t block_num )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
       private:
@@ -48,3 +62,5 @@ namespace graphene { namespace chain {
          mutable std::fstream _block_num_to_pos;
    };
 } }
+
+FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
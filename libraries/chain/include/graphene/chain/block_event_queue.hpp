@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/protocol/block.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace fc { class thread; }
+
+namespace graphene { namespace chain {
+
+   /**
+    *  What applying one block did, copied out of the database so that it can be read on another thread while
+    *  the next block is being applied.
+    */
+   struct applied_block_event
+   {
+      signed_block                                  block;
+      uint32_t                                      block_num = 0;
+      /// same as database::get_applied_operations() while the block was applied
+      vector< optional<operation_history_object> >  applied_operations;
+      /// same as database::get_applied_transaction_ids() while the block was applied
+      vector< transaction_id_type >                 transaction_ids;
+      /// values of the objects the block created and modified, as the block left them
+      vector< std::shared_ptr<const object> >       new_objects;
+      vector< std::shared_ptr<const object> >       changed_objects;
+      /// last values of the objects the block removed
+      vector< std::shared_ptr<const object> >       removed_objects;
+
+      /// the accounts the database's new_objects, changed_objects and removed_objects signals would report
+      flat_set<account_id_type> get_impacted_accounts()const;
+   };
+
+   /**
+    *  Hands an applied_block_event for every block to consumers which handle them on threads of their own, so
+    *  that the block-apply thread does not wait for them.
+    *
+    *  Each consumer sees every event, in the order they were pushed.  At most max_queued events wait for a
+    *  consumer; push() waits for the oldest one to be handled when a consumer falls that far behind, so a
+    *  slow consumer slows down block application rather than missing blocks.
+    *
+    *  Consumers only see the snapshots in the event and must not read the database, which keeps changing
+    *  under them.  push() and the other methods are called from the thread that applies blocks.  push() is
+    *  called while a block is being applied, so it blocks that thread instead of yielding to other tasks
+    *  on it, which could otherwise run in the middle of the block.
+    *
+    *  Nothing is pushed when blocks are popped, e.g. on a fork switch.  The blocks of the new fork are pushed
+    *  as they are applied, so a consumer that sees a block_num at or below one it has handled before must
+    *  treat the new block as replacing the earlier one and everything after it.
+    */
+   class block_event_queue
+   {
+      public:
+         typedef std::function<void(const applied_block_event&)> handler_type;
+
+         struct consumer_status
+         {
+            string   name;
+            /// the last block handled by the consumer
+            uint32_t last_block_num = 0;
+            /// the last block pushed, which is the head block unless blocks were popped since
+            uint32_t head_block_num = 0;
+            /// blocks pushed but not yet handled by the consumer
+            uint32_t lag = 0;
+         };
+
+         explicit block_event_queue( uint32_t max_queued = 256 );
+         ~block_event_queue();
+
+         void     set_max_queued( uint32_t max_queued );
+         uint32_t get_max_queued()const { return _max_queued; }
+
+         /// starts a thread calling handler with every event pushed from now on
+         void add_consumer( const string& name, handler_type handler );
+         /// waits until the consumer has handled its events, then stops its thread
+         void remove_consumer( const string& name );
+         bool has_consumers()const { return !_consumers.empty(); }
+
+         void push( std::shared_ptr<const applied_block_event> event );
+
+         /// waits until the consumer has handled every event pushed so far
+         void wait_until_handled( const string& name );
+
+         vector<consumer_status> get_consumer_status()const;
+
+      private:
+         struct consumer
+         {
+            string                          name;
+            handler_type                    handler;
+            std::unique_ptr<fc::thread>     thread;
+            /// one per event pushed, set once the handler is done with it
+            std::deque< std::future<void> > queued;
+            std::atomic<uint32_t>           last_block_num;
+         };
+
+         consumer* find_consumer( const string& name );
+         /// forgets the events the consumer is done with, then waits until at most max_size are left, without
+         /// yielding to other tasks of the calling thread
+         static void wait_for_queued( consumer& c, size_t max_size );
+
+         uint32_t                              _max_queued;
+         uint32_t                              _last_pushed_block_num = 0;
+         vector< std::unique_ptr<consumer> >   _consumers;
+   };
+
+} }
+
+FC_REFLECT( graphene::chain::block_event_queue::consumer_status, (name)(last_block_num)(head_block_num)(lag) )
@@ -144,10 +144,13 @@
 #define GRAPHENE_RECENTLY_MISSED_COUNT_INCREMENT             4
 #define GRAPHENE_RECENTLY_MISSED_COUNT_DECREMENT             3
 
-#define GRAPHENE_CURRENT_DB_VERSION                          "PIC1.0"
+#define GRAPHENE_CURRENT_DB_VERSION                          "PIC1.2"
 
 #define GRAPHENE_IRREVERSIBLE_THRESHOLD                      (70 * GRAPHENE_1_PERCENT)
 
+/// number of transactions whose bodies database::get_recent_transaction() can return
+#define GRAPHENE_DEFAULT_RECENT_TRANSACTION_CACHE_SIZE       10000
+
 /**
  *  Reserved Account IDs with special meaning
  */
@@ -183,6 +186,8 @@
  */
 #define GRAPHENE_DEFAULT_MAX_INCENTIVE_OPERATIONS_PER_BLOCK         256
 #define GRAPHENE_DEFAULT_MAX_DEFLATION_OPERATIONS_PER_BLOCK         256
+/// Upper bound of accounts or limit orders covered by one bulk deflation operation
+#define GRAPHENE_MAX_BULK_DEFLATION_OBJECTS_PER_OPERATION           10000
 #define GRAPHENE_DEFAULT_MIN_CONSTRUCTION_CAPITAL_AMOUNT            30000000
 #define GRAPHENE_DEFAULT_MIN_CONSTRUCTION_CAPITAL_PERIOD            604800
 #define GRAPHENE_DEFAULT_MAX_CONSTRUCTION_CAPITAL_PERIOD            31536000    //1 year
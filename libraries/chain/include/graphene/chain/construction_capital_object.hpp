@@ -95,7 +95,7 @@ namespace graphene { namespace chain {
             >
         >
     > construction_capital_index_type;
-    typedef generic_index<construction_capital_object, construction_capital_index_type> construction_capital_index;
+    typedef dense_generic_index<construction_capital_object, construction_capital_index_type> construction_capital_index;
 
     // class construction_capital_vote_object;
     /**
@@ -25,9 +25,12 @@
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/node_property_object.hpp>
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/block_event_queue.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
-#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/mapped_block_database.hpp>
+#include <graphene/chain/precomputed_block.hpp>
+#include <graphene/chain/incentive_scheduler.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 
@@ -40,7 +43,11 @@
 
 #include <fc/log/logger.hpp>
 
+#include <deque>
 #include <map>
+#include <unordered_map>
+
+namespace fc { class thread; }
 
 namespace graphene { namespace chain {
    using graphene::db::abstract_object;
@@ -49,6 +56,22 @@ namespace graphene { namespace chain {
    class transaction_evaluation_state;
 
    struct budget_record;
+   class deflation_object;
+
+   /// counters of database::admit_transaction()
+   struct transaction_admission_stats
+   {
+      /// transactions being checked or waiting to be applied
+      uint32_t queue_depth = 0;
+      uint32_t max_queue_depth = 0;
+      /// transactions that passed the checks and were applied
+      uint64_t admitted = 0;
+      uint64_t rejected_queue_full = 0;
+      /// transactions that failed the checks on the admission threads
+      uint64_t rejected_invalid = 0;
+      /// transactions that passed the checks but failed to apply
+      uint64_t rejected_apply = 0;
+   };
 
    /**
     *   @class database
@@ -111,6 +134,37 @@ namespace graphene { namespace chain {
          void wipe(const fc::path& data_dir, bool include_blocks);
          void close(bool rewind = true);
 
+         /**
+          * @brief Configure the block prefetch pipeline used by @ref database::reindex
+          * @param worker_threads Number of threads which read, unpack and hash blocks ahead of application,
+          *        0 replays on the calling thread only
+          * @param queue_depth Maximum number of blocks prefetched ahead of the block being applied
+          */
+         void set_replay_pipeline( uint32_t worker_threads, uint32_t queue_depth );
+
+         /**
+          * @brief Periodically save the objects changed by pushed blocks, see @ref object_database::flush_changes
+          *
+          * After an unclean shutdown @ref open then restores the last saved state and applies the remaining blocks
+          * from the block log instead of requiring a full @ref reindex.
+          *
+          * @param seconds Minimum time between two saves, 0 disables periodic saves
+          */
+         void set_flush_changes_interval( uint32_t seconds );
+
+         /**
+          * Saves the objects changed since the last save like @ref object_database::flush_changes and records the
+          * head block the saved state belongs to as the resume point.
+          */
+         void flush_changes();
+
+         /**
+          * @return true if the state in data_dir was saved by @ref flush_changes since it was last opened, so that
+          * after an unclean shutdown @ref open can resume from it.  A snapshot written by @ref close is only valid
+          * until the database is opened again.
+          */
+         static bool has_resume_point( const fc::path& data_dir );
+
          //////////////////// db_block.cpp ////////////////////
 
          /**
@@ -122,7 +176,27 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /**
+          * @return the block serialized with fc::raw::pack; blocks that are in the block database are returned
+          *         as stored without being unpacked
+          */
+         optional<vector<char>>     fetch_packed_block_by_id( const block_id_type& id )const;
+         optional<vector<char>>     fetch_packed_block_by_number( uint32_t num )const;
+         /**
+          * Reads up to max_blocks packed blocks starting at first_block_num from the block database, with one copy
+          * per run of blocks stored next to each other, see mapped_block_database::fetch_packed_range().  Blocks
+          * past the head block are not returned.
+          * @return the number of blocks appended to data, whose sizes are appended to sizes
+          */
+         uint32_t                   fetch_packed_block_range( uint32_t first_block_num, uint32_t max_blocks, uint64_t max_bytes,
+                                                              vector<char>& data, vector<uint32_t>& sizes )const;
+         /**
+          * @return the body of a transaction applied recently, from a cache of the last
+          *         set_recent_transaction_cache_size() transactions applied with the duplicate check
+          */
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
+         /// Bounds the cache of get_recent_transaction(), 0 disables it
+         void                       set_recent_transaction_cache_size( uint32_t size );
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
          /**
@@ -135,10 +209,47 @@ namespace graphene { namespace chain {
          const flat_map<uint32_t,block_id_type> get_checkpoints()const { return _checkpoints; }
          bool before_last_checkpoint()const;
 
+         /**
+          * @brief Use a pool of threads to recover the signing keys of all transactions in a block pushed by
+          * @ref push_block before the block is applied, leaving only the authority check to the serial apply loop
+          * @param thread_count Number of worker threads, 0 recovers keys inline while applying each transaction
+          */
+         void set_signature_recovery_threads( uint32_t thread_count );
+         /**
+          * Computes ids, merkle root and, if signatures are checked, signing keys of b on the signature recovery
+          * threads.  The result refers to b rather than copying it, so b must outlive it.
+          */
+         precomputed_block precompute_block( const signed_block& b, uint32_t skip = skip_nothing )const;
+
+         /**
+          * @brief Use a pool of threads to tally the votes of all accounts during chain maintenance, each thread
+          * taking a range of accounts.  Fees are still processed serially and the tally is the same as without threads.
+          * @param thread_count Number of worker threads, 0 tallies votes in the serial pass over accounts
+          */
+         void set_maintenance_threads( uint32_t thread_count );
+
+         /**
+          * @brief Use a pool of threads for the checks of transactions pushed by @ref admit_transaction that do not
+          * depend on chain state, i.e. validate(), the id and signing key recovery
+          * @param thread_count Number of worker threads, 0 makes admit_transaction call push_transaction directly
+          * @param queue_depth Maximum number of transactions being admitted at once, further ones are rejected
+          */
+         void set_transaction_admission( uint32_t thread_count, uint32_t queue_depth );
+         /**
+          * Pushes trx like push_transaction, but checks it on a transaction admission thread first and only applies
+          * it on the calling thread.  Other tasks of the calling thread, e.g. pushing blocks or admitting more
+          * transactions, keep running while the check is done.  Must be called from the thread using the database.
+          */
+         processed_transaction admit_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+         const transaction_admission_stats& get_transaction_admission_stats()const { return _admission_stats; }
+
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
          processed_transaction push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+         /// pushes trx.trx using the values computed ahead of time
+         processed_transaction push_transaction( const precomputed_transaction& trx, uint32_t skip = skip_nothing );
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
+         bool _push_block( const signed_block& b, const precomputed_block* precomputed );
 
          ///@throws fc::exception if the proposed transaction fails to apply.
          processed_transaction push_proposal( const proposal_object& proposal );
@@ -170,6 +281,11 @@ namespace graphene { namespace chain {
          uint32_t  push_applied_operation( const operation& op );
          void      set_applied_operation_result( uint32_t op_id, const operation_result& r );
          const vector<optional< operation_history_object > >& get_applied_operations()const;
+         /**
+          *  The ids of the transactions of the block being applied, in block order, as computed while applying
+          *  them.  Like get_applied_operations() it is meant for applied_block observers.
+          */
+         const vector<transaction_id_type>& get_applied_transaction_ids()const { return _applied_trx_ids; }
 
          string to_pretty_string( const asset& a )const;
 
@@ -206,6 +322,13 @@ namespace graphene { namespace chain {
           */
          fc::signal<void(const vector<object_id_type>&, const vector<const object*>&, const flat_set<account_id_type>&)>  removed_objects;
 
+         /**
+          *  Receives an applied_block_event after each block has been applied, for observers that do not need to
+          *  run before the next block is applied.  The events are only built while the queue has consumers.
+          */
+         block_event_queue& block_events() { return _block_events; }
+         const block_event_queue& block_events()const { return _block_events; }
+
          //////////////////// db_witness_schedule.cpp ////////////////////
 
          /**
@@ -388,10 +511,15 @@ namespace graphene { namespace chain {
          //////////////////// db_incentive.cpp ////////////////////
          signed_transaction generate_incentive_transaction();
          processed_transaction apply_incentive(const processed_transaction &tx);
+         const incentive_scheduler& get_incentive_scheduler()const { return _incentive_scheduler; }
 
          //////////////////// db_deflation.cpp ////////////////////
          signed_transaction generate_deflation_transaction();
          processed_transaction apply_deflation(const processed_transaction &tx);
+         /// one account_deflation_operation or order_deflation_operation per account or order
+         void generate_deflation_operations(const deflation_object &dflt, signed_transaction &tx);
+         /// one bulk operation covering the next range of accounts and one covering the next range of orders
+         void generate_bulk_deflation_operations(const deflation_object &dflt, signed_transaction &tx);
 
          ///@}
          /**
@@ -412,6 +540,7 @@ namespace graphene { namespace chain {
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
          void pop_undo() { object_database::pop_undo(); }
          void notify_changed_objects();
+         void push_block_event( const signed_block& b );
 
       private:
          optional<undo_database::session>       _pending_tx_session;
@@ -425,10 +554,14 @@ namespace graphene { namespace chain {
        public:
          // these were formerly private, but they have a fairly well-defined API, so let's make them public
          void                  apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
+         /// Same as above, but uses the block id, merkle root and transaction ids computed ahead of time
+         void                  apply_block( const precomputed_block& next_block, uint32_t skip = skip_nothing );
          processed_transaction apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          operation_result      apply_operation( transaction_evaluation_state& eval_state, const operation& op );
       private:
          void                  _apply_block( const signed_block& next_block );
+         /// next_block.id(), taken from _precomputed_block when that is the block being applied
+         block_id_type         applying_block_id( const signed_block& next_block )const;
          processed_transaction _apply_transaction( const signed_transaction& trx );
 
          ///Steps involved in applying a new block
@@ -436,10 +569,10 @@ namespace graphene { namespace chain {
 
          const witness_object& validate_block_header( uint32_t skip, const signed_block& next_block )const;
          const witness_object& _validate_block_header( const signed_block& next_block )const;
-         void create_block_summary(const signed_block& next_block);
+         void create_block_summary(const signed_block& next_block, const block_id_type& next_block_id);
 
          //////////////////// db_update.cpp ////////////////////
-         void update_global_dynamic_data( const signed_block& b );
+         void update_global_dynamic_data( const signed_block& b, const block_id_type& b_id );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
          void clear_expired_transactions();
@@ -467,6 +600,10 @@ namespace graphene { namespace chain {
 
          template<class... Types>
          void perform_account_maintenance(std::tuple<Types...> helpers);
+         /// Same result as perform_account_maintenance(std::tie(tally_helper, fee_helper)), with votes tallied on
+         /// the maintenance threads
+         template<class TallyHelper, class FeeHelper>
+         void perform_sharded_account_maintenance(TallyHelper& tally_helper, FeeHelper& fee_helper);
          ///@}
          ///@}
 
@@ -482,7 +619,7 @@ namespace graphene { namespace chain {
           *  until the fork is resolved.  This should make maintaining
           *  the fork tree relatively simple.
           */
-         block_database   _block_id_to_block;
+         mapped_block_database   _block_id_to_block;
 
          /**
           * Contains the set of ops that are in the process of being applied from
@@ -491,6 +628,31 @@ namespace graphene { namespace chain {
           * emited.
           */
         vector<optional<operation_history_object> >  _applied_ops;
+         vector<transaction_id_type>       _applied_trx_ids;
+         /// id of the transaction last applied by _apply_transaction()
+         transaction_id_type               _current_trx_id;
+
+         /// set while apply_block() applies a precomputed_block, nullptr otherwise
+         const precomputed_block*          _precomputed_block    = nullptr;
+         /// set while push_transaction() pushes a precomputed_transaction, nullptr otherwise
+         const precomputed_transaction*    _precomputed_transaction = nullptr;
+         uint32_t                          _replay_worker_threads = 2;
+         uint32_t                          _replay_queue_depth   = 64;
+         vector< std::unique_ptr<fc::thread> > _signature_recovery_threads;
+         vector< std::unique_ptr<fc::thread> > _maintenance_threads;
+         vector< std::unique_ptr<fc::thread> > _transaction_admission_threads;
+         uint32_t                          _next_admission_thread = 0;
+         transaction_admission_stats       _admission_stats;
+         block_event_queue                 _block_events;
+
+         /// bodies of the transactions applied last, for get_recent_transaction()
+         std::unordered_map< transaction_id_type, signed_transaction > _recent_transactions;
+         /// ids in _recent_transactions, oldest first
+         std::deque< transaction_id_type >  _recent_transaction_order;
+         uint32_t                          _recent_transaction_cache_size = GRAPHENE_DEFAULT_RECENT_TRANSACTION_CACHE_SIZE;
+         fc::microseconds                  _flush_changes_interval;
+         fc::time_point                    _next_flush_changes;
+         incentive_scheduler               _incentive_scheduler;
 
          uint32_t                          _current_block_num    = 0;
          uint16_t                          _current_trx_in_block = 0;
@@ -527,3 +689,6 @@ namespace graphene { namespace chain {
    }
 
 } }
+
+FC_REFLECT( graphene::chain::transaction_admission_stats,
+            (queue_depth)(max_queue_depth)(admitted)(rejected_queue_full)(rejected_invalid)(rejected_apply) )
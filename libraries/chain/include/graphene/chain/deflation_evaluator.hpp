@@ -29,6 +29,8 @@
 #include <graphene/chain/database.hpp>
 
 namespace graphene { namespace chain {
+    class deflation_object;
+
     class deflation_evaluator : public evaluator<deflation_evaluator> {
     public:
         typedef deflation_operation operation_type;
@@ -52,6 +54,26 @@ namespace graphene { namespace chain {
         void_result do_evaluate( const order_deflation_operation& o );
         void_result do_apply( const order_deflation_operation& o ) ;
     };
+
+    class account_bulk_deflation_evaluator : public evaluator<account_bulk_deflation_evaluator> {
+    public:
+        typedef account_bulk_deflation_operation operation_type;
+
+        void_result do_evaluate( const account_bulk_deflation_operation& o );
+        asset do_apply( const account_bulk_deflation_operation& o ) ;
+
+        const deflation_object* _deflation = nullptr;
+    };
+
+    class order_bulk_deflation_evaluator : public evaluator<order_bulk_deflation_evaluator> {
+    public:
+        typedef order_bulk_deflation_operation operation_type;
+
+        void_result do_evaluate( const order_bulk_deflation_operation& o );
+        asset do_apply( const order_bulk_deflation_operation& o ) ;
+
+        const deflation_object* _deflation = nullptr;
+    };
 }} // graphene::chain
 
 
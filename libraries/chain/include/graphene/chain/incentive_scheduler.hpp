@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/incentive.hpp>
+
+#include <unordered_map>
+
+namespace graphene { namespace chain {
+
+   class database;
+   class construction_capital_object;
+
+   /**
+    *  Selects the incentive operations database::generate_incentive_transaction() puts into a block.
+    *
+    *  Construction capital due by period is read from the front of the by_next_slot index and capital
+    *  with pending vote incentives from the top of the by_pending index.  Both walks stop as soon as
+    *  max_incentive_operations_per_block operations are selected, so the cost of a block is bounded by
+    *  that limit and not by the number of construction capital objects.  Objects that were left out stay
+    *  at the front of their index and are picked up by the next block; when a block was cut short the
+    *  next one starts with the other kind of incentive, so that neither can starve the other.
+    *
+    *  Payouts computed while selecting are kept until the next selection and handed to
+    *  incentive_evaluator, which therefore does not recompute them for blocks produced locally.
+    */
+   class incentive_scheduler
+   {
+      public:
+         /// The incentive paid for one period of @ref cc at the given issuance rate
+         static share_type compute_payout( const construction_capital_object& cc, uint32_t issuance_rate );
+
+         /// Same as compute_payout(), served from the payouts of the last selection when possible
+         share_type payout( const construction_capital_object& cc, uint32_t issuance_rate )const;
+
+         /// Selects the incentive operations for the next block on top of the current state of @ref db
+         vector<incentive_operation> schedule( const database& db );
+
+      private:
+         struct cached_payout
+         {
+            share_type  amount;
+            uint32_t    period          = 0;
+            uint16_t    total_periods   = 0;
+            uint32_t    issuance_rate   = 0;
+            share_type  payout;
+         };
+
+         share_type cache_payout( const construction_capital_object& cc, uint32_t issuance_rate );
+
+         /// keyed by construction capital instance; the inputs are kept so a stale entry is never used
+         std::unordered_map<uint64_t, cached_payout> _payouts;
+         /// true if the next block should select vote incentives before period incentives
+         bool                                         _votes_first = false;
+   };
+
+} }
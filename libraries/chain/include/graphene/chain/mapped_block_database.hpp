@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/block_database.hpp>
+
+#include <boost/thread/shared_mutex.hpp>
+
+#include <memory>
+
+namespace boost { namespace interprocess {
+   class file_mapping;
+   class mapped_region;
+} }
+
+namespace graphene { namespace chain {
+
+   namespace detail { struct mapped_file; }
+
+   /**
+    *  @class mapped_block_database
+    *  @brief block_database backend that memory maps the index and blocks files
+    *
+    *  The on-disk layout is identical to block_database, so a data directory written by one
+    *  can be opened by the other.  Lookups are pointer arithmetic into the mapped index and
+    *  blocks are unpacked straight out of the mapping.
+    *
+    *  Any number of threads may read concurrently; store() and remove() must only be called
+    *  from a single writer.  The files are always kept at their logical size, while the
+    *  mappings reserve address space in chunks ahead of the end of file so that most appends
+    *  do not need to remap.
+    */
+   class mapped_block_database
+   {
+      public:
+         mapped_block_database();
+         ~mapped_block_database();
+
+         void open( const fc::path& dbdir );
+         bool is_open()const;
+         void flush();
+         void close();
+
+         void store( const block_id_type& id, const signed_block& b );
+         void remove( const block_id_type& id );
+
+         bool                   contains( const block_id_type& id )const;
+         block_id_type          fetch_block_id( uint32_t block_num )const;
+         optional<signed_block> fetch_optional( const block_id_type& id )const;
+         optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /// @return the block as it is stored, i.e. serialized with fc::raw::pack, without unpacking it
+         optional<vector<char>> fetch_packed( const block_id_type& id )const;
+         optional<vector<char>> fetch_packed_by_number( uint32_t block_num )const;
+         /**
+          *  Appends the packed blocks first_block_num, first_block_num + 1, ... to data and their sizes to sizes,
+          *  stopping before the first missing block, after max_blocks blocks or before max_bytes would be exceeded,
+          *  but always taking at least one block if there is one.  Blocks stored next to each other, which they are
+          *  unless a fork replaced some of them, are copied with a single copy per run.
+          *  @return the number of blocks appended
+          */
+         uint32_t               fetch_packed_range( uint32_t first_block_num, uint32_t max_blocks, uint64_t max_bytes,
+                                                    vector<char>& data, vector<uint32_t>& sizes )const;
+         optional<signed_block> last()const;
+         optional<block_id_type> last_id()const;
+
+      private:
+         /// @return pointer to the index entry of block_num, or nullptr if it is past the end of the index
+         const index_entry*     entry_for( uint32_t block_num )const;
+         /// @return the last entry that refers to a stored block, or nullptr if there is none
+         const index_entry*     last_entry()const;
+         signed_block           unpack_block( const index_entry& e )const;
+
+         std::unique_ptr<detail::mapped_file> _index;
+         std::unique_ptr<detail::mapped_file> _blocks;
+
+         /// readers hold this shared, store()/remove()/close() hold it exclusively
+         mutable boost::shared_mutex          _mutex;
+   };
+} }
@@ -154,6 +154,38 @@ typedef multi_index_container<
 
 typedef generic_index<limit_order_object, limit_order_multi_index_type> limit_order_index;
 
+/**
+ *  @brief This secondary index aggregates the limit orders of every market into price levels, so that
+ *  the depth of a book can be read without visiting each order.
+ *
+ *  Levels are keyed by the sell_price of the orders in them and hold the total amount for sale at that
+ *  price.  Orders selling base for quote and orders selling quote for base are kept apart, keyed by
+ *  (sell asset, receive asset), and each side is ordered best price first like the by_price index.
+ */
+class limit_order_depth_index : public secondary_index
+{
+   public:
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after  ) override;
+
+      typedef std::map< price, share_type, std::greater<price> > depth_side;
+
+      /** @return the levels of orders selling @ref sell_asset for @ref receive_asset, or nullptr if there are none */
+      const depth_side* get_side( asset_id_type sell_asset, asset_id_type receive_asset )const;
+
+      /** incremented whenever a level of the market changes, so readers can tell whether the book moved */
+      uint64_t get_revision( const pair<asset_id_type,asset_id_type>& market )const;
+
+   private:
+      void add( const limit_order_object& order, share_type amount );
+
+      map< pair<asset_id_type,asset_id_type>, depth_side >  _sides;
+      map< pair<asset_id_type,asset_id_type>, uint64_t >    _revisions;
+      share_type                                            _for_sale_before_modify;
+};
+
 /**
  * @class call_order_object
  * @brief tracks debt and call price information
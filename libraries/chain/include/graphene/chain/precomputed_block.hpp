@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/chain/protocol/block.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    *  A signed_block together with the values database::apply_block() derives from the
+    *  block contents alone.  None of them depend on chain state, so they can be computed
+    *  on a worker thread ahead of application, e.g. by the replay pipeline of
+    *  database::reindex().
+    */
+   struct precomputed_block
+   {
+      precomputed_block() {}
+      explicit precomputed_block( signed_block b );
+
+      /// the block the values were computed from, the caller's block if source is set
+      const signed_block& get_block()const { return source ? *source : block; }
+
+      /// owned copy of the block, empty if source is set
+      signed_block                  block;
+      /// a block owned by the caller, which must outlive this, e.g. the one passed to database::push_block()
+      const signed_block*           source = nullptr;
+      block_id_type                 id;
+      checksum_type                 merkle_root;
+      /// id() of each entry of get_block().transactions
+      vector<transaction_id_type>   trx_ids;
+      /**
+       * get_signature_keys() of each entry of get_block().transactions.  May be empty, and entries are left
+       * unset where recovery failed, so that the authority check reports the error while applying.
+       */
+      vector< optional< flat_set<public_key_type> > > signees;
+   };
+
+   /**
+    *  A signed_transaction together with the checks and values database::_apply_transaction() derives from the
+    *  transaction alone, computed by database::admit_transaction() on a transaction admission thread.
+    */
+   struct precomputed_transaction
+   {
+      precomputed_transaction() {}
+      /**
+       * Validates t and computes its id and, if recover_keys is set, its signing keys
+       * @throws fc::exception if t is invalid or a signature can not be recovered
+       */
+      precomputed_transaction( signed_transaction t, const chain_id_type& chain_id, bool recover_keys );
+
+      signed_transaction                    trx;
+      transaction_id_type                   id;
+      /// get_signature_keys() of trx, unset if keys were not recovered
+      optional< flat_set<public_key_type> > signees;
+   };
+
+} }
@@ -110,6 +110,64 @@ namespace graphene { namespace chain {
         share_type      calculate_fee(const fee_parameters_type& k)const { return 0; }
     };
 
+   /**
+    * @ingroup operations
+    * @brief Deflate the balances of a range of accounts
+    *
+    * Has the effect of one account_deflation_operation for every account from @ref first to @ref last,
+    * applied in a single pass.  The total amount deflated is returned as the operation result, and a
+    * virtual account_deflation_operation is emitted for every account with a non-zero amount deflated.
+    */    
+    struct account_bulk_deflation_operation : public base_operation {
+        struct fee_parameters_type {uint64_t fee = 0; };
+        
+        account_bulk_deflation_operation() {}
+
+        asset fee;                          //this is virtual operation, no fee is charged
+        deflation_id_type deflation_id;
+        account_id_type first;
+        account_id_type last;
+
+        account_id_type fee_payer() const {
+            return GRAPHENE_TEMP_ACCOUNT;
+        }
+
+        void validate() const;
+
+        /// This is a virtual operation; there is no fee
+        share_type      calculate_fee(const fee_parameters_type& k)const { return 0; }
+    };
+
+   /**
+    * @ingroup operations
+    * @brief Deflate the limit orders in a range of order ids
+    *
+    * Has the effect of one order_deflation_operation for every limit order from @ref first to @ref last,
+    * applied in a single pass.  The total amount deflated is returned as the operation result, and a
+    * virtual order_deflation_operation is emitted for every order with a non-zero amount deflated.  A range that
+    * starts past the last order of the deflation, which was removed before it was reached, only ends order
+    * deflation; it must then hold that single id.
+    */    
+    struct order_bulk_deflation_operation : public base_operation {
+        struct fee_parameters_type {uint64_t fee = 0; };
+        
+        order_bulk_deflation_operation() {}
+
+        asset fee;                          //this is virtual operation, no fee is charged
+        deflation_id_type deflation_id;
+        limit_order_id_type first;
+        limit_order_id_type last;
+
+        account_id_type fee_payer() const {
+            return GRAPHENE_TEMP_ACCOUNT;
+        }
+
+        void validate() const;
+
+        /// This is a virtual operation; there is no fee
+        share_type      calculate_fee(const fee_parameters_type& k)const { return 0; }
+    };
+
 }} // graphene::chain
 
 FC_REFLECT( graphene::chain::deflation_operation::fee_parameters_type, (fee) )
@@ -123,3 +181,11 @@ FC_REFLECT( graphene::chain::account_deflation_operation, (fee)(deflation_id)(ow
 FC_REFLECT( graphene::chain::order_deflation_operation::fee_parameters_type, (fee) )
 
 FC_REFLECT( graphene::chain::order_deflation_operation, (fee)(deflation_id)(order)(owner)(amount) )
+
+FC_REFLECT( graphene::chain::account_bulk_deflation_operation::fee_parameters_type, (fee) )
+
+FC_REFLECT( graphene::chain::account_bulk_deflation_operation, (fee)(deflation_id)(first)(last) )
+
+FC_REFLECT( graphene::chain::order_bulk_deflation_operation::fee_parameters_type, (fee) )
+
+FC_REFLECT( graphene::chain::order_bulk_deflation_operation, (fee)(deflation_id)(first)(last) )
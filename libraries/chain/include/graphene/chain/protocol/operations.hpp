@@ -105,7 +105,9 @@ namespace graphene { namespace chain {
             construction_capital_rate_vote_operation,
             deflation_operation,
             account_deflation_operation,
-            order_deflation_operation
+            order_deflation_operation,
+            account_bulk_deflation_operation,
+            order_bulk_deflation_operation
          > operation;
 
    /// @} // operations group
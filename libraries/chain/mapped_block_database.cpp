@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/mapped_block_database.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <fstream>
+
+namespace graphene { namespace chain {
+
+namespace bip = boost::interprocess;
+
+namespace detail {
+
+   /**
+    *  A file which is mapped read/write with capacity >= size.  The bytes in [size, capacity)
+    *  lie past the end of file and must not be touched until the file has been resized.
+    */
+   struct mapped_file
+   {
+      fc::path                             path;
+      uint64_t                             chunk_size = 0;
+      uint64_t                             size = 0;
+      uint64_t                             capacity = 0;
+      std::unique_ptr<bip::file_mapping>   mapping;
+      std::unique_ptr<bip::mapped_region>  region;
+
+      mapped_file( const fc::path& p, uint64_t chunk ) : path(p), chunk_size(chunk)
+      {
+         if( !fc::exists( path ) )
+            std::ofstream( path.generic_string().c_str(), std::ofstream::binary | std::ofstream::trunc );
+         size = fc::file_size( path );
+         mapping.reset( new bip::file_mapping( path.generic_string().c_str(), bip::read_write ) );
+         remap( size );
+      }
+
+      char* data()const { return static_cast<char*>( region->get_address() ); }
+
+      void remap( uint64_t min_capacity )
+      {
+         region.reset();
+         capacity = ( min_capacity / chunk_size + 1 ) * chunk_size;
+         region.reset( new bip::mapped_region( *mapping, bip::read_write, 0, capacity ) );
+      }
+
+      /// grow or shrink the file to new_size, remapping if it no longer fits in the reserved capacity
+      void resize( uint64_t new_size )
+      {
+         if( new_size > capacity )
+            remap( new_size );
+         fc::resize_file( path, new_size );
+         size = new_size;
+      }
+
+      void flush()
+      {
+         if( size > 0 )
+            region->flush( 0, size, false );
+      }
+   };
+
+} // detail
+
+mapped_block_database::mapped_block_database() {}
+
+mapped_block_database::~mapped_block_database()
+{
+   close();
+}
+
+void mapped_block_database::open( const fc::path& dbdir )
+{ try {
+   boost::unique_lock<boost::shared_mutex> lock( _mutex );
+   fc::create_directories(dbdir);
+
+   if( !fc::exists( dbdir/"index" ) )
+   {
+      fc::remove_all( dbdir/"blocks" );
+   }
+   _index.reset( new detail::mapped_file( dbdir/"index", sizeof(index_entry) * 1024 * 1024 ) );
+   _blocks.reset( new detail::mapped_file( dbdir/"blocks", 256 * 1024 * 1024 ) );
+} FC_CAPTURE_AND_RETHROW( (dbdir) ) }
+
+bool mapped_block_database::is_open()const
+{
+   return _blocks != nullptr;
+}
+
+void mapped_block_database::close()
+{
+   boost::unique_lock<boost::shared_mutex> lock( _mutex );
+   if( _blocks )
+      _blocks->flush();
+   if( _index )
+      _index->flush();
+   _blocks.reset();
+   _index.reset();
+}
+
+void mapped_block_database::flush()
+{
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   if( !_blocks )
+      return;
+   _blocks->flush();
+   _index->flush();
+}
+
+void mapped_block_database::store( const block_id_type& _id, const signed_block& b )
+{
+   block_id_type id = _id;
+   if( id == block_id_type() )
+   {
+      id = b.id();
+      elog( "id argument of mapped_block_database::store() was not initialized for block ${id}", ("id", id) );
+   }
+   auto num = block_header::num_from_id(id);
+   const uint64_t block_size = fc::raw::pack_size( b );
+
+   boost::unique_lock<boost::shared_mutex> lock( _mutex );
+
+   index_entry e;
+   e.block_pos  = _blocks->size;
+   e.block_size = block_size;
+   e.block_id   = id;
+
+   _blocks->resize( e.block_pos + block_size );
+   fc::datastream<char*> ds( _blocks->data() + e.block_pos, block_size );
+   fc::raw::pack( ds, b );
+
+   const uint64_t index_pos = sizeof(index_entry) * num;
+   if( _index->size < index_pos + sizeof(index_entry) )
+      _index->resize( index_pos + sizeof(index_entry) );
+   memcpy( _index->data() + index_pos, &e, sizeof(e) );
+}
+
+void mapped_block_database::remove( const block_id_type& id )
+{ try {
+   boost::unique_lock<boost::shared_mutex> lock( _mutex );
+   index_entry* e = const_cast<index_entry*>( entry_for( block_header::num_from_id(id) ) );
+   if( e == nullptr )
+      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
+
+   if( e->block_id == id )
+      e->block_size = 0;
+} FC_CAPTURE_AND_RETHROW( (id) ) }
+
+const index_entry* mapped_block_database::entry_for( uint32_t block_num )const
+{
+   const uint64_t index_pos = sizeof(index_entry) * block_num;
+   if( _index->size < index_pos + sizeof(index_entry) )
+      return nullptr;
+   return reinterpret_cast<const index_entry*>( _index->data() + index_pos );
+}
+
+const index_entry* mapped_block_database::last_entry()const
+{
+   const index_entry* first = reinterpret_cast<const index_entry*>( _index->data() );
+   const index_entry* e = first + _index->size / sizeof(index_entry);
+   while( e != first )
+   {
+      --e;
+      if( e->block_size != 0 )
+         return e;
+   }
+   return nullptr;
+}
+
+signed_block mapped_block_database::unpack_block( const index_entry& e )const
+{
+   FC_ASSERT( e.block_pos + e.block_size <= _blocks->size, "Block extends past the end of block_database (maybe corrupt on disk?)" );
+   fc::datastream<const char*> ds( _blocks->data() + e.block_pos, e.block_size );
+   signed_block result;
+   fc::raw::unpack( ds, result );
+   return result;
+}
+
+bool mapped_block_database::contains( const block_id_type& id )const
+{
+   if( id == block_id_type() )
+      return false;
+
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   const index_entry* e = entry_for( block_header::num_from_id(id) );
+   return e != nullptr && e->block_id == id && e->block_size > 0;
+}
+
+block_id_type mapped_block_database::fetch_block_id( uint32_t block_num )const
+{
+   assert( block_num != 0 );
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   const index_entry* e = entry_for( block_num );
+   if( e == nullptr )
+      FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
+
+   FC_ASSERT( e->block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return e->block_id;
+}
+
+optional<signed_block> mapped_block_database::fetch_optional( const block_id_type& id )const
+{
+   try
+   {
+      boost::shared_lock<boost::shared_mutex> lock( _mutex );
+      const index_entry* e = entry_for( block_header::num_from_id(id) );
+      if( e == nullptr || e->block_id != id || e->block_size == 0 )
+         return optional<signed_block>();
+
+      auto result = unpack_block( *e );
+      FC_ASSERT( result.id() == e->block_id );
+      return result;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<signed_block>();
+}
+
+optional<signed_block> mapped_block_database::fetch_by_number( uint32_t block_num )const
+{
+   try
+   {
+      boost::shared_lock<boost::shared_mutex> lock( _mutex );
+      const index_entry* e = entry_for( block_num );
+      if( e == nullptr || e->block_size == 0 )
+         return optional<signed_block>();
+
+      auto result = unpack_block( *e );
+      FC_ASSERT( result.id() == e->block_id );
+      return result;
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<signed_block>();
+}
+
+optional<vector<char>> mapped_block_database::fetch_packed( const block_id_type& id )const
+{
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   const index_entry* e = entry_for( block_header::num_from_id(id) );
+   if( e == nullptr || e->block_id != id || e->block_size == 0 || e->block_pos + e->block_size > _blocks->size )
+      return optional<vector<char>>();
+   const char* begin = _blocks->data() + e->block_pos;
+   return vector<char>( begin, begin + e->block_size );
+}
+
+optional<vector<char>> mapped_block_database::fetch_packed_by_number( uint32_t block_num )const
+{
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   const index_entry* e = entry_for( block_num );
+   if( e == nullptr || e->block_size == 0 || e->block_pos + e->block_size > _blocks->size )
+      return optional<vector<char>>();
+   const char* begin = _blocks->data() + e->block_pos;
+   return vector<char>( begin, begin + e->block_size );
+}
+
+uint32_t mapped_block_database::fetch_packed_range( uint32_t first_block_num, uint32_t max_blocks, uint64_t max_bytes,
+                                                    vector<char>& data, vector<uint32_t>& sizes )const
+{
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   uint32_t count = 0;
+   uint64_t bytes = 0;
+   uint64_t run_pos = 0;
+   uint64_t run_size = 0;
+   for( ; count < max_blocks; ++count )
+   {
+      const index_entry* e = entry_for( first_block_num + count );
+      if( e == nullptr || e->block_size == 0 || e->block_pos + e->block_size > _blocks->size )
+         break;
+      if( count > 0 && bytes + e->block_size > max_bytes )
+         break;
+      if( run_size > 0 && e->block_pos != run_pos + run_size )
+      {
+         data.insert( data.end(), _blocks->data() + run_pos, _blocks->data() + run_pos + run_size );
+         run_size = 0;
+      }
+      if( run_size == 0 )
+         run_pos = e->block_pos;
+      run_size += e->block_size;
+      bytes += e->block_size;
+      sizes.push_back( e->block_size );
+   }
+   if( run_size > 0 )
+      data.insert( data.end(), _blocks->data() + run_pos, _blocks->data() + run_pos + run_size );
+   return count;
+}
+
+optional<signed_block> mapped_block_database::last()const
+{
+   try
+   {
+      boost::shared_lock<boost::shared_mutex> lock( _mutex );
+      const index_entry* e = last_entry();
+      if( e == nullptr )
+         return optional<signed_block>();
+      return unpack_block( *e );
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   return optional<signed_block>();
+}
+
+optional<block_id_type> mapped_block_database::last_id()const
+{
+   boost::shared_lock<boost::shared_mutex> lock( _mutex );
+   const index_entry* e = last_entry();
+   if( e == nullptr )
+      return optional<block_id_type>();
+   return e->block_id;
+}
+
+} }
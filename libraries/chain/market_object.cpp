@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/market_object.hpp>
+
+namespace graphene { namespace chain {
+
+void limit_order_depth_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const limit_order_object*>(&obj) );
+   const limit_order_object& order = static_cast<const limit_order_object&>(obj);
+   add( order, order.for_sale );
+}
+
+void limit_order_depth_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const limit_order_object*>(&obj) );
+   const limit_order_object& order = static_cast<const limit_order_object&>(obj);
+   add( order, -order.for_sale );
+}
+
+void limit_order_depth_index::about_to_modify( const object& before )
+{
+   assert( dynamic_cast<const limit_order_object*>(&before) );
+   const limit_order_object& order = static_cast<const limit_order_object&>(before);
+   // the sell price of an order never changes, only the amount left for sale
+   _for_sale_before_modify = order.for_sale;
+}
+
+void limit_order_depth_index::object_modified( const object& after )
+{
+   assert( dynamic_cast<const limit_order_object*>(&after) );
+   const limit_order_object& order = static_cast<const limit_order_object&>(after);
+   add( order, order.for_sale - _for_sale_before_modify );
+}
+
+void limit_order_depth_index::add( const limit_order_object& order, share_type amount )
+{
+   if( amount == 0 )
+      return;
+
+   auto& side = _sides[ std::make_pair( order.sell_price.base.asset_id, order.sell_price.quote.asset_id ) ];
+   auto level = side.find( order.sell_price );
+   if( level == side.end() )
+      level = side.emplace( order.sell_price, share_type() ).first;
+   level->second += amount;
+   if( level->second == 0 )
+      side.erase( level );
+
+   ++_revisions[ order.get_market() ];
+}
+
+const limit_order_depth_index::depth_side* limit_order_depth_index::get_side( asset_id_type sell_asset, asset_id_type receive_asset )const
+{
+   auto itr = _sides.find( std::make_pair( sell_asset, receive_asset ) );
+   if( itr == _sides.end() )
+      return nullptr;
+   return &itr->second;
+}
+
+uint64_t limit_order_depth_index::get_revision( const pair<asset_id_type,asset_id_type>& market )const
+{
+   auto itr = _revisions.find( market );
+   if( itr == _revisions.end() )
+      return 0;
+   return itr->second;
+}
+
+} } // graphene::chain
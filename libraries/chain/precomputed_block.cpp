@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/precomputed_block.hpp>
+#include <graphene/chain/protocol/fee_schedule.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+namespace graphene { namespace chain {
+
+precomputed_block::precomputed_block( signed_block b )
+   : block( std::move(b) )
+{
+   id = block.id();
+   merkle_root = block.calculate_merkle_root();
+   trx_ids.reserve( block.transactions.size() );
+   for( const auto& trx : block.transactions )
+      trx_ids.push_back( trx.id() );
+}
+
+precomputed_transaction::precomputed_transaction( signed_transaction t, const chain_id_type& chain_id, bool recover_keys )
+   : trx( std::move(t) )
+{
+   trx.validate();
+   id = trx.id();
+   if( recover_keys )
+      signees = trx.get_signature_keys( chain_id );
+}
+
+} }
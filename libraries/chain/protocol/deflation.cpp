@@ -34,4 +34,12 @@ namespace graphene { namespace chain {
     void order_deflation_operation::validate() const {
     }        
 
+    void account_bulk_deflation_operation::validate() const {
+        FC_ASSERT( !(last < first), "account range is empty" );
+    }
+
+    void order_bulk_deflation_operation::validate() const {
+        FC_ASSERT( !(last < first), "order range is empty" );
+    }
+
 } } // graphene::chain
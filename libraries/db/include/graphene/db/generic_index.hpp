@@ -112,6 +112,78 @@ namespace graphene { namespace chain {
          index_type  _indices;
    };
 
+   /**
+    *  A generic_index that also keeps a pointer to each object in a vector indexed by instance, so that
+    *  find() by id is an array lookup rather than a walk down the by_id tree.  All the views of
+    *  MultiIndexType are kept, including by_id for ordered iteration.
+    *
+    *  Removing an object leaves a null tombstone in its slot; instances aren't reused except when undo
+    *  puts the same object back.  This is meant for object types that are looked up by id on hot paths
+    *  and are rarely removed, since the vector is sized by the highest instance ever stored.
+    */
+   template<typename ObjectType, typename MultiIndexType>
+   class dense_generic_index : public generic_index<ObjectType, MultiIndexType>
+   {
+      typedef generic_index<ObjectType, MultiIndexType> base_index;
+
+      public:
+         virtual const object& insert( object&& obj )override
+         {
+            const object& result = base_index::insert( std::move(obj) );
+            set_slot( result );
+            return result;
+         }
+
+         virtual const object&  create(const std::function<void(object&)>& constructor )override
+         {
+            const object& result = base_index::create( constructor );
+            set_slot( result );
+            return result;
+         }
+
+         virtual void modify( const object& obj, const std::function<void(object&)>& m )override
+         {
+            const object_id_type id = obj.id;
+            try {
+               base_index::modify( obj, m );
+            } catch( ... ) {
+               // multi_index erases an object whose modification violates a constraint
+               if( base_index::find( id ) == nullptr )
+                  _objects_by_instance[id.instance()] = nullptr;
+               throw;
+            }
+         }
+
+         virtual void remove( const object& obj )override
+         {
+            const auto instance = obj.id.instance();
+            base_index::remove( obj );
+            _objects_by_instance[instance] = nullptr;
+         }
+
+         virtual const object* find( object_id_type id )const override
+         {
+            assert( id.space() == ObjectType::space_id );
+            assert( id.type() == ObjectType::type_id );
+
+            const auto instance = id.instance();
+            if( instance >= _objects_by_instance.size() ) return nullptr;
+            return _objects_by_instance[instance];
+         }
+
+      private:
+         void set_slot( const object& obj )
+         {
+            // multi_index nodes never move, so the pointer stays valid until the object is removed
+            const auto instance = obj.id.instance();
+            if( instance >= _objects_by_instance.size() )
+               _objects_by_instance.resize( instance + 1, nullptr );
+            _objects_by_instance[instance] = &obj;
+         }
+
+         std::vector< const object* > _objects_by_instance;
+   };
+
    /**
     * @brief An index type for objects which may be deleted
     *
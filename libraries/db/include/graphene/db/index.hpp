@@ -28,6 +28,7 @@
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
 #include <fstream>
+#include <unordered_set>
 
 namespace graphene { namespace db {
    class object_database;
@@ -96,6 +97,18 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Saves the objects created, modified or removed since the last save() or save_changes()
+          *  to a change file.
+          *
+          *  @return false without writing anything if nothing changed
+          */
+         virtual bool save_changes( const fc::path& db ) = 0;
+         /**
+          *  Applies a change file written by save_changes() on top of the objects loaded by open()
+          */
+         virtual void open_changes( const fc::path& db ) = 0;
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -164,6 +177,9 @@ namespace graphene { namespace db {
          /** called just after obj is modified */
          void on_modify( const object& obj );
 
+         /** called when obj is inserted back into the index by undo */
+         void on_insert( const object& obj );
+
          template<typename T>
          T* add_secondary_index()
          {
@@ -183,8 +199,13 @@ namespace graphene { namespace db {
          }
 
       protected:
+         /** records obj as changed since the last save, if the object_database tracks changes */
+         void mark_changed( const object& obj );
+
          vector< shared_ptr<index_observer> >   _observers;
          vector< unique_ptr<secondary_index> >  _sindex;
+         /** instances of the objects created, modified or removed since the last save */
+         std::unordered_set<uint64_t>           _changed_instances;
 
       private:
          object_database& _db;
@@ -257,6 +278,68 @@ namespace graphene { namespace db {
                 auto packed_vec = fc::raw::pack( vec );
                 out.write( packed_vec.data(), packed_vec.size() );
             });
+            _changed_instances.clear();
+         }
+
+         virtual bool save_changes( const path& db ) override
+         {
+            if( _changed_instances.empty() )
+               return false;
+
+            std::ofstream out( db.generic_string(),
+                               std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+            FC_ASSERT( out );
+            auto ver  = get_object_version();
+            fc::raw::pack( out, _next_id );
+            fc::raw::pack( out, ver );
+            for( uint64_t instance : _changed_instances )
+            {
+               const object* o = this->find( object_id_type( object_type::space_id, object_type::type_id, instance ) );
+               fc::raw::pack( out, instance );
+               fc::raw::pack( out, o != nullptr );
+               if( o != nullptr )
+               {
+                  // length prefixed like in save(), open_changes() reads it back into a vector<char> for load()
+                  auto vec = fc::raw::pack( static_cast<const object_type&>(*o) );
+                  fc::raw::pack( out, vec );
+               }
+            }
+            _changed_instances.clear();
+            return true;
+         }
+
+         virtual void open_changes( const path& db ) override
+         {
+            if( !fc::exists( db ) ) return;
+            fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
+            fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
+            fc::datastream<const char*> ds( (const char*)mr.get_address(), mr.get_size() );
+            fc::sha256 open_ver;
+
+            fc::raw::unpack(ds, _next_id);
+            fc::raw::unpack(ds, open_ver);
+            FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
+
+            vector<char> tmp;
+            while( ds.remaining() > 0 )
+            {
+               uint64_t instance;
+               bool     present;
+               fc::raw::unpack( ds, instance );
+               fc::raw::unpack( ds, present );
+               const object* existing = this->find( object_id_type( object_type::space_id, object_type::type_id, instance ) );
+               if( existing != nullptr )
+               {
+                  for( const auto& item : _sindex )
+                     item->object_removed( *existing );
+                  DerivedIndex::remove( *existing );
+               }
+               if( present )
+               {
+                  fc::raw::unpack( ds, tmp );
+                  load( tmp );
+               }
+            }
          }
 
          virtual const object&  load( const std::vector<char>& data )override
@@ -268,6 +351,15 @@ namespace graphene { namespace db {
          }
 
 
+         virtual const object&  insert( object&& obj )override
+         {
+            const auto& result = DerivedIndex::insert( std::move(obj) );
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            on_insert( result );
+            return result;
+         }
+
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
             const auto& result = DerivedIndex::create( constructor );
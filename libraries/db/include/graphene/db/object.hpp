@@ -76,6 +76,10 @@ namespace graphene { namespace db {
          virtual variant            to_variant()const  = 0;
          virtual vector<char>       pack()const = 0;
          virtual fc::uint128        hash()const = 0;
+         /// appends the packed object to buffer
+         virtual void               pack_to( vector<char>& buffer )const = 0;
+         /// replaces this object with the one packed in ds
+         virtual void               unpack_from( fc::datastream<const char*>& ds ) = 0;
    };
 
    /**
@@ -100,6 +104,21 @@ namespace graphene { namespace db {
          }
          virtual variant to_variant()const { return variant( static_cast<const DerivedClass&>(*this) ); }
          virtual vector<char> pack()const  { return fc::raw::pack( static_cast<const DerivedClass&>(*this) ); }
+         virtual void pack_to( vector<char>& buffer )const
+         {
+            const auto& self = static_cast<const DerivedClass&>(*this);
+            const size_t pos = buffer.size();
+            buffer.resize( pos + fc::raw::pack_size( self ) );
+            fc::datastream<char*> ds( buffer.data() + pos, buffer.size() - pos );
+            fc::raw::pack( ds, self );
+         }
+         virtual void unpack_from( fc::datastream<const char*>& ds )
+         {
+            // unpacking into a fresh object, since unpacking containers adds to whatever they hold
+            DerivedClass tmp;
+            fc::raw::unpack( ds, tmp );
+            static_cast<DerivedClass&>(*this) = std::move( tmp );
+         }
          virtual fc::uint128  hash()const  {  
              auto tmp = this->pack();
              return fc::city_hash_crc_128( tmp.data(), tmp.size() );
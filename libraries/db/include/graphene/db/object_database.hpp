@@ -48,8 +48,28 @@ namespace graphene { namespace db {
 
          /**
           * Saves the complete state of the object_database to disk, this could take a while
+          *
+          * This also compacts the snapshot, discarding the change segments written by flush_changes().
           */
          void flush();
+
+         /**
+          * Saves the objects created, modified or removed since the last flush() or flush_changes() as a new
+          * change segment on top of the full snapshot, so the cost depends on what changed rather than on the
+          * size of the state.  open() loads the full snapshot and replays the segments in order.
+          *
+          * Falls back to flush() if there is no complete snapshot on disk yet or max_change_segments() segments
+          * have been written since the last flush().
+          */
+         void flush_changes();
+
+         uint32_t max_change_segments()const { return _max_change_segments; }
+         void     set_max_change_segments( uint32_t count ) { _max_change_segments = count; }
+
+         /**
+          * @return true if data_dir holds a complete snapshot, i.e. the last flush() was not interrupted
+          */
+         static bool has_snapshot( const fc::path& data_dir );
          void wipe(const fc::path& data_dir); // remove from disk
          void close();
 
@@ -163,9 +183,15 @@ namespace graphene { namespace db {
          void save_undo( const object& obj );
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
+         void write_manifest( uint32_t change_segments )const;
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+
+         /** set while a complete snapshot exists on disk, so that indexes record which objects changed */
+         bool                                                      _track_changes = false;
+         uint32_t                                                  _change_segments = 0;
+         uint32_t                                                  _max_change_segments = 32;
    };
 
 } } // graphene::db
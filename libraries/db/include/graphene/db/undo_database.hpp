@@ -32,12 +32,30 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    *  Heads each pre-modification value in an undo_state's journal, followed by the packed object.
+    */
+   struct undo_journal_entry
+   {
+      object_id_type id;
+      uint32_t       size = 0;
+      /** cleared when the object is removed later in the same state, which stores its value in removed */
+      bool           live = true;
+   };
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
+      /** offset into journal of the pre-modification value of each object modified in this state */
+      unordered_map<object_id_type, size_t>              old_values;
       unordered_map<object_id_type, object_id_type>      old_index_next_ids;
       std::unordered_set<object_id_type>                 new_ids;
       unordered_map<object_id_type, unique_ptr<object> > removed;
+      /**
+       *  The packed values old_values refers to, one after another.  Keeping them in one buffer rather than
+       *  cloning each object saves an allocation per modified object, lets undo replay them in order, and
+       *  releases the whole state at once.
+       */
+      std::vector<char>                                  journal;
    };
 
 
@@ -131,17 +149,27 @@ namespace graphene { namespace db {
          size_t max_size()const { return _max_size; }
 
          const undo_state& head()const;
+         /** @return the value of obj before it was first modified in the head undo state, nullptr if it was not */
+         unique_ptr<object> head_old_value( const object& obj )const;
 
       private:
          void undo();
          void merge();
          void commit();
 
+         /** pushes a new undo_state, reusing the journal of one released earlier */
+         void push_state();
+         /** pops the newest (or oldest) undo_state, keeping its journal's memory for a later state */
+         void pop_state( bool newest = true );
+         /** restores every object modified, created or removed in the newest undo_state */
+         void apply_head_undo_state();
+
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
+         std::vector< std::vector<char> > _spare_journals;
    };
 
 } } // graphene::db
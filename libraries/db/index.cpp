@@ -27,16 +27,26 @@
 
 namespace graphene { namespace db {
    void base_primary_index::save_undo( const object& obj )
-   { _db.save_undo( obj ); }
+   { _db.save_undo( obj ); mark_changed( obj ); }
 
    void base_primary_index::on_add( const object& obj )
    {
       _db.save_undo_add( obj );
+      mark_changed( obj );
       for( auto ob : _observers ) ob->on_add( obj );
    }
 
    void base_primary_index::on_remove( const object& obj )
-   { _db.save_undo_remove( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
+   { _db.save_undo_remove( obj ); mark_changed( obj ); for( auto ob : _observers ) ob->on_remove( obj ); }
+
+   void base_primary_index::on_insert( const object& obj )
+   { mark_changed( obj ); }
+
+   void base_primary_index::mark_changed( const object& obj )
+   {
+      if( _db._track_changes )
+         _changed_instances.insert( obj.id.instance() );
+   }
 
    void base_primary_index::on_modify( const object& obj )
    {for( auto ob : _observers ) ob->on_modify(  obj ); }
@@ -27,6 +27,8 @@
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <fstream>
+
 namespace graphene { namespace db {
 
 object_database::object_database()
@@ -71,6 +73,8 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
+   // the snapshot is inconsistent until every index has been written
+   fc::remove_all( _data_dir / "object_database" / "manifest" );
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
       fc::create_directories( _data_dir / "object_database" / fc::to_string(space) );
@@ -79,6 +83,53 @@ void object_database::flush()
          if( _index[space][type] )
             _index[space][type]->save( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
    }
+   fc::remove_all( _data_dir / "object_database" / "changes" );
+   write_manifest( 0 );
+   _change_segments = 0;
+   _track_changes = true;
+}
+
+void object_database::flush_changes()
+{
+   if( !_track_changes || _change_segments >= _max_change_segments )
+   {
+      flush();
+      return;
+   }
+
+   const uint32_t segment = _change_segments + 1;
+   const fc::path segment_dir = _data_dir / "object_database" / "changes" / fc::to_string(segment);
+   fc::remove_all( segment_dir );
+   for( uint32_t space = 0; space < _index.size(); ++space )
+   {
+      const auto types = _index[space].size();
+      if( types == 0 )
+         continue;
+      fc::create_directories( segment_dir / fc::to_string(space) );
+      for( uint32_t type = 0; type  <  types; ++type )
+         if( _index[space][type] )
+            _index[space][type]->save_changes( segment_dir / fc::to_string(space)/fc::to_string(type) );
+   }
+   // the segment only becomes part of the snapshot once the manifest refers to it
+   write_manifest( segment );
+   _change_segments = segment;
+}
+
+void object_database::write_manifest( uint32_t change_segments )const
+{
+   const fc::path manifest = _data_dir / "object_database" / "manifest";
+   const fc::path tmp = _data_dir / "object_database" / "manifest.tmp";
+   {
+      std::ofstream out( tmp.generic_string(), std::ofstream::out | std::ofstream::trunc );
+      FC_ASSERT( out );
+      out << change_segments;
+   }
+   fc::rename( tmp, manifest );
+}
+
+bool object_database::has_snapshot( const fc::path& data_dir )
+{
+   return fc::exists( data_dir / "object_database" / "manifest" );
 }
 
 void object_database::wipe(const fc::path& data_dir)
@@ -93,11 +144,30 @@ void object_database::open(const fc::path& data_dir)
 { try {
    ilog("Opening object database from ${d} ...", ("d", data_dir));
    _data_dir = data_dir;
+   _change_segments = 0;
+   _track_changes = has_snapshot( _data_dir );
+   if( _track_changes )
+   {
+      std::ifstream in( (_data_dir / "object_database" / "manifest").generic_string() );
+      in >> _change_segments;
+   }
+
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
             _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
-   ilog( "Done opening object database." );
+
+   for( uint32_t segment = 1; segment <= _change_segments; ++segment )
+   {
+      const fc::path segment_dir = _data_dir / "object_database" / "changes" / fc::to_string(segment);
+      for( uint32_t space = 0; space < _index.size(); ++space )
+         for( uint32_t type = 0; type  < _index[space].size(); ++type )
+            if( _index[space][type] )
+               _index[space][type]->open_changes( segment_dir / fc::to_string(space)/fc::to_string(type) );
+   }
+   // a segment that was being written when we went down is not part of the snapshot
+   fc::remove_all( _data_dir / "object_database" / "changes" / fc::to_string(_change_segments + 1) );
+   ilog( "Done opening object database, replayed ${n} change segment(s).", ("n", _change_segments) );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
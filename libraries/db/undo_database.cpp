@@ -25,8 +25,56 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <cstring>
+
 namespace graphene { namespace db {
 
+/** released journals kept around so that new undo states don't have to grow a buffer from scratch */
+static const size_t max_spare_journals = 8;
+
+/** appends the value of obj to journal, @return the offset of its entry */
+static size_t journal_append( std::vector<char>& journal, const object& obj )
+{
+   const size_t offset = journal.size();
+   journal.resize( offset + sizeof(undo_journal_entry) );
+   obj.pack_to( journal );
+   undo_journal_entry entry;
+   entry.id = obj.id;
+   entry.size = journal.size() - offset - sizeof(undo_journal_entry);
+   memcpy( journal.data() + offset, &entry, sizeof(entry) );
+   return offset;
+}
+
+static undo_journal_entry journal_entry( const std::vector<char>& journal, size_t offset )
+{
+   undo_journal_entry entry;
+   memcpy( &entry, journal.data() + offset, sizeof(entry) );
+   return entry;
+}
+
+static void journal_unpack( const std::vector<char>& journal, size_t offset, object& obj )
+{
+   const auto entry = journal_entry( journal, offset );
+   fc::datastream<const char*> ds( journal.data() + offset + sizeof(entry), entry.size );
+   obj.unpack_from( ds );
+}
+
+static void journal_kill( std::vector<char>& journal, size_t offset )
+{
+   auto entry = journal_entry( journal, offset );
+   entry.live = false;
+   memcpy( journal.data() + offset, &entry, sizeof(entry) );
+}
+
+/** appends a copy of the entry at offset in from to to, @return its offset in to */
+static size_t journal_copy( const std::vector<char>& from, size_t offset, std::vector<char>& to )
+{
+   const auto entry = journal_entry( from, offset );
+   const size_t to_offset = to.size();
+   to.insert( to.end(), from.begin() + offset, from.begin() + offset + sizeof(entry) + entry.size );
+   return to_offset;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -38,21 +86,46 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
       _disabled = false;
 
    while( size() > max_size() )
-      _stack.pop_front();
+      pop_state( false );
 
-   _stack.emplace_back();
+   push_state();
    if (size() == 1) {
-       _stack.emplace_back();
+       push_state();
    }
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
+
+void undo_database::push_state()
+{
+   _stack.emplace_back();
+   if( !_spare_journals.empty() )
+   {
+      _stack.back().journal = std::move( _spare_journals.back() );
+      _spare_journals.pop_back();
+   }
+}
+
+void undo_database::pop_state( bool newest )
+{
+   undo_state& state = newest ? _stack.back() : _stack.front();
+   if( _spare_journals.size() < max_spare_journals )
+   {
+      state.journal.clear();
+      _spare_journals.push_back( std::move( state.journal ) );
+   }
+   if( newest )
+      _stack.pop_back();
+   else
+      _stack.pop_front();
+}
+
 void undo_database::on_create( const object& obj )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      push_state();
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
    auto itr = state.old_index_next_ids.find( index_id );
@@ -65,46 +138,50 @@ void undo_database::on_modify( const object& obj )
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      push_state();
    auto& state = _stack.back();
    if( state.new_ids.find(obj.id) != state.new_ids.end() )
       return;
    auto itr =  state.old_values.find(obj.id);
    if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   state.old_values[obj.id] = journal_append( state.journal, obj );
 }
 void undo_database::on_remove( const object& obj )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      push_state();
    undo_state& state = _stack.back();
    if( state.new_ids.count(obj.id) )
    {
       state.new_ids.erase(obj.id);
       return;
    }
-   if( state.old_values.count(obj.id) )
+   auto itr = state.old_values.find(obj.id);
+   if( itr != state.old_values.end() )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
-      state.old_values.erase(obj.id);
+      // the value to restore is the one from before the modification
+      unique_ptr<object> old_value = obj.clone();
+      journal_unpack( state.journal, itr->second, *old_value );
+      journal_kill( state.journal, itr->second );
+      state.removed[obj.id] = std::move(old_value);
+      state.old_values.erase(itr);
       return;
    }
    if( state.removed.count(obj.id) ) return;
    state.removed[obj.id] = obj.clone();
 }
 
-void undo_database::undo()
-{ try {
-   FC_ASSERT( !_disabled );
-   FC_ASSERT( _active_sessions > 0 );
-   disable();
-
+void undo_database::apply_head_undo_state()
+{
    auto& state = _stack.back();
-   for( auto& item : state.old_values )
+   for( size_t offset = 0; offset < state.journal.size(); )
    {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
+      const auto entry = journal_entry( state.journal, offset );
+      if( entry.live )
+         _db.modify( _db.get_object( entry.id ), [&]( object& obj ){ journal_unpack( state.journal, offset, obj ); } );
+      offset += sizeof(entry) + entry.size;
    }
 
    for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
@@ -119,10 +196,19 @@ void undo_database::undo()
 
    for( auto& item : state.removed )
       _db.insert( std::move(*item.second) );
+}
 
-   _stack.pop_back();
+void undo_database::undo()
+{ try {
+   FC_ASSERT( !_disabled );
+   FC_ASSERT( _active_sessions > 0 );
+   disable();
+
+   apply_head_undo_state();
+
+   pop_state();
    if( _stack.empty() )
-      _stack.emplace_back();
+      push_state();
    enable();
    --_active_sessions;
 } FC_CAPTURE_AND_RETHROW() }
@@ -176,23 +262,34 @@ void undo_database::merge()
 
    // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
 
-   // *+upd
-   for( auto& obj : state.old_values )
+   // *+upd, in journal order so the values are copied over linearly
+   for( size_t offset = 0; offset < state.journal.size(); )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      const auto entry = journal_entry( state.journal, offset );
+      const size_t next_offset = offset + sizeof(entry) + entry.size;
+      if( !entry.live )
+      {
+         // the object was removed later in B, which is handled with *+del below
+         offset = next_offset;
+         continue;
+      }
+      if( prev_state.new_ids.find(entry.id) != prev_state.new_ids.end() )
       {
          // new+upd -> new, type A
+         offset = next_offset;
          continue;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      if( prev_state.old_values.find(entry.id) != prev_state.old_values.end() )
       {
          // upd(was=X) + upd(was=Y) -> upd(was=X), type A
+         offset = next_offset;
          continue;
       }
       // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
+      assert( prev_state.removed.find(entry.id) == prev_state.removed.end() );
       // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
+      prev_state.old_values[entry.id] = journal_copy( state.journal, offset, prev_state.journal );
+      offset = next_offset;
    }
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
@@ -229,8 +326,10 @@ void undo_database::merge()
       if( it != prev_state.old_values.end() )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
+         journal_unpack( prev_state.journal, it->second, *obj.second );
+         journal_kill( prev_state.journal, it->second );
+         prev_state.removed[obj.first] = std::move(obj.second);
+         prev_state.old_values.erase(it);
          continue;
       }
       // del + del -> N/A
@@ -238,7 +337,7 @@ void undo_database::merge()
       // nop + del(was=Y) -> del(was=Y)
       prev_state.removed[obj.second->id] = std::move(obj.second);
    }
-   _stack.pop_back();
+   pop_state();
    --_active_sessions;
 }
 void undo_database::commit()
@@ -254,27 +353,8 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
-
-      _stack.pop_back();
+      apply_head_undo_state();
+      pop_state();
    }
    catch ( const fc::exception& e )
    {
@@ -290,4 +370,15 @@ const undo_state& undo_database::head()const
    return _stack.back();
 }
 
+unique_ptr<object> undo_database::head_old_value( const object& obj )const
+{
+   const auto& state = head();
+   auto itr = state.old_values.find( obj.id );
+   if( itr == state.old_values.end() )
+      return unique_ptr<object>();
+   auto result = obj.clone();
+   journal_unpack( state.journal, itr->second, *result );
+   return result;
+}
+
 } } // graphene::db
@@ -45,6 +45,52 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum fetch_compact_block_transactions_message::type = core_message_type_enum::fetch_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+
+  message make_packed_block_message( std::vector<char>&& packed_block, const block_id_type& block_id )
+  {
+     // block_message is the block followed by its id
+     const size_t block_size = packed_block.size();
+     packed_block.resize( block_size + fc::raw::pack_size( block_id ) );
+     fc::datastream<char*> ds( packed_block.data() + block_size, packed_block.size() - block_size );
+     fc::raw::pack( ds, block_id );
+     return message( block_message_type, std::move( packed_block ) );
+  }
+
+  block_id_type block_id_of_block_message( const message& block_message_to_read )
+  {
+     FC_ASSERT( block_message_to_read.msg_type == block_message_type );
+     const size_t id_size = fc::raw::pack_size( block_id_type() );
+     FC_ASSERT( block_message_to_read.data.size() >= id_size );
+     fc::datastream<const char*> ds( block_message_to_read.data.data() + block_message_to_read.data.size() - id_size, id_size );
+     block_id_type block_id;
+     fc::raw::unpack( ds, block_id );
+     return block_id;
+  }
+
+  uint64_t compact_block_short_id( const transaction_id_type& transaction_id )
+  {
+     // read the bytes in order so that the id means the same thing on every platform
+     uint64_t short_id = 0;
+     for( size_t i = 0; i < sizeof(short_id); ++i )
+        short_id = (short_id << 8) | uint8_t( transaction_id.data()[i] );
+     return short_id;
+  }
+
+  compact_block_message::compact_block_message( const signed_block& blk, const block_id_type& id )
+  :header(blk),block_id(id)
+  {
+     transactions.reserve( blk.transactions.size() );
+     for( const auto& trx : blk.transactions )
+     {
+        compact_block_transaction compact_trx;
+        compact_trx.short_id = compact_block_short_id( trx.id() );
+        compact_trx.operation_results = trx.operation_results;
+        transactions.push_back( std::move( compact_trx ) );
+     }
+  }
 
 } } // graphene::net
 
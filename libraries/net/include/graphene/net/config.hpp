@@ -79,6 +79,21 @@
 
 #define GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES           2
 
+/**
+ * How long we wait on a peer for the transactions we were missing from a
+ * compact block it sent us before forgetting about the block.  By then we
+ * will usually have received it from someone else.
+ */
+#define GRAPHENE_NET_COMPACT_BLOCK_REBUILD_TIMEOUT_SEC       30
+
+/**
+ * How many compact blocks we wait on missing transactions for, from any one
+ * peer and from all peers together.  Beyond that we forget the ones we've
+ * waited on longest.
+ */
+#define GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS_PER_PEER     2
+#define GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS              32
+
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
 /**
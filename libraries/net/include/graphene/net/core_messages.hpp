@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -44,6 +45,8 @@ namespace graphene { namespace net {
   using graphene::chain::block_id_type;
   using graphene::chain::transaction_id_type;
   using graphene::chain::signed_block;
+  using graphene::chain::signed_block_header;
+  using graphene::chain::operation_result;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +89,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    fetch_compact_block_transactions_message_type = 5019,
+    compact_block_transactions_message_type      = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -115,6 +121,57 @@ namespace graphene { namespace net {
 
    };
 
+   /**
+    *  @return the message of a block_message for a block that is already serialized with fc::raw::pack, without
+    *          unpacking the block and packing it again
+    */
+   message make_packed_block_message( std::vector<char>&& packed_block, const block_id_type& block_id );
+
+   /// @return the block_id of a block_message without unpacking the block, which it follows
+   block_id_type block_id_of_block_message( const message& block_message_to_read );
+
+   /// @return the first 8 bytes of a transaction id, which is how compact blocks refer to their transactions
+   uint64_t compact_block_short_id( const transaction_id_type& transaction_id );
+
+   struct compact_block_transaction
+   {
+      uint64_t                        short_id = 0;
+      std::vector<operation_result>   operation_results;
+   };
+
+   /**
+    *  A block relayed to a peer that advertised "compact_blocks" in its hello.  Rather than the full
+    *  transactions it carries their short ids, which the receiver resolves against the transactions it
+    *  has already seen; it only fetches the ones it is missing with fetch_compact_block_transactions_message.
+    */
+   struct compact_block_message
+   {
+      static const core_message_type_enum type;
+
+      compact_block_message(){}
+      compact_block_message( const signed_block& blk, const block_id_type& id );
+
+      signed_block_header                      header;
+      block_id_type                            block_id;
+      std::vector<compact_block_transaction>   transactions;
+   };
+
+   struct fetch_compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      block_id_type           block_id;
+      std::vector<uint32_t>   transaction_indexes;
+   };
+
+   struct compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      block_id_type                     block_id;
+      std::vector<signed_transaction>   transactions;
+   };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -424,10 +481,17 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (fetch_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
 FC_REFLECT( graphene::net::block_message, (block)(block_id) )
+FC_REFLECT( graphene::net::compact_block_transaction, (short_id)(operation_results) )
+FC_REFLECT( graphene::net::compact_block_message, (header)(block_id)(transactions) )
+FC_REFLECT( graphene::net::fetch_compact_block_transactions_message, (block_id)(transaction_indexes) )
+FC_REFLECT( graphene::net::compact_block_transactions_message, (block_id)(transactions) )
 
 FC_REFLECT( graphene::net::item_id, (item_type)
                                (item_hash) )
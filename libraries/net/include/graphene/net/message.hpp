@@ -61,6 +61,16 @@ namespace graphene { namespace net {
      message( const message& m )
      :message_header(m),data( m.data ){}
 
+     /**
+      *  Takes a payload that is already serialized as the message of type @ref type
+      */
+     message( uint32_t type, std::vector<char>&& payload )
+     :data( std::move(payload) )
+     {
+        msg_type = type;
+        size     = (uint32_t)data.size();
+     }
+
      /**
       *  Assumes that T::type specifies the message type
       */
@@ -261,6 +261,9 @@ namespace graphene { namespace net
 
       uint32_t last_known_fork_block_number;
 
+      bool supports_compact_blocks; /// the peer said in its hello that it understands compact_block_message
+      std::set<block_id_type> compact_blocks_requested_in_full; /// blocks we couldn't rebuild from this peer's compact block and asked it for in full
+
       fc::future<void> accept_or_connect_task_done;
 
       firewall_check_state_data *firewall_check_state;
@@ -177,6 +177,8 @@ namespace graphene { namespace net {
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<message> find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup, uint32_t message_type ) const;
+      fc::optional<signed_transaction> find_transaction_by_short_id( uint64_t short_id ) const;
       size_t size() const { return _message_cache.size(); }
     };
 
@@ -221,6 +223,40 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<message> blockchain_tied_message_cache::find_message_by_contents_hash( const fc::uint160_t& hash_of_message_contents_to_lookup,
+                                                                                        uint32_t message_type ) const
+    {
+      const auto& contents_index = _message_cache.get<message_contents_hash_index>();
+      for( auto iter = contents_index.lower_bound( hash_of_message_contents_to_lookup );
+           iter != contents_index.end() && iter->message_contents_hash == hash_of_message_contents_to_lookup; ++iter )
+        if( iter->message_body.msg_type == message_type )
+          return iter->message_body;
+      return fc::optional<message>();
+    }
+
+    fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction_by_short_id( uint64_t short_id ) const
+    {
+      // the short id is the leading bytes of the transaction id, so every candidate sorts at or after
+      // the id made of those bytes followed by zeroes
+      fc::uint160_t lowest_matching_id;
+      for( size_t i = 0; i < sizeof(short_id); ++i )
+        lowest_matching_id.data()[i] = char( short_id >> ( 8 * ( sizeof(short_id) - 1 - i ) ) );
+
+      fc::optional<signed_transaction> result;
+      const auto& contents_index = _message_cache.get<message_contents_hash_index>();
+      for( auto iter = contents_index.lower_bound( lowest_matching_id );
+           iter != contents_index.end() && compact_block_short_id( iter->message_contents_hash ) == short_id; ++iter )
+      {
+        if( iter->message_body.msg_type != trx_message_type )
+          continue;
+        if( result && result->id() != iter->message_contents_hash )
+          return fc::optional<signed_transaction>(); // two transactions share the short id, let the caller fetch it
+        if( !result )
+          result = iter->message_body.as<trx_message>().trx;
+      }
+      return result;
+    }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // This specifies configuration info for the local node.  It's stored as JSON
@@ -523,6 +559,18 @@ namespace graphene { namespace net { namespace detail {
 
       boost::circular_buffer<item_hash_t> _most_recent_blocks_accepted; // the /n/ most recent blocks we've accepted (currently tuned to the max number of connections)
 
+      /// compact blocks we're waiting on missing transactions for
+      // @{
+      struct partial_compact_block
+      {
+        std::weak_ptr<peer_connection> peer;
+        signed_block                   block;
+        std::vector<uint32_t>          missing_transaction_indexes;
+        fc::time_point                 requested_time;
+      };
+      std::map<block_id_type, partial_compact_block> _partial_compact_blocks;
+      // @}
+
       uint32_t _sync_item_type;
       uint32_t _total_number_of_unfetched_items; /// the number of items we still need to fetch while syncing
       std::vector<uint32_t> _hard_fork_block_numbers; /// list of all block numbers where there are hard forks
@@ -677,6 +725,18 @@ namespace graphene { namespace net { namespace detail {
       void on_get_current_connections_reply_message(peer_connection* originating_peer,
                                                     const get_current_connections_reply_message& get_current_connections_reply_message_received);
 
+      void on_compact_block_message(peer_connection* originating_peer,
+                                    const compact_block_message& compact_block_message_received);
+
+      void on_fetch_compact_block_transactions_message(peer_connection* originating_peer,
+                                                       const fetch_compact_block_transactions_message& fetch_compact_block_transactions_message_received);
+
+      void on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                 const compact_block_transactions_message& compact_block_transactions_message_received);
+
+      void process_rebuilt_compact_block(peer_connection* originating_peer, signed_block&& block, const block_id_type& block_id);
+      void fetch_full_block_instead_of_compact(peer_connection* originating_peer, const block_id_type& block_id);
+
       void on_connection_closed(peer_connection* originating_peer) override;
 
       void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
@@ -1245,6 +1305,9 @@ namespace graphene { namespace net { namespace detail {
         // first, then send them all in a batch (to avoid any fiber interruption points while
         // we're computing the messages)
         std::list<std::pair<peer_connection_ptr, item_ids_inventory_message> > inventory_messages_to_send;
+        // peers that understand compact blocks get new blocks pushed to them directly instead of advertised
+        std::list<std::pair<peer_connection_ptr, message> > compact_blocks_to_send;
+        std::map<item_hash_t, fc::optional<message> > compact_blocks_by_message_hash;
 
         for (const peer_connection_ptr& peer : _active_connections)
         {
@@ -1268,8 +1331,32 @@ namespace graphene { namespace net { namespace detail {
               if (peer->inventory_advertised_to_peer.find(item_to_advertise) == peer->inventory_advertised_to_peer.end() &&
                   peer->inventory_peer_advertised_to_us.find(item_to_advertise) == peer->inventory_peer_advertised_to_us.end())
               {
-                items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
                 peer->inventory_advertised_to_peer.insert(peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
+                if (item_to_advertise.item_type == block_message_type && peer->supports_compact_blocks)
+                {
+                  auto compact_iter = compact_blocks_by_message_hash.find(item_to_advertise.item_hash);
+                  if (compact_iter == compact_blocks_by_message_hash.end())
+                  {
+                    fc::optional<message> compact_block;
+                    try
+                    {
+                      block_message full_block = _message_cache.get_message(item_to_advertise.item_hash).as<block_message>();
+                      compact_block = message(compact_block_message(full_block.block, full_block.block_id));
+                    }
+                    catch (const fc::key_not_found_exception&)
+                    {
+                      // no longer cached, fall back to advertising it
+                    }
+                    compact_iter = compact_blocks_by_message_hash.insert(std::make_pair(item_to_advertise.item_hash, compact_block)).first;
+                  }
+                  if (compact_iter->second)
+                  {
+                    compact_blocks_to_send.push_back(std::make_pair(peer, *compact_iter->second));
+                    dlog("sending compact block ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
+                    continue;
+                  }
+                }
+                items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
                 ++total_items_to_send_to_this_peer;
                 if (item_to_advertise.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}", ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
@@ -1286,6 +1373,10 @@ namespace graphene { namespace net { namespace detail {
           peer->clear_old_inventory();
         }
 
+        for (auto iter = compact_blocks_to_send.begin(); iter != compact_blocks_to_send.end(); ++iter)
+          iter->first->send_message(iter->second);
+        compact_blocks_to_send.clear();
+
         for (auto iter = inventory_messages_to_send.begin(); iter != inventory_messages_to_send.end(); ++iter)
           iter->first->send_message(iter->second);
         inventory_messages_to_send.clear();
@@ -1789,6 +1880,15 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::block_message_type:
         process_block_message(originating_peer, received_message, message_hash);
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::fetch_compact_block_transactions_message_type:
+        on_fetch_compact_block_transactions_message(originating_peer, received_message.as<fetch_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+        break;
       case core_message_type_enum::current_time_request_message_type:
         on_current_time_request_message(originating_peer, received_message.as<current_time_request_message>());
         break;
@@ -1850,6 +1950,8 @@ namespace graphene { namespace net { namespace detail {
       if (!_hard_fork_block_numbers.empty())
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
+      user_data["compact_blocks"] = true;
+
       return user_data;
     }
     void node_impl::parse_hello_user_data_for_peer(peer_connection* originating_peer, const fc::variant_object& user_data)
@@ -1872,6 +1974,8 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->node_id = user_data["node_id"].as<node_id_t>();
       if (user_data.contains("last_known_fork_block_number"))
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>();
+      if (user_data.contains("compact_blocks"))
+        originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -2724,9 +2828,10 @@ namespace graphene { namespace net { namespace detail {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
-      fc::optional<message> last_block_message_sent;
+      // block replies are not unpacked here, their id is read from the end of the message
+      fc::optional<block_id_type> last_block_sent;
 
-      std::list<message> reply_messages;
+      std::list<std::pair<item_hash_t, message>> reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
@@ -2735,9 +2840,13 @@ namespace graphene { namespace net { namespace detail {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+          if (requested_message.msg_type == block_message_type)
+          {
+            last_block_sent = block_id_of_block_message(requested_message);
+            reply_messages.emplace_back(*last_block_sent, requested_message);
+          }
+          else
+            reply_messages.emplace_back(item_hash, requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2753,33 +2862,36 @@ namespace graphene { namespace net { namespace detail {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
-          reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
+          if (requested_message.msg_type == block_message_type)
+          {
+            last_block_sent = block_id_of_block_message(requested_message);
+            reply_messages.emplace_back(*last_block_sent, requested_message);
+          }
+          else
+            reply_messages.emplace_back(item_hash, requested_message);
           continue;
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.emplace_back(item_hash, item_not_available_message(item_to_fetch));
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
       }
 
       // if we sent them a block, update our record of the last block they've seen accordingly
-      if (last_block_message_sent)
+      if (last_block_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
-        originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        originating_peer->last_block_delegate_has_seen = *last_block_sent;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_sent);
       }
 
-      for (const message& reply : reply_messages)
+      for (const auto& reply : reply_messages)
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        if (reply.second.msg_type == block_message_type)
+          originating_peer->send_item(item_id(block_message_type, reply.first));
         else
-          originating_peer->send_message(reply);
+          originating_peer->send_message(reply.second);
       }
     }
 
@@ -2815,6 +2927,13 @@ namespace graphene { namespace net { namespace detail {
         return;
       }
 
+      if (requested_item.item_type == block_message_type &&
+          originating_peer->compact_blocks_requested_in_full.erase(requested_item.item_hash))
+      {
+        wlog("Peer sent us a compact block but doesn't have the full block");
+        return;
+      }
+
       dlog("Peer doesn't have an item we're looking for, which is fine because we weren't looking for it");
     }
 
@@ -3499,6 +3618,14 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      // we asked for the full block because we couldn't rebuild the compact block the peer sent us
+      if (originating_peer->compact_blocks_requested_in_full.erase(block_message_to_process.block_id))
+      {
+        originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(item_id(block_message_type, message_hash), fc::time_point::now()));
+        process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
+        return;
+      }
+
       // if we get here, we didn't request the message, we must have a misbehaving peer
       wlog("received a block ${block_id} I didn't ask for from peer ${endpoint}, disconnecting from peer",
            ("endpoint", originating_peer->get_remote_endpoint())
@@ -3512,6 +3639,187 @@ namespace graphene { namespace net { namespace detail {
       disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
     }
 
+    void node_impl::on_compact_block_message(peer_connection* originating_peer,
+                                             const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = compact_block_message_received.block_id;
+
+      // forget about blocks we gave up on or have since received some other way
+      fc::time_point oldest_request_to_keep = fc::time_point::now() - fc::seconds(GRAPHENE_NET_COMPACT_BLOCK_REBUILD_TIMEOUT_SEC);
+      for (auto iter = _partial_compact_blocks.begin(); iter != _partial_compact_blocks.end();)
+        if (iter->second.requested_time < oldest_request_to_keep || iter->second.peer.expired() ||
+            std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(), iter->first) != _most_recent_blocks_accepted.end())
+          iter = _partial_compact_blocks.erase(iter);
+        else
+          ++iter;
+
+      if (originating_peer->we_need_sync_items_from_peer)
+      {
+        dlog("ignoring compact block ${id} from peer ${endpoint}, we're still syncing with it",
+             ("id", block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+      if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(), block_id) != _most_recent_blocks_accepted.end() ||
+          _partial_compact_blocks.find(block_id) != _partial_compact_blocks.end())
+        return;
+
+      partial_compact_block partial_block;
+      partial_block.peer = originating_peer->shared_from_this();
+      static_cast<signed_block_header&>(partial_block.block) = compact_block_message_received.header;
+      partial_block.block.transactions.resize(compact_block_message_received.transactions.size());
+      for (uint32_t i = 0; i < compact_block_message_received.transactions.size(); ++i)
+      {
+        const compact_block_transaction& compact_trx = compact_block_message_received.transactions[i];
+        fc::optional<signed_transaction> trx = _message_cache.find_transaction_by_short_id(compact_trx.short_id);
+        if (trx)
+        {
+          partial_block.block.transactions[i] = graphene::chain::processed_transaction(*trx);
+          partial_block.block.transactions[i].operation_results = compact_trx.operation_results;
+        }
+        else
+          partial_block.missing_transaction_indexes.push_back(i);
+      }
+
+      if (partial_block.missing_transaction_indexes.empty())
+      {
+        process_rebuilt_compact_block(originating_peer, std::move(partial_block.block), block_id);
+        return;
+      }
+
+      dlog("compact block ${id} from peer ${endpoint} is missing ${count} of ${total} transactions, fetching them",
+           ("id", block_id)("endpoint", originating_peer->get_remote_endpoint())
+           ("count", partial_block.missing_transaction_indexes.size())("total", partial_block.block.transactions.size()));
+      fetch_compact_block_transactions_message request;
+      request.block_id = block_id;
+      request.transaction_indexes = partial_block.missing_transaction_indexes;
+      for (uint32_t index : request.transaction_indexes)
+        partial_block.block.transactions[index].operation_results = compact_block_message_received.transactions[index].operation_results;
+      partial_block.requested_time = fc::time_point::now();
+
+      // make room, forgetting the blocks we've waited on longest first
+      for (;;)
+      {
+        auto oldest_iter = _partial_compact_blocks.end();
+        auto oldest_from_peer_iter = _partial_compact_blocks.end();
+        uint32_t count_from_peer = 0;
+        for (auto iter = _partial_compact_blocks.begin(); iter != _partial_compact_blocks.end(); ++iter)
+        {
+          if (oldest_iter == _partial_compact_blocks.end() || iter->second.requested_time < oldest_iter->second.requested_time)
+            oldest_iter = iter;
+          if (iter->second.peer.lock().get() == originating_peer)
+          {
+            ++count_from_peer;
+            if (oldest_from_peer_iter == _partial_compact_blocks.end() || iter->second.requested_time < oldest_from_peer_iter->second.requested_time)
+              oldest_from_peer_iter = iter;
+          }
+        }
+        if (count_from_peer >= GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS_PER_PEER)
+          _partial_compact_blocks.erase(oldest_from_peer_iter);
+        else if (_partial_compact_blocks.size() >= GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS)
+          _partial_compact_blocks.erase(oldest_iter);
+        else
+          break;
+      }
+      _partial_compact_blocks[block_id] = std::move(partial_block);
+      originating_peer->send_message(request);
+    }
+
+    void node_impl::on_fetch_compact_block_transactions_message(peer_connection* originating_peer,
+                                                                const fetch_compact_block_transactions_message& fetch_compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      compact_block_transactions_message reply;
+      reply.block_id = fetch_compact_block_transactions_message_received.block_id;
+
+      fc::optional<message> full_block = _message_cache.find_message_by_contents_hash(reply.block_id, block_message_type);
+      if (!full_block)
+      {
+        try
+        {
+          full_block = _delegate->get_item(item_id(block_message_type, reply.block_id));
+        }
+        catch (const fc::key_not_found_exception&)
+        {
+        }
+      }
+
+      // an empty reply tells the peer to fetch the whole block instead
+      if (full_block)
+      {
+        block_message block_message_to_send = full_block->as<block_message>();
+        for (uint32_t index : fetch_compact_block_transactions_message_received.transaction_indexes)
+        {
+          if (index >= block_message_to_send.block.transactions.size())
+          {
+            reply.transactions.clear();
+            break;
+          }
+          reply.transactions.push_back(block_message_to_send.block.transactions[index]);
+        }
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const block_id_type& block_id = compact_block_transactions_message_received.block_id;
+      auto partial_iter = _partial_compact_blocks.find(block_id);
+      if (partial_iter == _partial_compact_blocks.end() || partial_iter->second.peer.lock().get() != originating_peer)
+      {
+        dlog("received transactions for compact block ${id} that we aren't rebuilding, ignoring them", ("id", block_id));
+        return;
+      }
+      partial_compact_block partial_block = std::move(partial_iter->second);
+      _partial_compact_blocks.erase(partial_iter);
+
+      if (compact_block_transactions_message_received.transactions.size() != partial_block.missing_transaction_indexes.size())
+      {
+        fetch_full_block_instead_of_compact(originating_peer, block_id);
+        return;
+      }
+      for (uint32_t i = 0; i < partial_block.missing_transaction_indexes.size(); ++i)
+      {
+        graphene::chain::processed_transaction& trx = partial_block.block.transactions[partial_block.missing_transaction_indexes[i]];
+        std::vector<graphene::chain::operation_result> operation_results = std::move(trx.operation_results);
+        trx = graphene::chain::processed_transaction(compact_block_transactions_message_received.transactions[i]);
+        trx.operation_results = std::move(operation_results);
+      }
+      process_rebuilt_compact_block(originating_peer, std::move(partial_block.block), block_id);
+    }
+
+    void node_impl::process_rebuilt_compact_block(peer_connection* originating_peer, signed_block&& block, const block_id_type& block_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a short id collision leaves us with the wrong transaction, which the merkle root catches
+      if (block.calculate_merkle_root() != block.transaction_merkle_root || block.id() != block_id)
+      {
+        dlog("compact block ${id} from peer ${endpoint} didn't rebuild to the block it describes",
+             ("id", block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        fetch_full_block_instead_of_compact(originating_peer, block_id);
+        return;
+      }
+
+      graphene::net::block_message block_message_to_process;
+      block_message_to_process.block = std::move(block);
+      block_message_to_process.block_id = block_id;
+      message_hash_type message_hash = message(block_message_to_process).id();
+
+      // the peer obviously has this block, so don't offer it back
+      originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(item_id(block_message_type, message_hash), fc::time_point::now()));
+      process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
+    }
+
+    void node_impl::fetch_full_block_instead_of_compact(peer_connection* originating_peer, const block_id_type& block_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      // fetch_items by block id is answered from the peer's blockchain, just like during sync
+      originating_peer->compact_blocks_requested_in_full.insert(block_id);
+      originating_peer->send_message(fetch_items_message(block_message_type, std::vector<item_hash_t>{block_id}));
+    }
+
     void node_impl::on_current_time_request_message(peer_connection* originating_peer,
                                                     const current_time_request_message& current_time_request_message_received)
     {
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/operation_history_store.hpp>
 
 #include <graphene/app/impacted.hpp>
 
@@ -42,6 +43,9 @@ namespace graphene { namespace account_history {
 namespace detail
 {
 
+/// bounds the work of a single block when a long backlog of irreversible operations, e.g. on the first start
+/// with the operation history store, has to be moved to disk
+const uint32_t max_operations_stored_per_block = 10000;
 
 class account_history_plugin_impl
 {
@@ -57,6 +61,9 @@ class account_history_plugin_impl
        */
       void update_account_histories( const signed_block& b );
 
+      /** moves the operations of irreversible blocks from memory to the operation history store */
+      void store_irreversible_operations();
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -65,11 +72,13 @@ class account_history_plugin_impl
       account_history_plugin& _self;
       flat_set<account_id_type> _tracked_accounts;
       bool _partial_operations = false;
-      primary_index< simple_index< operation_history_object > >* _oho_index;
+      graphene::db::index* _oho_index = nullptr;
+      /// set if operations of irreversible blocks are kept on disk
+      operation_history_primary_index* _oho_disk_index = nullptr;
       uint32_t _max_ops_per_account = -1;
    private:
       /** add one history record, then check and remove the earliest history record */
-      void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
+      void add_account_history( const account_id_type account_id, const operation_history_id_type op_id, int op_type );
 
 };
 
@@ -145,7 +154,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                // that indexing now happens in observers' post_evaluate()
 
                // add history
-               add_account_history( account_id, oho->id );
+               add_account_history( account_id, oho->id, op.op.which() );
             }
          }
       }
@@ -165,7 +174,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                {
                   if (!oho.valid()) { oho = create_oho(); }
                   // add history
-                  add_account_history( account_id, oho->id );
+                  add_account_history( account_id, oho->id, op.op.which() );
                }
             }
          }
@@ -173,9 +182,35 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
       if (_partial_operations && ! oho.valid())
          _oho_index->use_next_id();
    }
+
+   if( _oho_disk_index != nullptr )
+      store_irreversible_operations();
 }
 
-void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id )
+void account_history_plugin_impl::store_irreversible_operations()
+{
+   graphene::chain::database& db = database();
+   operation_history_store& store = _oho_disk_index->store();
+   if( !store.is_open() )
+      return;
+   // nothing holds operations found during the previous block any more
+   store.release_evicted();
+
+   const uint32_t irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+   uint32_t moved = 0;
+   for( const operation_history_object* op = _oho_disk_index->oldest();
+        op != nullptr && op->block_num <= irreversible && moved < max_operations_stored_per_block;
+        op = _oho_disk_index->oldest() )
+   {
+      store.append( *op );
+      db.remove( *op );
+      ++moved;
+   }
+   if( moved > 0 )
+      store.flush();
+}
+
+void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id, int op_type )
 {
    graphene::chain::database& db = database();
    const auto& stats_obj = account_id(db).statistics(db);
@@ -185,6 +220,7 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
        obj.account = account_id;
        obj.sequence = stats_obj.total_ops + 1;
        obj.next = stats_obj.most_recent_op;
+       obj.operation_type = op_type;
    });
    db.modify( stats_obj, [&]( account_statistics_object& obj ){
        obj.most_recent_op = ath.id;
@@ -236,6 +272,38 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
 
 } // end namespace detail
 
+void account_history_op_type_index::object_inserted( const object& obj )
+{
+   assert( dynamic_cast<const account_transaction_history_object*>(&obj) );
+   const auto& node = static_cast<const account_transaction_history_object&>(obj);
+   _entries.insert( entry( node.account, node.operation_type, node.operation_id ) );
+}
+
+void account_history_op_type_index::object_removed( const object& obj )
+{
+   assert( dynamic_cast<const account_transaction_history_object*>(&obj) );
+   const auto& node = static_cast<const account_transaction_history_object&>(obj);
+   _entries.erase( entry( node.account, node.operation_type, node.operation_id ) );
+}
+
+vector<operation_history_id_type> account_history_op_type_index::get_operations( account_id_type account, int op_type,
+                                                                                 operation_history_id_type start,
+                                                                                 operation_history_id_type stop,
+                                                                                 uint32_t limit )const
+{
+   vector<operation_history_id_type> result;
+   auto itr = _entries.upper_bound( entry( account, op_type, start ) );
+   while( itr != _entries.begin() && result.size() < limit )
+   {
+      --itr;
+      if( std::get<0>( *itr ) != account || std::get<1>( *itr ) != op_type
+          || std::get<2>( *itr ).instance.value <= stop.instance.value )
+         break;
+      result.push_back( std::get<2>( *itr ) );
+   }
+   return result;
+}
+
 
 
 
@@ -264,6 +332,8 @@ void account_history_plugin::plugin_set_program_options(
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
          ("partial-operations", boost::program_options::value<bool>(), "Keep only those operations in memory that are related to account history tracking")
          ("max-ops-per-account", boost::program_options::value<uint32_t>(), "Maximum number of operations per account will be kept in memory")
+         ("operation-history-on-disk", boost::program_options::value<bool>(), "Keep operations of irreversible blocks on disk instead of in memory")
+         ("operation-history-cache-size", boost::program_options::value<uint32_t>(), "Number of operations read from disk that are cached in memory (default: 10000)")
          ;
    cfg.add(cli);
 }
@@ -271,8 +341,17 @@ void account_history_plugin::plugin_set_program_options(
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
-   my->_oho_index = database().add_index< primary_index< simple_index< operation_history_object > > >();
-   database().add_index< primary_index< account_transaction_history_index > >();
+   if( options.count("operation-history-on-disk") && options["operation-history-on-disk"].as<bool>() )
+   {
+      my->_oho_disk_index = database().add_index< operation_history_primary_index >();
+      if( options.count("operation-history-cache-size") )
+         my->_oho_disk_index->store().set_cache_size( options["operation-history-cache-size"].as<uint32_t>() );
+      my->_oho_index = my->_oho_disk_index;
+   }
+   else
+      my->_oho_index = database().add_index< primary_index< simple_index< operation_history_object > > >();
+   auto history_index = database().add_index< primary_index< account_transaction_history_index > >();
+   history_index->add_secondary_index< account_history_op_type_index >();
 
    LOAD_VALUE_SET(options, "track-account", my->_tracked_accounts, graphene::chain::account_id_type);
    if (options.count("partial-operations")) {
@@ -30,6 +30,9 @@
 
 #include <fc/thread/future.hpp>
 
+#include <set>
+#include <tuple>
+
 namespace graphene { namespace account_history {
    using namespace chain;
    //using namespace graphene::db;
@@ -57,6 +60,30 @@ enum account_history_object_type
 };
 
 
+/**
+ *  Secondary index of the account history by operation type, so that history filtered by type can be paged
+ *  without walking the whole history of an account.
+ */
+class account_history_op_type_index : public graphene::db::secondary_index
+{
+   public:
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+
+      /**
+       *  @return ids of operations of type @ref op_type in the history of @ref account, newest first, starting at
+       *          @ref start and stopping before @ref stop, at most @ref limit
+       */
+      vector<operation_history_id_type> get_operations( account_id_type account, int op_type,
+                                                        operation_history_id_type start,
+                                                        operation_history_id_type stop, uint32_t limit )const;
+
+   private:
+      typedef std::tuple< account_id_type, int, operation_history_id_type > entry;
+
+      std::set< entry >                _entries;
+};
+
 namespace detail
 {
     class account_history_plugin_impl;
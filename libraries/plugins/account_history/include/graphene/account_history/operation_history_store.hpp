@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/db/index.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <deque>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+namespace graphene { namespace account_history {
+
+using namespace chain;
+
+/**
+ *  Keeps the operation history of irreversible blocks on disk.
+ *
+ *  Operations are appended in id order to segments of @ref segment_size ids.  A segment is a log of packed
+ *  operations plus an offset file holding the position in the log of every id of the segment, so an operation
+ *  is read with two seeks.  Ids without an operation, e.g. those skipped with partial-operations, have no
+ *  position.  Operations read from disk are kept in an LRU cache.
+ */
+class operation_history_store
+{
+   public:
+      static const uint64_t segment_size = 1 << 20;
+      /// operations evicted from the cache that are kept alive for callers of find(), if the cache is smaller
+      static const uint32_t min_evicted_kept = 1000;
+
+      ~operation_history_store();
+
+      void open( const fc::path& dir );
+      void close();
+      bool is_open()const { return _log.is_open(); }
+
+      /// sets the number of operations read from disk that are kept in memory, at least one is kept
+      void set_cache_size( uint32_t entries );
+
+      /// operations with an id instance below this one are stored, append() skips them
+      uint64_t next_instance()const { return _next_instance; }
+
+      /// appends @ref op, unless it is stored already
+      void append( const operation_history_object& op );
+      /// makes the appended operations visible to find()
+      void flush();
+
+      /**
+       * @return the operation with the id @ref instance or nullptr if it is not stored; the operation stays valid
+       *         until the next call of release_evicted(), even if later lookups evict it from the cache, as long as
+       *         no more than the cache size or @ref min_evicted_kept operations, whichever is more, are evicted after it
+       */
+      const operation_history_object* find( uint64_t instance )const;
+
+      /// frees the operations evicted from the cache, call it only where no result of find() is held
+      void release_evicted();
+      /// number of operations evicted from the cache and not freed yet
+      size_t evicted_count()const { return _evicted.size(); }
+
+   private:
+      struct reader
+      {
+         std::ifstream log;
+         std::ifstream offsets;
+      };
+
+      void open_segment( uint64_t segment );
+      fc::path log_path( uint64_t segment )const;
+      fc::path offsets_path( uint64_t segment )const;
+      void touch_cache( std::list< std::unique_ptr<operation_history_object> >::iterator itr )const;
+      void evict( size_t cache_size )const;
+
+      fc::path                                             _dir;
+      /// segments on disk, each numbered by its first id instance / segment_size
+      std::set<uint64_t>                                   _segments;
+      /// the segment being appended to
+      uint64_t                                             _segment = 0;
+      std::ofstream                                        _log;
+      std::ofstream                                        _offsets;
+      uint64_t                                             _log_size = 0;
+      uint64_t                                             _offsets_count = 0;
+      uint64_t                                             _next_instance = 0;
+      mutable std::map< uint64_t, std::unique_ptr<reader> > _readers;
+
+      uint32_t                                             _cache_size = 10000;
+      mutable std::list< std::unique_ptr<operation_history_object> > _cache_lru;
+      mutable std::unordered_map< uint64_t, std::list< std::unique_ptr<operation_history_object> >::iterator > _cache;
+      /// evicted from the cache, but possibly still referred to by the caller of an earlier find(); oldest first
+      mutable std::deque< std::unique_ptr<operation_history_object> > _evicted;
+};
+
+/**
+ *  Index of operation_history_object that keeps only the operations of reversible blocks in memory and finds the
+ *  rest in an operation_history_store, so that they are served to the API as if they were in memory.  Only the
+ *  operations in memory are saved with the object database.
+ */
+class operation_history_disk_index : public graphene::db::index
+{
+   public:
+      typedef operation_history_object object_type;
+
+      /// most empty slots insert() adds in front of the operations in memory, see there
+      static const uint64_t max_front_gap = 1 << 16;
+
+      virtual const object& create( const std::function<void(object&)>& constructor ) override;
+      virtual void modify( const object& obj, const std::function<void(object&)>& modify_callback ) override;
+      /**
+       * Undo puts back operations that were moved to disk, or removed while on disk, in front of the ones in memory.
+       * An operation more than @ref max_front_gap ids in front of them, or put back while none are in memory, is left
+       * to the store if it holds it rather than keeping an empty slot for every id in between, and is rejected if not.
+       */
+      virtual const object& insert( object&& obj ) override;
+      /// operations on disk are not removed
+      virtual void remove( const object& obj ) override;
+      virtual const object* find( object_id_type id )const override;
+      /// visits the operations in memory
+      virtual void inspect_all_objects( std::function<void (const object&)> inspector )const override;
+      virtual fc::uint128 hash()const override;
+
+      /// @return the operation in memory with the lowest id, nullptr if there is none
+      const operation_history_object* oldest()const;
+
+      operation_history_store&       store()       { return _store; }
+      const operation_history_store& store()const  { return _store; }
+
+   private:
+      /// operations in memory by id instance, starting at _first_instance
+      std::deque< std::unique_ptr<object> > _objects;
+      uint64_t                              _first_instance = 0;
+      operation_history_store               _store;
+};
+
+/// opens the store next to the file the object database saves the index to, so that it is wiped along with it
+class operation_history_primary_index : public graphene::db::primary_index< operation_history_disk_index >
+{
+   public:
+      operation_history_primary_index( graphene::db::object_database& db )
+      : graphene::db::primary_index< operation_history_disk_index >( db ) {}
+
+      virtual void open( const fc::path& db )override
+      {
+         store().open( db.parent_path().parent_path() / "operation_history" );
+         graphene::db::primary_index< operation_history_disk_index >::open( db );
+      }
+};
+
+} } // graphene::account_history
@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/account_history/operation_history_store.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace account_history {
+
+namespace {
+   /// offset of ids that have no operation
+   const uint64_t no_position = uint64_t(-1);
+}
+
+operation_history_store::~operation_history_store()
+{
+   close();
+}
+
+fc::path operation_history_store::log_path( uint64_t segment )const
+{
+   return _dir / ( fc::to_string( segment ) + ".log" );
+}
+
+fc::path operation_history_store::offsets_path( uint64_t segment )const
+{
+   return _dir / ( fc::to_string( segment ) + ".offsets" );
+}
+
+void operation_history_store::open( const fc::path& dir )
+{ try {
+   close();
+   _dir = dir;
+   fc::create_directories( _dir );
+
+   for( fc::directory_iterator itr( _dir ); itr != fc::directory_iterator(); ++itr )
+   {
+      const fc::path file = *itr;
+      if( file.extension().string() == ".log" )
+         _segments.insert( std::stoull( file.stem().string() ) );
+   }
+
+   if( !_segments.empty() )
+   {
+      // a crash may leave a partial offset, or offsets of operations that did not make it into the log
+      const uint64_t segment = *_segments.rbegin();
+      const fc::path offsets_file = offsets_path( segment );
+      const uint64_t log_size = fc::exists( log_path( segment ) ) ? fc::file_size( log_path( segment ) ) : 0;
+      uint64_t count = fc::exists( offsets_file ) ? fc::file_size( offsets_file ) / sizeof(uint64_t) : 0;
+      uint64_t complete_size = 0;
+      {
+         std::ifstream offsets( offsets_file.generic_string(), std::ios::binary );
+         std::ifstream log( log_path( segment ).generic_string(), std::ios::binary );
+         for( ; count > 0; --count )
+         {
+            uint64_t offset = no_position;
+            offsets.seekg( ( count - 1 ) * sizeof(offset) );
+            offsets.read( (char*)&offset, sizeof(offset) );
+            if( offset == no_position )
+               continue;
+            uint32_t size = 0;
+            log.seekg( offset );
+            if( offset + sizeof(size) <= log_size && log.read( (char*)&size, sizeof(size) )
+                && offset + sizeof(size) + size <= log_size )
+            {
+               complete_size = offset + sizeof(size) + size;
+               break;
+            }
+            log.clear();
+         }
+      }
+      if( fc::exists( offsets_file ) && fc::file_size( offsets_file ) != count * sizeof(uint64_t) )
+      {
+         wlog( "Discarding incomplete operations at the end of the operation history store" );
+         fc::resize_file( offsets_file, count * sizeof(uint64_t) );
+      }
+      if( log_size != complete_size )
+         fc::resize_file( log_path( segment ), complete_size );
+      _next_instance = segment * segment_size + count;
+   }
+   open_segment( _next_instance / segment_size );
+
+   ilog( "Opened operation history store with ${s} segments up to operation ${n}",
+         ("s",_segments.size())("n",_next_instance) );
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+void operation_history_store::open_segment( uint64_t segment )
+{
+   if( _log.is_open() )
+      _log.close();
+   if( _offsets.is_open() )
+      _offsets.close();
+   _segment = segment;
+   _segments.insert( segment );
+   _log.open( log_path( segment ).generic_string(), std::ios::out | std::ios::binary | std::ios::app );
+   _offsets.open( offsets_path( segment ).generic_string(), std::ios::out | std::ios::binary | std::ios::app );
+   FC_ASSERT( _log && _offsets, "unable to open operation history segment ${s}", ("s",segment) );
+   _log_size = fc::file_size( log_path( segment ) );
+   _offsets_count = fc::file_size( offsets_path( segment ) ) / sizeof(uint64_t);
+}
+
+void operation_history_store::close()
+{
+   if( _log.is_open() )
+      _log.close();
+   if( _offsets.is_open() )
+      _offsets.close();
+   _segments.clear();
+   _readers.clear();
+   _cache.clear();
+   _cache_lru.clear();
+   _evicted.clear();
+   _segment = 0;
+   _log_size = 0;
+   _offsets_count = 0;
+   _next_instance = 0;
+}
+
+void operation_history_store::set_cache_size( uint32_t entries )
+{
+   _cache_size = std::max( entries, 1u );
+   evict( _cache_size );
+}
+
+void operation_history_store::evict( size_t cache_size )const
+{
+   while( _cache_lru.size() > cache_size )
+   {
+      _cache.erase( _cache_lru.back()->id.instance() );
+      _evicted.push_back( std::move( _cache_lru.back() ) );
+      _cache_lru.pop_back();
+   }
+   // release_evicted() is called once per block, lookups of API calls in between must not pile up
+   const size_t max_evicted = std::max<size_t>( _cache_size, min_evicted_kept );
+   while( _evicted.size() > max_evicted )
+      _evicted.pop_front();
+}
+
+void operation_history_store::release_evicted()
+{
+   _evicted.clear();
+}
+
+void operation_history_store::append( const operation_history_object& op )
+{ try {
+   FC_ASSERT( is_open() );
+   const uint64_t instance = op.id.instance();
+   if( instance < _next_instance )
+      return;
+
+   if( instance / segment_size != _segment )
+      open_segment( instance / segment_size );
+   const uint64_t position = instance % segment_size;
+   const uint64_t missing = no_position;
+   for( ; _offsets_count < position; ++_offsets_count )
+      _offsets.write( (const char*)&missing, sizeof(missing) );
+
+   // the operation goes into the log before its offset, so that an offset always refers to a complete operation
+   const auto data = fc::raw::pack( op );
+   const uint32_t size = data.size();
+   _log.write( (const char*)&size, sizeof(size) );
+   _log.write( data.data(), data.size() );
+   _offsets.write( (const char*)&_log_size, sizeof(_log_size) );
+   _log_size += sizeof(size) + size;
+   ++_offsets_count;
+   _next_instance = instance + 1;
+} FC_CAPTURE_AND_RETHROW( (op.id) ) }
+
+void operation_history_store::flush()
+{
+   _log.flush();
+   _offsets.flush();
+}
+
+void operation_history_store::touch_cache( std::list< std::unique_ptr<operation_history_object> >::iterator itr )const
+{
+   _cache_lru.splice( _cache_lru.begin(), _cache_lru, itr );
+}
+
+const operation_history_object* operation_history_store::find( uint64_t instance )const
+{
+   auto cached = _cache.find( instance );
+   if( cached != _cache.end() )
+   {
+      touch_cache( cached->second );
+      return cached->second->get();
+   }
+
+   const uint64_t segment = instance / segment_size;
+   if( instance >= _next_instance || _segments.find( segment ) == _segments.end() )
+      return nullptr;
+
+   auto& r = _readers[segment];
+   if( !r )
+   {
+      r.reset( new reader );
+      r->log.open( log_path( segment ).generic_string(), std::ios::binary );
+      r->offsets.open( offsets_path( segment ).generic_string(), std::ios::binary );
+   }
+   // the segment being appended to may have hit its end on an earlier lookup
+   r->log.clear();
+   r->offsets.clear();
+
+   uint64_t offset = no_position;
+   r->offsets.seekg( ( instance % segment_size ) * sizeof(offset) );
+   if( !r->offsets.read( (char*)&offset, sizeof(offset) ) || offset == no_position )
+      return nullptr;
+   uint32_t size = 0;
+   r->log.seekg( offset );
+   r->log.read( (char*)&size, sizeof(size) );
+   vector<char> data( size );
+   r->log.read( data.data(), size );
+   FC_ASSERT( r->log, "operation history segment ${s} is damaged", ("s",segment) );
+
+   _cache_lru.emplace_front( new operation_history_object( fc::raw::unpack<operation_history_object>( data ) ) );
+   _cache[instance] = _cache_lru.begin();
+   const operation_history_object* result = _cache_lru.front().get();
+   evict( _cache_size );
+   return result;
+}
+
+const object& operation_history_disk_index::create( const std::function<void(object&)>& constructor )
+{
+   operation_history_object op;
+   op.id = get_next_id();
+   constructor( op );
+   op.id = get_next_id(); // just in case it changed
+   const auto& result = operation_history_disk_index::insert( std::move( op ) );
+   use_next_id();
+   return result;
+}
+
+void operation_history_disk_index::modify( const object& obj, const std::function<void(object&)>& modify_callback )
+{
+   const auto instance = obj.id.instance();
+   FC_ASSERT( instance >= _first_instance && instance - _first_instance < _objects.size()
+              && _objects[instance - _first_instance], "operations on disk cannot be modified" );
+   modify_callback( *_objects[instance - _first_instance] );
+}
+
+const object& operation_history_disk_index::insert( object&& obj )
+{
+   assert( nullptr != dynamic_cast<operation_history_object*>(&obj) );
+   const auto instance = obj.id.instance();
+   const bool far_in_front = _objects.empty() || ( instance < _first_instance && _first_instance - instance > max_front_gap );
+   if( far_in_front && _store.is_open() && instance < _store.next_instance() )
+   {
+      const object* stored = _store.find( instance );
+      FC_ASSERT( stored != nullptr, "operation ${i} is not in the operation history store", ("i",obj.id) );
+      return *stored;
+   }
+   FC_ASSERT( _objects.empty() || !far_in_front, "operation ${i} is too far in front of operation ${f} in memory",
+              ("i",obj.id)("f",_first_instance) );
+   if( _objects.empty() )
+      _first_instance = instance;
+   // undo puts back operations that were moved to disk in front of the ones in memory
+   for( ; instance < _first_instance; --_first_instance )
+      _objects.emplace_front();
+   if( instance - _first_instance >= _objects.size() )
+      _objects.resize( instance - _first_instance + 1 );
+   auto& slot = _objects[instance - _first_instance];
+   assert( !slot );
+   slot.reset( new operation_history_object( std::move( static_cast<operation_history_object&>(obj) ) ) );
+   return *slot;
+}
+
+void operation_history_disk_index::remove( const object& obj )
+{
+   assert( nullptr != dynamic_cast<const operation_history_object*>(&obj) );
+   const auto instance = obj.id.instance();
+   if( instance < _first_instance || instance - _first_instance >= _objects.size() )
+      return;
+   _objects[instance - _first_instance].reset();
+   while( !_objects.empty() && !_objects.front() )
+   {
+      _objects.pop_front();
+      ++_first_instance;
+   }
+   while( !_objects.empty() && !_objects.back() )
+      _objects.pop_back();
+}
+
+const object* operation_history_disk_index::find( object_id_type id )const
+{
+   assert( id.space() == operation_history_object::space_id );
+   assert( id.type() == operation_history_object::type_id );
+
+   const auto instance = id.instance();
+   if( instance >= _first_instance && instance - _first_instance < _objects.size() )
+      if( const object* result = _objects[instance - _first_instance].get() )
+         return result;
+   return _store.is_open() ? _store.find( instance ) : nullptr;
+}
+
+void operation_history_disk_index::inspect_all_objects( std::function<void (const object&)> inspector )const
+{
+   try {
+      for( const auto& ptr : _objects )
+         if( ptr )
+            inspector( *ptr );
+   } FC_CAPTURE_AND_RETHROW()
+}
+
+fc::uint128 operation_history_disk_index::hash()const
+{
+   fc::uint128 result;
+   for( const auto& ptr : _objects )
+      if( ptr )
+         result += ptr->hash();
+   return result;
+}
+
+const operation_history_object* operation_history_disk_index::oldest()const
+{
+   // the front is never empty, remove() drops empty slots there
+   return _objects.empty() ? nullptr : static_cast<const operation_history_object*>( _objects.front().get() );
+}
+
+} } // graphene::account_history
@@ -95,52 +95,27 @@ void debug_witness_plugin::plugin_startup()
    ilog("debug_witness_plugin::plugin_startup() begin");
    chain::database& db = database();
 
-   // connect needed signals
-
-   _applied_block_conn  = db.applied_block.connect([this](const graphene::chain::signed_block& b){ on_applied_block(b); });
-   _changed_objects_conn = db.changed_objects.connect([this](const std::vector<graphene::db::object_id_type>& ids, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts){ on_changed_objects(ids, impacted_accounts); });
-   _removed_objects_conn = db.removed_objects.connect([this](const std::vector<graphene::db::object_id_type>& ids, const std::vector<const graphene::db::object*>& objs, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts){ on_removed_objects(ids, objs, impacted_accounts); });
+   // the object dump is written on a thread of its own, off the block-apply thread
+   db.block_events().add_consumer( plugin_name(), [this]( const chain::applied_block_event& e ){ on_block_event( e ); } );
 
    return;
 }
 
-void debug_witness_plugin::on_changed_objects( const std::vector<graphene::db::object_id_type>& ids, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts )
+void debug_witness_plugin::on_block_event( const chain::applied_block_event& e )
 {
-   if( _json_object_stream && (ids.size() > 0) )
-   {
-      const chain::database& db = database();
-      for( const graphene::db::object_id_type& oid : ids )
-      {
-         const graphene::db::object* obj = db.find_object( oid );
-         if( obj != nullptr )
-         {
-            (*_json_object_stream) << fc::json::to_string( obj->to_variant() ) << '\n';
-         }
-      }
-   }
-}
-
-void debug_witness_plugin::on_removed_objects( const std::vector<graphene::db::object_id_type>& ids, const std::vector<const graphene::db::object*> objs, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts )
-{
-   if( _json_object_stream )
-   {
-      for( const graphene::db::object* obj : objs )
-      {
-         (*_json_object_stream) << "{\"id\":" << fc::json::to_string( obj->id ) << "}\n";
-      }
-   }
-}
-
-void debug_witness_plugin::on_applied_block( const graphene::chain::signed_block& b )
-{
-   if( _json_object_stream )
-   {
-      (*_json_object_stream) << "{\"bn\":" << fc::to_string( b.block_num() ) << "}\n";
-   }
+   if( !_json_object_stream )
+      return;
+
+   (*_json_object_stream) << "{\"bn\":" << fc::to_string( e.block_num ) << "}\n";
+   for( const auto& obj : e.changed_objects )
+      (*_json_object_stream) << fc::json::to_string( obj->to_variant() ) << '\n';
+   for( const auto& obj : e.removed_objects )
+      (*_json_object_stream) << "{\"id\":" << fc::json::to_string( obj->id ) << "}\n";
 }
 
 void debug_witness_plugin::set_json_object_stream( const std::string& filename )
 {
+   database().block_events().wait_until_handled( plugin_name() );
    if( _json_object_stream )
    {
       _json_object_stream->close();
@@ -151,12 +126,14 @@ void debug_witness_plugin::set_json_object_stream( const std::string& filename )
 
 void debug_witness_plugin::flush_json_object_stream()
 {
+   database().block_events().wait_until_handled( plugin_name() );
    if( _json_object_stream )
       _json_object_stream->flush();
 }
 
 void debug_witness_plugin::plugin_shutdown()
 {
+   database().block_events().remove_consumer( plugin_name() );
    if( _json_object_stream )
    {
       _json_object_stream->close();
@@ -52,18 +52,14 @@ public:
 
 private:
 
-   void on_changed_objects( const std::vector<graphene::db::object_id_type>& ids, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts );
-   void on_removed_objects( const std::vector<graphene::db::object_id_type>& ids, const std::vector<const graphene::db::object*> objs, const fc::flat_set<graphene::chain::account_id_type>& impacted_accounts );
-   void on_applied_block( const graphene::chain::signed_block& b );
+   /// runs on the block event consumer thread of this plugin
+   void on_block_event( const graphene::chain::applied_block_event& e );
 
    boost::program_options::variables_map _options;
 
    std::map<chain::public_key_type, fc::ecc::private_key> _private_keys;
 
    std::shared_ptr< std::ofstream > _json_object_stream;
-   boost::signals2::scoped_connection _applied_block_conn;
-   boost::signals2::scoped_connection _changed_objects_conn;
-   boost::signals2::scoped_connection _removed_objects_conn;
 };
 
 } } //graphene::debug_witness_plugin
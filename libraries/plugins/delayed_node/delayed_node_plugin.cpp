@@ -30,8 +30,11 @@
 #include <fc/network/http/websocket.hpp>
 #include <fc/rpc/websocket_api.hpp>
 #include <fc/api.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/smart_ref_impl.hpp>
+#include <fc/thread/future.hpp>
 
+#include <deque>
 
 namespace graphene { namespace delayed_node {
 namespace bpo = boost::program_options;
@@ -45,6 +48,9 @@ struct delayed_node_plugin_impl {
    boost::signals2::scoped_connection client_connection_closed;
    graphene::chain::block_id_type last_received_remote_head;
    graphene::chain::block_id_type last_processed_remote_head;
+   uint32_t batch_size = 100;
+   uint32_t batches_in_flight = 4;
+   bool packed_blocks = true;
 };
 }
 
@@ -59,6 +65,9 @@ void delayed_node_plugin::plugin_set_program_options(bpo::options_description& c
 {
    cli.add_options()
          ("trusted-node", boost::program_options::value<std::string>()->required(), "RPC endpoint of a trusted validating node (required)")
+         ("delayed-node-batch-size", boost::program_options::value<uint32_t>()->default_value(100), "Number of blocks fetched from the trusted node per request, at most 1000")
+         ("delayed-node-batches-in-flight", boost::program_options::value<uint32_t>()->default_value(4), "Number of block requests to the trusted node that are kept outstanding while blocks are applied")
+         ("delayed-node-packed-blocks", boost::program_options::value<bool>()->default_value(true), "Fetch blocks from the trusted node in binary form instead of JSON")
          ;
    cfg.add(cli);
 }
@@ -75,6 +84,25 @@ void delayed_node_plugin::connect()
 void delayed_node_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    my->remote_endpoint = "ws://" + options.at("trusted-node").as<std::string>();
+   if( options.count("delayed-node-batch-size") )
+      my->batch_size = std::min( std::max( options.at("delayed-node-batch-size").as<uint32_t>(), 1u ), 1000u );
+   if( options.count("delayed-node-batches-in-flight") )
+      my->batches_in_flight = std::max( options.at("delayed-node-batches-in-flight").as<uint32_t>(), 1u );
+   if( options.count("delayed-node-packed-blocks") )
+      my->packed_blocks = options.at("delayed-node-packed-blocks").as<bool>();
+}
+
+std::vector<graphene::chain::signed_block> delayed_node_plugin::fetch_blocks( uint32_t block_num, uint32_t count )
+{
+   graphene::app::block_range range = my->database_api->get_block_range( block_num, count, my->packed_blocks );
+   if( !my->packed_blocks )
+      return std::move( range.blocks );
+
+   std::vector<graphene::chain::signed_block> result( range.packed_block_sizes.size() );
+   fc::datastream<const char*> ds( range.packed_blocks.data(), range.packed_blocks.size() );
+   for( auto& block : result )
+      fc::raw::unpack( ds, block );
+   return result;
 }
 
 void delayed_node_plugin::sync_with_trusted_node()
@@ -98,13 +126,63 @@ void delayed_node_plugin::sync_with_trusted_node()
          break;
       }
       pass_count++;
-      while( remote_dpo.last_irreversible_block_num > db.head_block_num() )
+
+      // keep several batches requested from the trusted node while the oldest one is applied
+      const uint32_t target = remote_dpo.last_irreversible_block_num;
+      uint32_t next_to_fetch = db.head_block_num() + 1;
+      std::deque< std::pair< uint32_t, fc::future< std::vector<graphene::chain::signed_block> > > > in_flight;
+      auto discard_in_flight = [&in_flight]()
+      {
+         for( auto& batch : in_flight )
+         {
+            try
+            {
+               batch.second.wait();
+            }
+            catch( const fc::exception& )
+            {
+            }
+         }
+         in_flight.clear();
+      };
+      try
+      {
+         while( target > db.head_block_num() )
+         {
+            while( in_flight.size() < my->batches_in_flight && next_to_fetch <= target )
+            {
+               const uint32_t count = std::min( my->batch_size, target - next_to_fetch + 1 );
+               in_flight.emplace_back( count, fc::async( [this,next_to_fetch,count]()
+               {
+                  return fetch_blocks( next_to_fetch, count );
+               }, "delayed_node fetch blocks" ) );
+               next_to_fetch += count;
+            }
+
+            const uint32_t count = in_flight.front().first;
+            const std::vector<graphene::chain::signed_block> blocks = in_flight.front().second.wait();
+            in_flight.pop_front();
+            FC_ASSERT( !blocks.empty(), "Trusted node claims it has blocks it doesn't actually have." );
+            ilog( "Pushing blocks #${f} - #${l}", ("f", blocks.front().block_num())("l", blocks.back().block_num()) );
+            for( const auto& block : blocks )
+            {
+               FC_ASSERT( block.block_num() == db.head_block_num() + 1, "Trusted node returned block ${n} out of order",
+                          ("n", block.block_num())("head", db.head_block_num()) );
+               db.push_block( block );
+               synced_blocks++;
+            }
+            // the batches after a short one do not continue the chain, request them again
+            if( blocks.size() < count )
+            {
+               discard_in_flight();
+               next_to_fetch = db.head_block_num() + 1;
+            }
+         }
+      }
+      catch( const fc::exception& )
       {
-         fc::optional<graphene::chain::signed_block> block = my->database_api->get_block( db.head_block_num()+1 );
-         FC_ASSERT(block, "Trusted node claims it has blocks it doesn't actually have.");
-         ilog("Pushing block #${n}", ("n", block->block_num()));
-         db.push_block(*block);
-         synced_blocks++;
+         discard_in_flight();
+         throw;
       }
    }
 }
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/plugin.hpp>
+#include <graphene/chain/protocol/block.hpp>
 
 namespace graphene { namespace delayed_node {
 namespace detail { struct delayed_node_plugin_impl; }
@@ -46,6 +47,9 @@ protected:
    void connection_failed();
    void connect();
    void sync_with_trusted_node();
+   /// fetches up to count blocks starting at block_num from the trusted node, fewer at its head block or if they
+   /// exceed the size of one get_block_range page
+   std::vector<graphene::chain::signed_block> fetch_blocks( uint32_t block_num, uint32_t count );
 };
 
 } } //graphene::account_history
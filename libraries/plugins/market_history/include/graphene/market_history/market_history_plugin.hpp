@@ -45,6 +45,8 @@ using namespace chain;
 #define ACCOUNT_HISTORY_SPACE_ID 5
 #endif
 
+#define MARKET_TICKER_TYPE_ID 4
+
 struct bucket_key
 {
    bucket_key( asset_id_type a, asset_id_type b, uint32_t s, fc::time_point_sec o )
@@ -104,9 +106,46 @@ struct order_history_object : public abstract_object<order_history_object>
   history_key          key; 
   fc::time_point_sec   time;
   fill_order_operation op;
+
+  asset_id_type base()const { return key.base; }
+  asset_id_type quote()const { return key.quote; }
+  /** each trade is recorded once for every side of it, trades are listed through the side that pays the base */
+  bool          pays_base()const { return op.pays.asset_id == key.base; }
+};
+
+/**
+ *  Rolling 24 hour summary of a market, kept up to date as fills arrive and as they leave the window so that
+ *  tickers can be served without walking the fill history.  Like buckets, prices are base/quote with base being
+ *  the asset with the lower id.
+ */
+struct market_ticker_object : public abstract_object<market_ticker_object>
+{
+   static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = MARKET_TICKER_TYPE_ID;
+
+   price latest()const { return asset( latest_base, base ) / asset( latest_quote, quote ); }
+   price day_open()const { return asset( day_open_base, base ) / asset( day_open_quote, quote ); }
+   bool  has_day_open()const { return day_open_quote != 0; }
+
+   asset_id_type       base;
+   asset_id_type       quote;
+   /// the most recent fill
+   share_type          latest_base;
+   share_type          latest_quote;
+   /// the last fill that left the 24 hour window
+   share_type          day_open_base;
+   share_type          day_open_quote;
+   share_type          base_volume;
+   share_type          quote_volume;
+   /// sequence and time of the oldest fill in the window, time is maximum() while the window is empty
+   int64_t             window_start_sequence = 0;
+   fc::time_point_sec  window_start = fc::time_point_sec::maximum();
 };
 
 struct by_key;
+struct by_market;
+struct by_market_time;
+struct by_window_start;
 typedef multi_index_container<
    bucket_object,
    indexed_by<
@@ -119,13 +158,47 @@ typedef multi_index_container<
    order_history_object,
    indexed_by<
       hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-      ordered_unique< tag<by_key>, member< order_history_object, history_key, &order_history_object::key > >
+      ordered_unique< tag<by_key>, member< order_history_object, history_key, &order_history_object::key > >,
+      ordered_unique< tag<by_market_time>,
+         composite_key< order_history_object,
+            const_mem_fun< order_history_object, asset_id_type, &order_history_object::base >,
+            const_mem_fun< order_history_object, asset_id_type, &order_history_object::quote >,
+            const_mem_fun< order_history_object, bool, &order_history_object::pays_base >,
+            member< order_history_object, fc::time_point_sec, &order_history_object::time >,
+            member< order_history_object, history_key, &order_history_object::key >
+         >,
+         composite_key_compare<
+            std::less< asset_id_type >,
+            std::less< asset_id_type >,
+            std::greater< bool >,
+            std::greater< fc::time_point_sec >,
+            std::less< history_key >
+         >
+      >
    >
 > order_history_multi_index_type;
 
 
+typedef multi_index_container<
+   market_ticker_object,
+   indexed_by<
+      hashed_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_market>,
+         composite_key< market_ticker_object,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::base >,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::quote >
+         >
+      >,
+      ordered_non_unique< tag<by_window_start>,
+         member< market_ticker_object, fc::time_point_sec, &market_ticker_object::window_start >
+      >
+   >
+> market_ticker_multi_index_type;
+
+
 typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_index;
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
+typedef generic_index<market_ticker_object, market_ticker_multi_index_type> market_ticker_index;
 
 
 namespace detail
@@ -155,6 +228,13 @@ class market_history_plugin : public graphene::app::plugin
       uint32_t                    max_history()const;
       const flat_set<uint32_t>&   tracked_buckets()const;
 
+      /**
+       * @return up to @ref limit fills of the market that were pruned to the on-disk archive, newest first,
+       *         starting below the fill with @ref sequence; empty if archiving is disabled
+       */
+      vector<order_history_object> get_archived_fill_history( asset_id_type base, asset_id_type quote,
+                                                              int64_t sequence, uint32_t limit )const;
+
    private:
       friend class detail::market_history_plugin_impl;
       std::unique_ptr<detail::market_history_plugin_impl> my;
@@ -164,6 +244,12 @@ class market_history_plugin : public graphene::app::plugin
 
 FC_REFLECT( graphene::market_history::history_key, (base)(quote)(sequence) )
 FC_REFLECT_DERIVED( graphene::market_history::order_history_object, (graphene::db::object), (key)(time)(op) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_object, (graphene::db::object),
+                    (base)(quote)
+                    (latest_base)(latest_quote)
+                    (day_open_base)(day_open_quote)
+                    (base_volume)(quote_volume)
+                    (window_start_sequence)(window_start) )
 FC_REFLECT( graphene::market_history::bucket_key, (base)(quote)(seconds)(open) )
 FC_REFLECT_DERIVED( graphene::market_history::bucket_object, (graphene::db::object), 
                     (key)
@@ -33,14 +33,199 @@
 #include <graphene/chain/transaction_evaluation_state.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
+#include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/thread/thread.hpp>
 #include <fc/smart_ref_impl.hpp>
 
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
 namespace graphene { namespace market_history {
 
 namespace detail
 {
 
+/**
+ *  Keeps the fills pruned from memory in one append-only file per market.  Fills are pruned oldest first, so each
+ *  file is in chronological order and the newest archived fill is at its end.  Every record is followed by its
+ *  size so the files can be read backwards, newest first.
+ *
+ *  A damaged file, e.g. one whose last record was cut short by a crash, never stops block processing: it is
+ *  truncated to its intact records, or set aside if that fails, when fills of its market are archived next.
+ */
+class fill_history_archive
+{
+   public:
+      void open( const fc::path& dir )
+      {
+         _dir = dir;
+         fc::create_directories( _dir );
+      }
+      bool is_open()const { return !_dir.empty(); }
+
+      /// appends @ref o unless it was archived before, e.g. by a block that was popped since
+      void append( const order_history_object& o )
+      {
+         market& m = get_market( o.key.base, o.key.quote );
+         // sequences decrease as fills get newer
+         if( m.oldest_unarchived_sequence.valid() && o.key.sequence >= *m.oldest_unarchived_sequence )
+            return;
+         if( !m.out.is_open() )
+            m.out.open( m.file.generic_string(), std::ios::out | std::ios::binary | std::ios::app );
+         const auto data = fc::raw::pack( o );
+         const uint32_t size = data.size();
+         m.out.write( data.data(), data.size() );
+         m.out.write( (const char*)&size, sizeof(size) );
+         m.oldest_unarchived_sequence = o.key.sequence;
+      }
+
+      void flush()
+      {
+         for( auto& item : _markets )
+            if( item.second.out.is_open() )
+               item.second.out.flush();
+      }
+
+      /**
+       * up to @ref limit archived fills of a market, newest first, older than the fill with @ref sequence; stops
+       * at the first damaged record
+       */
+      vector<order_history_object> read( asset_id_type base, asset_id_type quote, int64_t sequence, uint32_t limit )const
+      {
+         vector<order_history_object> result;
+         if( !read_records( market_file( base, quote ), sequence, limit, result ) )
+            wlog( "fill history archive ${f} is damaged, returning the fills read before the damage",
+                  ("f",market_file( base, quote )) );
+         return result;
+      }
+
+   private:
+      struct market
+      {
+         fc::path          file;
+         std::ofstream     out;
+         optional<int64_t> oldest_unarchived_sequence;
+      };
+
+      fc::path market_file( asset_id_type base, asset_id_type quote )const
+      {
+         return _dir / ( fc::to_string( uint64_t(base.instance.value) ) + "-" + fc::to_string( uint64_t(quote.instance.value) ) );
+      }
+
+      /// @return false if a damaged record was met before @ref limit fills were read or the file was exhausted
+      static bool read_records( const fc::path& file, int64_t sequence, uint32_t limit,
+                                vector<order_history_object>& result )
+      {
+         if( limit == 0 || !fc::exists( file ) )
+            return true;
+         std::ifstream in( file.generic_string(), std::ios::binary );
+         in.seekg( 0, std::ios::end );
+         int64_t pos = in.tellg();
+         while( pos > 0 && result.size() < limit )
+         {
+            uint32_t size = 0;
+            if( pos < int64_t(sizeof(size)) )
+               return false;
+            in.seekg( pos - sizeof(size) );
+            in.read( (char*)&size, sizeof(size) );
+            pos -= sizeof(size) + int64_t(size);
+            if( !in || pos < 0 )
+               return false;
+            vector<char> data( size );
+            in.seekg( pos );
+            in.read( data.data(), size );
+            if( !in )
+               return false;
+            try
+            {
+               auto o = fc::raw::unpack<order_history_object>( data );
+               if( o.key.sequence > sequence )
+                  result.push_back( std::move( o ) );
+            }
+            catch( const fc::exception& )
+            {
+               return false;
+            }
+         }
+         return true;
+      }
+
+      /**
+       * Truncates @ref file to the records that can be read from its start, or moves it aside if that fails, so
+       * that appending to it produces a readable file again.
+       */
+      static void repair( const fc::path& file )
+      {
+         uint64_t valid = 0;
+         try
+         {
+            std::string contents;
+            fc::read_file_contents( file, contents );
+            fc::datastream<const char*> ds( contents.data(), contents.size() );
+            while( ds.remaining() > 0 )
+            {
+               order_history_object o;
+               fc::raw::unpack( ds, o );
+               uint32_t size = 0;
+               fc::raw::unpack( ds, size );
+               if( size != ds.tellp() - valid - sizeof(size) )
+                  break;
+               valid = ds.tellp();
+            }
+         }
+         catch( const fc::exception& )
+         {
+            // the first damaged record ends the intact part
+         }
+
+         try
+         {
+            elog( "fill history archive ${f} is damaged, truncating it to its first ${n} bytes",
+                  ("f",file)("n",valid) );
+            boost::filesystem::resize_file( boost::filesystem::path( file.generic_string() ), valid );
+         }
+         catch( const std::exception& e )
+         {
+            const fc::path damaged = file.generic_string() + ".damaged";
+            elog( "could not truncate fill history archive ${f}: ${e}, moving it to ${d}",
+                  ("f",file)("e",e.what())("d",damaged) );
+            try
+            {
+               fc::rename( file, damaged );
+            }
+            catch( ... )
+            {
+               elog( "could not move fill history archive ${f} aside, fills archived next may not be readable",
+                     ("f",file) );
+            }
+         }
+      }
+
+      market& get_market( asset_id_type base, asset_id_type quote )
+      {
+         auto itr = _markets.find( std::make_pair( base, quote ) );
+         if( itr != _markets.end() )
+            return itr->second;
+         market& m = _markets[ std::make_pair( base, quote ) ];
+         m.file = market_file( base, quote );
+         vector<order_history_object> last;
+         if( !read_records( m.file, std::numeric_limits<int64_t>::min(), 1, last ) )
+         {
+            repair( m.file );
+            last.clear();
+            read_records( m.file, std::numeric_limits<int64_t>::min(), 1, last );
+         }
+         if( !last.empty() )
+            m.oldest_unarchived_sequence = last.front().key.sequence;
+         return m;
+      }
+
+      fc::path                                                 _dir;
+      std::map< std::pair<asset_id_type,asset_id_type>, market > _markets;
+};
+
 class market_history_plugin_impl
 {
    public:
@@ -53,6 +238,22 @@ class market_history_plugin_impl
        */
       void update_market_histories( const signed_block& b );
 
+      /**
+       * Removes fills of the market that are outside the configured retention, oldest first, and archives them
+       * if enabled.  The newest fill of a market is always kept so that sequence numbers are never reused.
+       * @return the number of fills removed, at most @ref budget
+       */
+      uint32_t prune_fill_history( asset_id_type base, asset_id_type quote, uint32_t budget );
+
+      /// removes the fills that left the 24 hour window from the tickers
+      void expire_tickers();
+
+      /**
+       * Creates the tickers of markets that have fills but no ticker, e.g. after an upgrade from a version
+       * without tickers that did not replay, from the fills in memory.
+       */
+      void backfill_tickers();
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -61,16 +262,32 @@ class market_history_plugin_impl
       market_history_plugin&     _self;
       flat_set<uint32_t>         _tracked_buckets;
       uint32_t                   _maximum_history_per_bucket_size = 1000;
+      uint32_t                   _max_fill_history_per_market = 1000;
+      uint32_t                   _max_fill_history_seconds = 259200;
+      bool                       _archive_fill_history = false;
+      fill_history_archive       _archive;
+      /// markets with fills in the block being processed
+      flat_set< std::pair<asset_id_type,asset_id_type> > _touched_markets;
+      /// last market visited by the sweep that applies the age limit to markets without new fills
+      optional< std::pair<asset_id_type,asset_id_type> > _sweep_cursor;
 };
 
+/// upper bound of fills removed per block, so that enabling retention on a large history does not stall a block
+static const uint32_t max_fills_pruned_per_block = 2000;
+
+/// length of the window summarized by market_ticker_object
+static const uint32_t ticker_window_seconds = 86400;
+
 
 struct operation_process_fill_order
 {
    market_history_plugin&    _plugin;
    fc::time_point_sec        _now;
+   flat_set< std::pair<asset_id_type,asset_id_type> >& _touched_markets;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n )
-   :_plugin(mhp),_now(n) {}
+   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n,
+                                 flat_set< std::pair<asset_id_type,asset_id_type> >& touched )
+   :_plugin(mhp),_now(n),_touched_markets(touched) {}
 
    typedef void result_type;
 
@@ -108,19 +325,31 @@ struct operation_process_fill_order
          ho.op = o;
       });
 
-      hkey.sequence += 200;
-      itr = history_idx.lower_bound( hkey );
-      /*
-      while( itr != history_idx.end() )
+      // pruned once the whole block is processed
+      _touched_markets.insert( std::make_pair( hkey.base, hkey.quote ) );
+
+      // every match is reported once from each side, the ticker counts the side the buckets count
+      if( o.pays.asset_id < o.receives.asset_id )
       {
-         if( itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-         {
-            db.remove( *itr );
-            itr = history_idx.lower_bound( hkey );
-         }
-         else break;
+         const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+         auto ticker = ticker_idx.find( boost::make_tuple( hkey.base, hkey.quote ) );
+         if( ticker == ticker_idx.end() )
+            ticker = ticker_idx.iterator_to( db.create<market_ticker_object>( [&]( market_ticker_object& t ) {
+               t.base = hkey.base;
+               t.quote = hkey.quote;
+            }));
+         db.modify( *ticker, [&]( market_ticker_object& t ) {
+            t.latest_base = o.pays.amount;
+            t.latest_quote = o.receives.amount;
+            t.base_volume += o.pays.amount;
+            t.quote_volume += o.receives.amount;
+            if( t.window_start == fc::time_point_sec::maximum() )
+            {
+               t.window_start_sequence = hkey.sequence;
+               t.window_start = time;
+            }
+         });
       }
-      */
 
 
       auto max_history = _plugin.max_history();
@@ -220,12 +449,216 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    if( _tracked_buckets.size() == 0 ) return;
 
    graphene::chain::database& db = database();
+   if( _archive_fill_history && !_archive.is_open() )
+      _archive.open( db.get_data_dir() / "market_history" / "fills" );
+
+   _touched_markets.clear();
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
       if( o_op.valid() )
-         o_op->op.visit( operation_process_fill_order( _self, b.timestamp ) );
+         o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _touched_markets ) );
+   }
+
+   // fills are pruned only once they left the ticker window, so expire them first
+   expire_tickers();
+
+   if( _max_fill_history_per_market == 0 && _max_fill_history_seconds == 0 )
+      return;
+
+   uint32_t budget = max_fills_pruned_per_block;
+   for( const auto& market : _touched_markets )
+      budget -= prune_fill_history( market.first, market.second, budget );
+
+   // markets without new fills only age, visit one of them per block
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
+   history_key next;
+   next.sequence = std::numeric_limits<int64_t>::max();
+   if( _sweep_cursor.valid() )
+   {
+      next.base = _sweep_cursor->first;
+      next.quote = _sweep_cursor->second;
+   }
+   auto itr = _sweep_cursor.valid() ? history_idx.upper_bound( next ) : history_idx.begin();
+   if( itr == history_idx.end() )
+      itr = history_idx.begin();
+   if( itr != history_idx.end() )
+   {
+      _sweep_cursor = std::make_pair( itr->key.base, itr->key.quote );
+      prune_fill_history( itr->key.base, itr->key.quote, budget );
+   }
+
+   if( _archive.is_open() )
+      _archive.flush();
+}
+
+uint32_t market_history_plugin_impl::prune_fill_history( asset_id_type base, asset_id_type quote, uint32_t budget )
+{
+   graphene::chain::database& db = database();
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
+
+   history_key key;
+   key.base = base;
+   key.quote = quote;
+   key.sequence = std::numeric_limits<int64_t>::min();
+   auto newest = history_idx.lower_bound( key );
+   if( newest == history_idx.end() || newest->key.base != base || newest->key.quote != quote )
+      return 0;
+   const int64_t newest_sequence = newest->key.sequence;
+   const fc::time_point_sec cutoff = db.head_block_time() - _max_fill_history_seconds;
+   const fc::time_point_sec ticker_cutoff = db.head_block_time() - ticker_window_seconds;
+
+   // a fill is kept while it is within either limit, and while the ticker still counts it
+   auto outside_retention = [&]( const order_history_object& o ) {
+      const bool beyond_count = _max_fill_history_per_market == 0
+                                || o.key.sequence - newest_sequence >= _max_fill_history_per_market;
+      const bool too_old = _max_fill_history_seconds == 0 || o.time < cutoff;
+      return beyond_count && too_old && o.time < ticker_cutoff && o.key.sequence != newest_sequence;
+   };
+
+   uint32_t removed = 0;
+   key.sequence = std::numeric_limits<int64_t>::max();
+   while( removed < budget )
+   {
+      // the oldest fill of the market sits just before the upper bound
+      auto itr = history_idx.upper_bound( key );
+      if( itr == history_idx.begin() )
+         break;
+      --itr;
+      if( itr->key.base != base || itr->key.quote != quote || !outside_retention( *itr ) )
+         break;
+      if( _archive.is_open() )
+         _archive.append( *itr );
+      db.remove( *itr );
+      ++removed;
    }
+   return removed;
+}
+
+void market_history_plugin_impl::expire_tickers()
+{
+   graphene::chain::database& db = database();
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_window_start>();
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
+   const fc::time_point_sec cutoff = db.head_block_time() - ticker_window_seconds;
+
+   while( !ticker_idx.empty() && ticker_idx.begin()->window_start < cutoff )
+   {
+      const market_ticker_object& ticker = *ticker_idx.begin();
+      history_key key;
+      key.base = ticker.base;
+      key.quote = ticker.quote;
+      key.sequence = ticker.window_start_sequence;
+
+      db.modify( ticker, [&]( market_ticker_object& t ) {
+         t.window_start = fc::time_point_sec::maximum();
+         auto itr = history_idx.find( key );
+         if( itr == history_idx.end() )
+         {
+            // the window lost track of its fills, start over
+            t.base_volume = 0;
+            t.quote_volume = 0;
+            return;
+         }
+         // walk towards newer fills, which have lower sequence numbers
+         while( true )
+         {
+            const auto& fill = itr->op;
+            if( fill.pays.asset_id < fill.receives.asset_id )
+            {
+               if( itr->time >= cutoff )
+               {
+                  t.window_start_sequence = itr->key.sequence;
+                  t.window_start = itr->time;
+                  break;
+               }
+               t.base_volume -= fill.pays.amount;
+               t.quote_volume -= fill.receives.amount;
+               t.day_open_base = fill.pays.amount;
+               t.day_open_quote = fill.receives.amount;
+            }
+            if( itr == history_idx.begin() )
+               break;
+            --itr;
+            if( itr->key.base != t.base || itr->key.quote != t.quote )
+               break;
+         }
+      });
+   }
+}
+
+void market_history_plugin_impl::backfill_tickers()
+{
+   graphene::chain::database& db = database();
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   const auto& history_idx = db.get_index_type<history_index>().indices().get<by_key>();
+   const fc::time_point_sec cutoff = db.head_block_time() - ticker_window_seconds;
+
+   uint32_t created = 0;
+   auto itr = history_idx.begin();
+   while( itr != history_idx.end() )
+   {
+      const asset_id_type base = itr->key.base;
+      const asset_id_type quote = itr->key.quote;
+      auto is_market = [&]( const order_history_object& o ) { return o.key.base == base && o.key.quote == quote; };
+
+      if( ticker_idx.find( boost::make_tuple( base, quote ) ) != ticker_idx.end() )
+      {
+         while( itr != history_idx.end() && is_market( *itr ) )
+            ++itr;
+         continue;
+      }
+
+      // fills of a market start with the newest, count the side that operation_process_fill_order counts
+      market_ticker_object ticker;
+      ticker.base = base;
+      ticker.quote = quote;
+      bool has_fill = false;
+      bool has_day_open = false;
+      for( ; itr != history_idx.end() && is_market( *itr ); ++itr )
+      {
+         const auto& fill = itr->op;
+         if( has_day_open || !( fill.pays.asset_id < fill.receives.asset_id ) )
+            continue;
+         if( !has_fill )
+         {
+            ticker.latest_base = fill.pays.amount;
+            ticker.latest_quote = fill.receives.amount;
+            has_fill = true;
+         }
+         if( itr->time >= cutoff )
+         {
+            ticker.base_volume += fill.pays.amount;
+            ticker.quote_volume += fill.receives.amount;
+            ticker.window_start_sequence = itr->key.sequence;
+            ticker.window_start = itr->time;
+         }
+         else
+         {
+            ticker.day_open_base = fill.pays.amount;
+            ticker.day_open_quote = fill.receives.amount;
+            has_day_open = true;
+         }
+      }
+      if( !has_fill )
+         continue;
+
+      db.create<market_ticker_object>( [&]( market_ticker_object& t ) {
+         t.base = ticker.base;
+         t.quote = ticker.quote;
+         t.latest_base = ticker.latest_base;
+         t.latest_quote = ticker.latest_quote;
+         t.day_open_base = ticker.day_open_base;
+         t.day_open_quote = ticker.day_open_quote;
+         t.base_volume = ticker.base_volume;
+         t.quote_volume = ticker.quote_volume;
+         t.window_start_sequence = ticker.window_start_sequence;
+         t.window_start = ticker.window_start;
+      });
+      ++created;
+   }
+   if( created > 0 )
+      ilog( "created ${n} market tickers from the fill history", ("n",created) );
 }
 
 } // end namespace detail
@@ -259,6 +692,12 @@ void market_history_plugin::plugin_set_program_options(
            "Track market history by grouping orders into buckets of equal size measured in seconds specified as a JSON array of numbers")
          ("history-per-size", boost::program_options::value<uint32_t>()->default_value(1000), 
            "How far back in time to track history for each bucket size, measured in the number of buckets (default: 1000)")
+         ("max-fill-history-per-market", boost::program_options::value<uint32_t>()->default_value(1000),
+           "Number of most recent fills kept for each market, 0 to not limit by count (default: 1000)")
+         ("max-fill-history-seconds", boost::program_options::value<uint32_t>()->default_value(259200),
+           "Age in seconds after which fills beyond max-fill-history-per-market are pruned, 0 to not limit by age (default: 259200)")
+         ("fill-history-archive", boost::program_options::value<bool>()->default_value(false),
+           "Keep pruned fills on disk so that the API can still serve them (default: false)")
          ;
    cfg.add(cli);
 }
@@ -268,6 +707,7 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    database().applied_block.connect( [&]( const signed_block& b){ my->update_market_histories(b); } );
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
+   database().add_index< primary_index< market_ticker_index  > >();
 
    if( options.count( "bucket-size" ) )
    {
@@ -276,10 +716,17 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    }
    if( options.count( "history-per-size" ) )
       my->_maximum_history_per_bucket_size = options["history-per-size"].as<uint32_t>();
+   if( options.count( "max-fill-history-per-market" ) )
+      my->_max_fill_history_per_market = options["max-fill-history-per-market"].as<uint32_t>();
+   if( options.count( "max-fill-history-seconds" ) )
+      my->_max_fill_history_seconds = options["max-fill-history-seconds"].as<uint32_t>();
+   if( options.count( "fill-history-archive" ) )
+      my->_archive_fill_history = options["fill-history-archive"].as<bool>();
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
 {
+   my->backfill_tickers();
 }
 
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
@@ -292,4 +739,12 @@ uint32_t market_history_plugin::max_history()const
    return my->_maximum_history_per_bucket_size;
 }
 
+vector<order_history_object> market_history_plugin::get_archived_fill_history( asset_id_type base, asset_id_type quote,
+                                                                               int64_t sequence, uint32_t limit )const
+{
+   if( !my->_archive_fill_history )
+      return vector<order_history_object>();
+   return my->_archive.read( base, quote, sequence, limit );
+}
+
 } }
@@ -31,6 +31,7 @@
 #include <fc/thread/future.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/db/generic_index.hpp>
+#include <graphene/transaction_record/transaction_record_store.hpp>
 
 namespace graphene { namespace transaction_record {
 
@@ -42,6 +43,10 @@ using namespace chain;
 
 #define TRANSACTION_RECORD_TYPE_ID 3
 
+/**
+ * Position of a transaction in a reversible block.  Once the block becomes irreversible the record is moved to
+ * the transaction_record_store attached to the index of these objects.
+ */
 struct transaction_record_object : public abstract_object<transaction_record_object> {
     static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
     static const uint8_t type_id  = TRANSACTION_RECORD_TYPE_ID;
@@ -94,6 +99,10 @@ class transaction_record_plugin : public graphene::app::plugin {
         virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
         virtual void plugin_startup() override;
 
+        /// Looks @ref trx_id up among the records of reversible blocks and then in the store
+        static optional<transaction_record_store::record> find_transaction_record(
+                const graphene::chain::database& db, const transaction_id_type& trx_id);
+
         friend class detail::transaction_record_plugin_impl;
         std::unique_ptr<detail::transaction_record_plugin_impl> my;
 };
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/index.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <fstream>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace graphene { namespace transaction_record {
+
+using namespace chain;
+
+/**
+ *  Maps the ids of transactions in irreversible blocks to their position in the chain, on disk.
+ *
+ *  Records are appended block by block to a log, which is replayed on open and therefore stays small: every
+ *  @ref run_size records the log is sorted by transaction id and written out as an immutable run.  Runs are
+ *  merged four at a time into runs of the next level, so a store of n records holds O(log n) runs.  Runs are
+ *  memory mapped and searched in place; only the log and an LRU cache of recent lookups are kept in RAM.
+ *
+ *  The store is attached as a secondary index to the index of transaction_record_object, which holds the
+ *  records of reversible blocks, so that it can be found by the API.
+ */
+class transaction_record_store : public graphene::db::secondary_index
+{
+   public:
+      struct record
+      {
+         transaction_id_type trx_id;
+         uint32_t            block_num    = 0;
+         uint32_t            trx_in_block = 0;
+      };
+
+      static const uint32_t run_size = 1 << 16;
+      static const uint32_t runs_per_level = 4;
+
+      transaction_record_store();
+      ~transaction_record_store();
+
+      void open( const fc::path& dir );
+      void close();
+      bool is_open()const { return _log.is_open(); }
+
+      /// sets the number of lookups kept in the cache, 0 disables caching
+      void set_cache_size( uint32_t entries );
+
+      /// The highest block whose records have been stored, records of blocks up to it are ignored by store()
+      uint32_t last_block_num()const { return _last_block_num; }
+
+      /// Stores the records of one block, all of which must have block_num > last_block_num()
+      void store( uint32_t block_num, const vector<record>& records );
+
+      optional<record> find( const transaction_id_type& trx_id )const;
+
+   private:
+      struct run;
+
+      void append_to_log( const record& r );
+      void write_run();
+      /// merges full levels into the next one and returns the files of the runs merged away
+      vector<fc::path> merge_runs();
+      void write_manifest()const;
+      fc::path run_path( uint32_t seq )const;
+      void touch_cache( const record& r )const;
+
+      fc::path                                             _dir;
+      std::ofstream                                        _log;
+      vector< std::unique_ptr<run> >                       _runs;
+      uint32_t                                             _next_run_seq = 0;
+      /// highest block in the runs, the rest is in _unsorted and the log
+      uint32_t                                             _runs_block_num = 0;
+      uint32_t                                             _last_block_num = 0;
+      std::unordered_map< transaction_id_type, record >    _unsorted;
+
+      uint32_t                                             _cache_size = 4096;
+      mutable std::list<record>                            _cache_lru;
+      mutable std::unordered_map< transaction_id_type, std::list<record>::iterator > _cache;
+};
+
+} } // graphene::transaction_record
@@ -23,6 +23,7 @@
  */
 
 #include <graphene/transaction_record/transaction_record_plugin.hpp>
+#include <graphene/transaction_record/transaction_record_store.hpp>
 
 #include <graphene/app/impacted.hpp>
 
@@ -51,11 +52,16 @@ class transaction_record_plugin_impl {
         */
         void update_transaction_records( const signed_block& b );
 
+        /// moves the records of irreversible blocks from the object database to the store
+        void store_irreversible_records();
+
         graphene::chain::database& database() {
             return _self.database();
         }
 
         transaction_record_plugin& _self;
+        transaction_record_store*  _store = nullptr;
+        uint32_t                   _cache_size = 4096;
 };
 
 transaction_record_plugin_impl::~transaction_record_plugin_impl() {
@@ -64,18 +70,46 @@ transaction_record_plugin_impl::~transaction_record_plugin_impl() {
 
 void transaction_record_plugin_impl::update_transaction_records( const signed_block& b ) {
     graphene::chain::database& db = database();
+    if (!_store->is_open()) {
+        // the store lives next to the block log it indexes, which is known once the database is open
+        _store->open(db.get_data_dir() / "database" / "transaction_record");
+        _store->set_cache_size(_cache_size);
+    }
+
     uint32_t block_num = b.block_num();
-    uint32_t counter = 0;
-    for (auto trx : b.transactions) {
+    const auto& trx_ids = db.get_applied_transaction_ids();
+    FC_ASSERT(trx_ids.size() == b.transactions.size());
+    for (uint32_t i = 0; i < trx_ids.size(); ++i) {
         db.create<transaction_record_object>([&](transaction_record_object &obj) {
-            obj.trx_id = trx.id();
+            obj.trx_id = trx_ids[i];
             obj.block_num = block_num;
-            obj.trx_in_block = counter++;
-            // wlog("trx=${trx}", ("trx", trx.id()));
+            obj.trx_in_block = i;
         });
     }
-    if (b.transactions.size() > 0 || block_num % 10000 == 0) {
-        wlog("update_transaction_records, block_num=${block_num}, trx_num=${trx_num}", ("block_num", block_num)("trx_num", counter));
+    store_irreversible_records();
+}
+
+void transaction_record_plugin_impl::store_irreversible_records() {
+    graphene::chain::database& db = database();
+    const uint32_t irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+    // records are created in block order, so the irreversible ones are at the front
+    const auto& idx = db.get_index_type<transaction_record_index>().indices().get<by_id>();
+    vector<transaction_record_store::record> records;
+    while (!idx.empty() && idx.begin()->block_num <= irreversible) {
+        const transaction_record_object& obj = *idx.begin();
+        if (!records.empty() && records.back().block_num != obj.block_num) {
+            _store->store(records.back().block_num, records);
+            records.clear();
+        }
+        transaction_record_store::record r;
+        r.trx_id = obj.trx_id;
+        r.block_num = obj.block_num;
+        r.trx_in_block = obj.trx_in_block;
+        records.push_back(r);
+        db.remove(obj);
+    }
+    if (!records.empty()) {
+        _store->store(records.back().block_num, records);
     }
 }
 
@@ -95,14 +129,44 @@ std::string transaction_record_plugin::plugin_name()const {
 void transaction_record_plugin::plugin_set_program_options(
     boost::program_options::options_description& cli,
     boost::program_options::options_description& cfg) {
+    cli.add_options()
+        ("transaction-record-cache-size", boost::program_options::value<uint32_t>()->default_value(4096),
+         "Number of transaction records looked up from disk to keep in memory")
+        ;
+    cfg.add(cli);
 }
 
 void transaction_record_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
     database().applied_block.connect( [&](const signed_block& b){ my->update_transaction_records(b); } );
-    database().add_index< primary_index< transaction_record_index  > >();
+    auto records = database().add_index< primary_index< transaction_record_index  > >();
+    my->_store = records->add_secondary_index<transaction_record_store>();
+    if (options.count("transaction-record-cache-size")) {
+        my->_cache_size = options["transaction-record-cache-size"].as<uint32_t>();
+    }
 }
 
 void transaction_record_plugin::plugin_startup() {
 }
 
+optional<transaction_record_store::record> transaction_record_plugin::find_transaction_record(
+        const graphene::chain::database& db, const transaction_id_type& trx_id) {
+    const auto& index = db.get_index_type<transaction_record_index>();
+    // reversible blocks first, then the store
+    const auto& tail = index.indices().get<by_trx_id>();
+    auto it = tail.find(trx_id);
+    if (it != tail.end()) {
+        transaction_record_store::record r;
+        r.trx_id = it->trx_id;
+        r.block_num = it->block_num;
+        r.trx_in_block = it->trx_in_block;
+        return r;
+    }
+    const auto& store = dynamic_cast<const primary_index<transaction_record_index>&>(index)
+                        .get_secondary_index<transaction_record_store>();
+    if (!store.is_open()) {
+        return optional<transaction_record_store::record>();
+    }
+    return store.find(trx_id);
+}
+
 } } //end of namespace incentive_history
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/transaction_record/transaction_record_store.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <queue>
+
+namespace graphene { namespace transaction_record {
+
+namespace detail {
+   struct run_info
+   {
+      uint32_t seq   = 0;
+      uint8_t  level = 0;
+      uint64_t count = 0;
+   };
+
+   struct store_manifest
+   {
+      uint32_t          next_run_seq   = 0;
+      uint32_t          runs_block_num = 0;
+      vector<run_info>  runs;
+   };
+} // detail
+
+} } // graphene::transaction_record
+
+FC_REFLECT( graphene::transaction_record::detail::run_info, (seq)(level)(count) )
+FC_REFLECT( graphene::transaction_record::detail::store_manifest, (next_run_seq)(runs_block_num)(runs) )
+
+namespace graphene { namespace transaction_record {
+
+typedef transaction_record_store::record record;
+
+static_assert( sizeof(record) == sizeof(transaction_id_type) + 2 * sizeof(uint32_t),
+               "records are written to disk as they are laid out in memory" );
+
+namespace {
+   /// written to the log after the records of a block, records after the last marker are discarded on open
+   const uint32_t end_of_block = uint32_t(-1);
+
+   bool by_trx_id( const record& a, const record& b )
+   {
+      return a.trx_id < b.trx_id;
+   }
+}
+
+struct transaction_record_store::run
+{
+   run( const fc::path& file, uint32_t s, uint8_t l )
+      : seq(s), level(l),
+        mapping( file.generic_string().c_str(), boost::interprocess::read_only ),
+        region( mapping, boost::interprocess::read_only ) {}
+
+   const record* begin()const { return static_cast<const record*>( region.get_address() ); }
+   const record* end()const   { return begin() + region.get_size() / sizeof(record); }
+   uint64_t      size()const  { return end() - begin(); }
+
+   uint32_t                                seq;
+   uint8_t                                 level;
+   boost::interprocess::file_mapping       mapping;
+   boost::interprocess::mapped_region      region;
+};
+
+transaction_record_store::transaction_record_store() {}
+
+transaction_record_store::~transaction_record_store()
+{
+   close();
+}
+
+fc::path transaction_record_store::run_path( uint32_t seq )const
+{
+   return _dir / ( "run-" + fc::to_string( uint64_t(seq) ) );
+}
+
+void transaction_record_store::open( const fc::path& dir )
+{ try {
+   close();
+   _dir = dir;
+   fc::create_directories( _dir );
+
+   detail::store_manifest manifest;
+   if( fc::exists( _dir / "manifest" ) )
+   {
+      std::ifstream in( ( _dir / "manifest" ).generic_string(), std::ios::binary );
+      vector<char> data( ( std::istreambuf_iterator<char>(in) ), std::istreambuf_iterator<char>() );
+      manifest = fc::raw::unpack<detail::store_manifest>( data );
+   }
+   for( const auto& info : manifest.runs )
+   {
+      _runs.emplace_back( new run( run_path( info.seq ), info.seq, info.level ) );
+      FC_ASSERT( _runs.back()->size() == info.count, "transaction record run ${s} is damaged", ("s",info.seq) );
+   }
+   _next_run_seq = manifest.next_run_seq;
+   _runs_block_num = manifest.runs_block_num;
+   _last_block_num = _runs_block_num;
+
+   // the log holds the records of the blocks stored since the last run was written
+   const fc::path log_path = _dir / "log";
+   uint64_t complete_size = 0;
+   if( fc::exists( log_path ) )
+   {
+      std::ifstream in( log_path.generic_string(), std::ios::binary );
+      vector<record> block;
+      record r;
+      uint64_t pos = 0;
+      while( in.read( (char*)&r, sizeof(r) ) )
+      {
+         pos += sizeof(r);
+         if( r.trx_in_block != end_of_block )
+         {
+            block.push_back( r );
+            continue;
+         }
+         // a crash between writing a run and truncating the log leaves records that are in the runs already
+         if( r.block_num > _runs_block_num )
+            for( const auto& b : block )
+               _unsorted[b.trx_id] = b;
+         _last_block_num = std::max( _last_block_num, r.block_num );
+         block.clear();
+         complete_size = pos;
+      }
+      in.close();
+      if( fc::file_size( log_path ) != complete_size )
+      {
+         wlog( "Discarding incomplete block at the end of the transaction record log" );
+         fc::resize_file( log_path, complete_size );
+      }
+   }
+   _log.open( log_path.generic_string(), std::ios::out | std::ios::binary | std::ios::app );
+   FC_ASSERT( _log, "unable to open ${f}", ("f",log_path) );
+
+   ilog( "Opened transaction record store with ${r} runs and ${u} unsorted records up to block ${b}",
+         ("r",_runs.size())("u",_unsorted.size())("b",_last_block_num) );
+} FC_CAPTURE_AND_RETHROW( (dir) ) }
+
+void transaction_record_store::close()
+{
+   if( _log.is_open() )
+      _log.close();
+   _runs.clear();
+   _unsorted.clear();
+   _cache.clear();
+   _cache_lru.clear();
+   _next_run_seq = 0;
+   _runs_block_num = 0;
+   _last_block_num = 0;
+}
+
+void transaction_record_store::set_cache_size( uint32_t entries )
+{
+   _cache_size = entries;
+   while( _cache_lru.size() > _cache_size )
+   {
+      _cache.erase( _cache_lru.back().trx_id );
+      _cache_lru.pop_back();
+   }
+}
+
+void transaction_record_store::append_to_log( const record& r )
+{
+   _log.write( (const char*)&r, sizeof(r) );
+}
+
+void transaction_record_store::store( uint32_t block_num, const vector<record>& records )
+{ try {
+   FC_ASSERT( is_open() );
+   if( block_num <= _last_block_num || records.empty() )
+      return;
+
+   for( const auto& r : records )
+   {
+      append_to_log( r );
+      _unsorted[r.trx_id] = r;
+   }
+   record marker;
+   marker.block_num = block_num;
+   marker.trx_in_block = end_of_block;
+   append_to_log( marker );
+   _log.flush();
+   FC_ASSERT( _log, "unable to write the transaction record log" );
+   _last_block_num = block_num;
+
+   if( _unsorted.size() >= run_size )
+      write_run();
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
+void transaction_record_store::write_run()
+{
+   vector<record> sorted;
+   sorted.reserve( _unsorted.size() );
+   for( const auto& item : _unsorted )
+      sorted.push_back( item.second );
+   std::sort( sorted.begin(), sorted.end(), by_trx_id );
+
+   const uint32_t seq = _next_run_seq++;
+   {
+      std::ofstream out( run_path( seq ).generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+      out.write( (const char*)sorted.data(), sorted.size() * sizeof(record) );
+      FC_ASSERT( out, "unable to write transaction record run ${s}", ("s",seq) );
+   }
+   _runs.emplace_back( new run( run_path( seq ), seq, 0 ) );
+   _runs_block_num = _last_block_num;
+   _unsorted.clear();
+
+   const vector<fc::path> obsolete = merge_runs();
+   // the new runs take effect with the manifest, after which the log and the merged runs are no longer needed
+   write_manifest();
+   _log.close();
+   _log.open( ( _dir / "log" ).generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+   for( const auto& file : obsolete )
+      fc::remove( file );
+}
+
+vector<fc::path> transaction_record_store::merge_runs()
+{
+   vector<fc::path> obsolete;
+   for( uint8_t level = 0; ; ++level )
+   {
+      const auto full = std::count_if( _runs.begin(), _runs.end(),
+                                       [level]( const std::unique_ptr<run>& r ) { return r->level == level; } );
+      if( full < runs_per_level )
+         break;
+
+      vector< std::unique_ptr<run> > inputs;
+      for( auto itr = _runs.begin(); itr != _runs.end(); )
+      {
+         if( (*itr)->level == level )
+         {
+            inputs.push_back( std::move( *itr ) );
+            itr = _runs.erase( itr );
+         }
+         else
+            ++itr;
+      }
+
+      // k-way merge of the sorted inputs
+      typedef std::pair<const record*, const record*> cursor;
+      auto greater = []( const cursor& a, const cursor& b ) { return b.first->trx_id < a.first->trx_id; };
+      std::priority_queue< cursor, vector<cursor>, decltype(greater) > heads( greater );
+      for( const auto& input : inputs )
+         if( input->begin() != input->end() )
+            heads.push( cursor( input->begin(), input->end() ) );
+
+      const uint32_t seq = _next_run_seq++;
+      {
+         std::ofstream out( run_path( seq ).generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+         const record* previous = nullptr;
+         while( !heads.empty() )
+         {
+            cursor head = heads.top();
+            heads.pop();
+            if( previous == nullptr || previous->trx_id != head.first->trx_id )
+               out.write( (const char*)head.first, sizeof(record) );
+            previous = head.first;
+            if( ++head.first != head.second )
+               heads.push( head );
+         }
+         FC_ASSERT( out, "unable to write transaction record run ${s}", ("s",seq) );
+      }
+      _runs.emplace_back( new run( run_path( seq ), seq, level + 1 ) );
+      for( const auto& input : inputs )
+         obsolete.push_back( run_path( input->seq ) );
+   }
+   return obsolete;
+}
+
+void transaction_record_store::write_manifest()const
+{
+   detail::store_manifest manifest;
+   manifest.next_run_seq = _next_run_seq;
+   manifest.runs_block_num = _runs_block_num;
+   for( const auto& r : _runs )
+   {
+      detail::run_info info;
+      info.seq = r->seq;
+      info.level = r->level;
+      info.count = r->size();
+      manifest.runs.push_back( info );
+   }
+   const auto data = fc::raw::pack( manifest );
+   const fc::path tmp = _dir / "manifest.tmp";
+   {
+      std::ofstream out( tmp.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc );
+      out.write( data.data(), data.size() );
+      FC_ASSERT( out, "unable to write the transaction record manifest" );
+   }
+   fc::rename( tmp, _dir / "manifest" );
+}
+
+void transaction_record_store::touch_cache( const record& r )const
+{
+   if( _cache_size == 0 )
+      return;
+   auto itr = _cache.find( r.trx_id );
+   if( itr != _cache.end() )
+   {
+      _cache_lru.splice( _cache_lru.begin(), _cache_lru, itr->second );
+      return;
+   }
+   _cache_lru.push_front( r );
+   _cache[r.trx_id] = _cache_lru.begin();
+   if( _cache_lru.size() > _cache_size )
+   {
+      _cache.erase( _cache_lru.back().trx_id );
+      _cache_lru.pop_back();
+   }
+}
+
+optional<record> transaction_record_store::find( const transaction_id_type& trx_id )const
+{
+   auto cached = _cache.find( trx_id );
+   if( cached != _cache.end() )
+   {
+      touch_cache( *cached->second );
+      return *cached->second;
+   }
+
+   auto unsorted = _unsorted.find( trx_id );
+   if( unsorted != _unsorted.end() )
+   {
+      touch_cache( unsorted->second );
+      return unsorted->second;
+   }
+
+   record key;
+   key.trx_id = trx_id;
+   for( auto itr = _runs.rbegin(); itr != _runs.rend(); ++itr )
+   {
+      const record* found = std::lower_bound( (*itr)->begin(), (*itr)->end(), key, by_trx_id );
+      if( found != (*itr)->end() && found->trx_id == trx_id )
+      {
+         touch_cache( *found );
+         return *found;
+      }
+   }
+   return optional<record>();
+}
+
+} } // graphene::transaction_record
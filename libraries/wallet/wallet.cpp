@@ -128,6 +128,8 @@ public:
    std::string operator()(const deflation_operation& op)const;
    std::string operator()(const account_deflation_operation& op)const;
    std::string operator()(const order_deflation_operation& op)const;
+   std::string operator()(const account_bulk_deflation_operation& op)const;
+   std::string operator()(const order_bulk_deflation_operation& op)const;
    std::string operator()(const fill_order_operation& op)const;
    std::string operator()(const limit_order_cancel_operation& op)const;
 };
@@ -3042,6 +3044,20 @@ std::string operation_printer::operator()(const order_deflation_operation& op) c
    return fee(op.fee);
 }
 
+std::string operation_printer::operator()(const account_bulk_deflation_operation& op) const
+{
+   out << "Account bulk deflation - " << string(object_id_type(op.deflation_id))
+      << " accounts:" << string(object_id_type(op.first)) << " - " << string(object_id_type(op.last));
+   return fee(op.fee);
+}
+
+std::string operation_printer::operator()(const order_bulk_deflation_operation& op) const
+{
+   out << "Order bulk deflation - " << string(object_id_type(op.deflation_id))
+      << " orders:" << string(object_id_type(op.first)) << " - " << string(object_id_type(op.last));
+   return fee(op.fee);
+}
+
 std::string operation_printer::operator()(const fill_order_operation& op)const
 {
    out << "Fill Order - " << string(object_id_type(op.order_id)) << " owner:" << wallet.get_account(op.account_id).name
@@ -29,6 +29,7 @@
 #include <graphene/utilities/tempdir.hpp>
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/delayed_node/delayed_node_plugin.hpp>
 
 #include <fc/thread/thread.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -150,3 +151,178 @@ BOOST_AUTO_TEST_CASE( two_node_network )
       throw;
    }
 }
+
+// Relays blocks down a line of three nodes and reports how long they took to reach the far end and how
+// many bytes the nodes sent.  The first block's transaction was broadcast beforehand, so the nodes rebuild
+// it from their message caches; the second block's transaction was never broadcast, so the relaying nodes
+// have to fetch it.
+BOOST_AUTO_TEST_CASE( compact_block_relay )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory app1_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory app2_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory app3_dir( graphene::utilities::temp_directory_path() );
+
+      graphene::app::application app1;
+      boost::program_options::variables_map cfg1;
+      cfg1.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5151"), false));
+      app1.initialize(app1_dir.path(), cfg1);
+
+      graphene::app::application app2;
+      boost::program_options::variables_map cfg2;
+      cfg2.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5252"), false));
+      cfg2.emplace("seed-node", boost::program_options::variable_value(vector<string>{"127.0.0.1:5151"}, false));
+      app2.initialize(app2_dir.path(), cfg2);
+
+      graphene::app::application app3;
+      boost::program_options::variables_map cfg3;
+      cfg3.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:5353"), false));
+      cfg3.emplace("seed-node", boost::program_options::variable_value(vector<string>{"127.0.0.1:5252"}, false));
+      app3.initialize(app3_dir.path(), cfg3);
+
+      app1.startup();
+      fc::usleep(fc::milliseconds(500));
+      app2.startup();
+      fc::usleep(fc::milliseconds(500));
+      app3.startup();
+      fc::usleep(fc::milliseconds(500));
+
+      BOOST_REQUIRE_EQUAL(app2.p2p_node()->get_connection_count(), 2);
+
+      std::shared_ptr<chain::database> db1 = app1.chain_database();
+      std::shared_ptr<chain::database> db3 = app3.chain_database();
+      fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+      account_id_type nathan_id = db1->get_index_type<account_index>().indices().get<by_name>().find( "nathan" )->id;
+
+      auto bytes_sent = [&]() -> uint64_t {
+         uint64_t total = 0;
+         for( graphene::app::application* app : { &app1, &app2, &app3 } )
+            for( const graphene::net::peer_status& peer : app->p2p_node()->get_connected_peers() )
+               total += peer.info["bytessent"].as_uint64();
+         return total;
+      };
+
+      auto relay_block = [&]( const signed_transaction& trx, bool broadcast_trx ) {
+         db1->push_transaction( trx );
+         if( broadcast_trx )
+         {
+            app1.p2p_node()->broadcast( graphene::net::trx_message( trx ) );
+            fc::usleep(fc::milliseconds(500));
+         }
+
+         auto block = db1->generate_block( db1->get_slot_time(1), db1->get_scheduled_witness(1), nathan_key, database::skip_nothing );
+         const uint64_t bytes_before = bytes_sent();
+         const fc::time_point start = fc::time_point::now();
+         app1.p2p_node()->broadcast( graphene::net::block_message( block ) );
+         while( db3->head_block_num() < block.block_num() && fc::time_point::now() - start < fc::seconds(5) )
+            fc::usleep(fc::milliseconds(1));
+         const fc::microseconds latency = fc::time_point::now() - start;
+
+         BOOST_REQUIRE_EQUAL( db3->head_block_num(), block.block_num() );
+         BOOST_CHECK( db3->head_block_id() == block.id() );
+         fc::usleep(fc::milliseconds(100));
+         BOOST_TEST_MESSAGE( "block " << block.block_num() << " (" << fc::raw::pack_size( block ) << " bytes, transaction "
+                             << ( broadcast_trx ? "broadcast" : "not broadcast" ) << ") reached the third node in "
+                             << latency.count() << " us, nodes sent " << bytes_sent() - bytes_before << " bytes" );
+      };
+
+      signed_transaction claim_trx;
+      {
+         balance_claim_operation claim_op;
+         balance_id_type bid = balance_id_type();
+         claim_op.deposit_to_account = nathan_id;
+         claim_op.balance_to_claim = bid;
+         claim_op.balance_owner_key = nathan_key.get_public_key();
+         claim_op.total_claimed = bid(*db1).balance;
+         claim_trx.operations.push_back( claim_op );
+         db1->current_fee_schedule().set_fee( claim_trx.operations.back() );
+         claim_trx.set_expiration( db1->get_slot_time( 10 ) );
+         claim_trx.sign( nathan_key, db1->get_chain_id() );
+      }
+      relay_block( claim_trx, true );
+
+      signed_transaction transfer_trx;
+      {
+         transfer_operation xfer_op;
+         xfer_op.from = nathan_id;
+         xfer_op.to = GRAPHENE_NULL_ACCOUNT;
+         xfer_op.amount = asset( 1000000 );
+         transfer_trx.operations.push_back( xfer_op );
+         db1->current_fee_schedule().set_fee( transfer_trx.operations.back() );
+         transfer_trx.set_expiration( db1->get_slot_time( 10 ) );
+         transfer_trx.sign( nathan_key, db1->get_chain_id() );
+      }
+      relay_block( transfer_trx, false );
+
+      BOOST_CHECK_EQUAL( db3->get_balance( GRAPHENE_NULL_ACCOUNT, asset_id_type() ).amount.value, 1000000 );
+      BOOST_CHECK_EQUAL( app1.p2p_node()->get_connection_count(), 1 );
+      BOOST_CHECK_EQUAL( app2.p2p_node()->get_connection_count(), 2 );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+// Syncs two delayed nodes, one fetching packed blocks and one fetching JSON, from a trusted node through the
+// batched get_block_range path, with batches small enough that several are in flight and the last one is short.
+BOOST_AUTO_TEST_CASE( delayed_node_sync )
+{
+   using namespace graphene::chain;
+   using namespace graphene::app;
+   try {
+      fc::temp_directory trusted_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory packed_dir( graphene::utilities::temp_directory_path() );
+      fc::temp_directory json_dir( graphene::utilities::temp_directory_path() );
+
+      graphene::app::application trusted;
+      boost::program_options::variables_map trusted_cfg;
+      trusted_cfg.emplace("p2p-endpoint", boost::program_options::variable_value(string("127.0.0.1:6161"), false));
+      trusted_cfg.emplace("rpc-endpoint", boost::program_options::variable_value(string("127.0.0.1:6162"), false));
+      trusted.initialize(trusted_dir.path(), trusted_cfg);
+      trusted.startup();
+
+      auto start_delayed_node = []( graphene::app::application& app, const fc::path& dir, const string& p2p_endpoint,
+                                    boost::program_options::variables_map& cfg, bool packed ) {
+         app.register_plugin<graphene::delayed_node::delayed_node_plugin>();
+         cfg.emplace("p2p-endpoint", boost::program_options::variable_value(p2p_endpoint, false));
+         cfg.emplace("trusted-node", boost::program_options::variable_value(string("127.0.0.1:6162"), false));
+         cfg.emplace("delayed-node-batch-size", boost::program_options::variable_value(uint32_t(7), false));
+         cfg.emplace("delayed-node-batches-in-flight", boost::program_options::variable_value(uint32_t(3), false));
+         cfg.emplace("delayed-node-packed-blocks", boost::program_options::variable_value(packed, false));
+         app.initialize(dir, cfg);
+         app.initialize_plugins(cfg);
+         app.startup();
+         app.startup_plugins();
+      };
+      graphene::app::application packed_node;
+      boost::program_options::variables_map packed_cfg;
+      start_delayed_node( packed_node, packed_dir.path(), "127.0.0.1:6163", packed_cfg, true );
+      graphene::app::application json_node;
+      boost::program_options::variables_map json_cfg;
+      start_delayed_node( json_node, json_dir.path(), "127.0.0.1:6164", json_cfg, false );
+      fc::usleep(fc::milliseconds(500));
+
+      std::shared_ptr<chain::database> db = trusted.chain_database();
+      fc::ecc::private_key nathan_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+      for( uint32_t i = 0; i < 60; ++i )
+         db->generate_block( db->get_slot_time(1), db->get_scheduled_witness(1), nathan_key, database::skip_nothing );
+      const uint32_t irreversible = db->get_dynamic_global_properties().last_irreversible_block_num;
+      BOOST_REQUIRE_GT( irreversible, 7u * 3 );
+
+      // the delayed nodes follow the trusted node up to its last irreversible block
+      for( graphene::app::application* app : { &packed_node, &json_node } )
+      {
+         std::shared_ptr<chain::database> delayed_db = app->chain_database();
+         const fc::time_point start = fc::time_point::now();
+         while( delayed_db->head_block_num() < irreversible && fc::time_point::now() - start < fc::seconds(10) )
+            fc::usleep(fc::milliseconds(10));
+         BOOST_REQUIRE_EQUAL( delayed_db->head_block_num(), irreversible );
+         BOOST_CHECK( delayed_db->head_block_id() == db->get_block_id_for_num( irreversible ) );
+      }
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
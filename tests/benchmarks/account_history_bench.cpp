@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_CASE( account_history_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t op_count = 1000000;
+#else
+      const uint32_t op_count = 100000;
+#endif
+      const uint32_t rare_interval = 5000;
+
+      const account_object& nathan = create_account( "nathan" );
+      const account_id_type nathan_id = nathan.id;
+      const auto& stats = nathan.statistics( db );
+
+      // links the operations into the history the way the account history plugin does
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < op_count; ++i )
+      {
+         operation op;
+         if( i % rare_interval == rare_interval - 1 )
+            op = incentive_operation();
+         else
+            op = transfer_operation();
+         const auto& oho = db.create<operation_history_object>( [&]( operation_history_object& h ) {
+            h.op = op;
+            h.block_num = db.head_block_num();
+         });
+         const auto& ath = db.create<account_transaction_history_object>( [&]( account_transaction_history_object& obj ) {
+            obj.operation_id = oho.id;
+            obj.account = nathan_id;
+            obj.sequence = stats.total_ops + 1;
+            obj.next = stats.most_recent_op;
+            obj.operation_type = op.which();
+         });
+         db.modify( stats, [&]( account_statistics_object& obj ) {
+            obj.most_recent_op = ath.id;
+            obj.total_ops = ath.sequence;
+         });
+      }
+      ilog( "Linked ${n} operations in ${ms} ms", ("n",op_count)("ms",(fc::time_point::now() - start).count() / 1000) );
+
+      const int rare_type = operation::tag< incentive_operation >::value;
+      const uint32_t limit = 100;
+
+      // the walk down the linked list that filtered queries used before
+      start = fc::time_point::now();
+      vector<operation_history_id_type> walked;
+      const account_transaction_history_object* node = &stats.most_recent_op( db );
+      while( node && walked.size() < limit )
+      {
+         if( node->operation_id( db ).op.which() == rare_type )
+            walked.push_back( node->operation_id );
+         node = node->next == account_transaction_history_id_type() ? nullptr : &node->next( db );
+      }
+      const auto walk_elapsed = fc::time_point::now() - start;
+
+      graphene::app::history_api hist_api( app );
+      start = fc::time_point::now();
+      const auto indexed = hist_api.get_account_history_operations( nathan_id, rare_type, operation_history_id_type(),
+                                                                    operation_history_id_type(), limit );
+      const auto index_elapsed = fc::time_point::now() - start;
+
+      ilog( "Found ${r} of ${n} operations by type: linked list walk ${w} us, type index ${i} us",
+            ("r",indexed.size())("n",op_count)("w",walk_elapsed.count())("i",index_elapsed.count()) );
+
+      BOOST_REQUIRE_EQUAL( walked.size(), indexed.size() );
+      for( size_t i = 0; i < walked.size(); ++i )
+         BOOST_CHECK( walked[i] == indexed[i].id );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
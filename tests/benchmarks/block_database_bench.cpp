@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/block_database.hpp>
+#include <graphene/chain/mapped_block_database.hpp>
+#include <graphene/chain/protocol/protocol.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace graphene::chain;
+
+namespace {
+
+vector<signed_block> make_blocks( uint32_t count, uint32_t trx_per_block )
+{
+   vector<signed_block> blocks;
+   blocks.reserve( count );
+   signed_block b;
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      if( i > 0 ) b.previous = b.id();
+      b.timestamp = fc::time_point_sec( i * 3 );
+      b.witness = witness_id_type( i % 11 + 1 );
+      b.transactions.clear();
+      for( uint32_t t = 0; t < trx_per_block; ++t )
+      {
+         signed_transaction trx;
+         trx.ref_block_num = i;
+         trx.expiration = b.timestamp + 30;
+         transfer_operation op;
+         op.from = account_id_type( t + 11 );
+         op.to = account_id_type( i + 11 );
+         op.amount = asset( i * trx_per_block + t );
+         trx.operations.push_back( op );
+         b.transactions.push_back( processed_transaction( trx ) );
+      }
+      b.transaction_merkle_root = b.calculate_merkle_root();
+      blocks.push_back( b );
+   }
+   return blocks;
+}
+
+template<typename BlockDatabase>
+void bench_fetch( const char* name, const fc::path& dir, const vector<signed_block>& blocks, const vector<uint32_t>& random_order )
+{
+   BlockDatabase bdb;
+   bdb.open( dir );
+
+   auto start = fc::time_point::now();
+   for( const auto& b : blocks )
+      bdb.store( b.id(), b );
+   bdb.flush();
+   auto elapsed = fc::time_point::now() - start;
+   ilog( "${n}: stored ${c} blocks in ${t} ms", ("n",name)("c",blocks.size())("t",elapsed.count() / 1000) );
+
+   start = fc::time_point::now();
+   for( uint32_t i = 1; i <= blocks.size(); ++i )
+      BOOST_CHECK( bdb.fetch_by_number( i ).valid() );
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: sequential fetch_by_number ${r} blocks/s",
+         ("n",name)("r",uint64_t(blocks.size() * 1000000.0 / elapsed.count())) );
+
+   start = fc::time_point::now();
+   for( uint32_t i : random_order )
+      BOOST_CHECK( bdb.fetch_by_number( i ).valid() );
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: random fetch_by_number ${r} blocks/s",
+         ("n",name)("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count())) );
+
+   start = fc::time_point::now();
+   for( uint32_t i : random_order )
+      BOOST_CHECK( bdb.contains( blocks[i-1].id() ) );
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: random contains ${r} lookups/s",
+         ("n",name)("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count())) );
+
+   start = fc::time_point::now();
+   for( uint32_t i : random_order )
+      BOOST_CHECK( bdb.fetch_block_id( i ) == blocks[i-1].id() );
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: random fetch_block_id ${r} lookups/s",
+         ("n",name)("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count())) );
+
+   // serving a block to a peer, decoded and encoded again versus sent as stored
+   {
+      auto b = bdb.fetch_by_number( 1 );
+      auto packed = bdb.fetch_packed_by_number( 1 );
+      BOOST_REQUIRE( b.valid() && packed.valid() );
+      BOOST_CHECK( graphene::net::message( graphene::net::block_message( *b ) ).data
+                   == graphene::net::make_packed_block_message( std::move( *packed ), blocks[0].id() ).data );
+   }
+
+   start = fc::time_point::now();
+   uint64_t bytes = 0;
+   for( uint32_t i : random_order )
+   {
+      graphene::net::message m( graphene::net::block_message( *bdb.fetch_optional( blocks[i-1].id() ) ) );
+      bytes += m.size;
+   }
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: block_message from unpacked blocks ${r} blocks/s (${b} bytes)",
+         ("n",name)("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count()))("b",bytes) );
+
+   start = fc::time_point::now();
+   bytes = 0;
+   for( uint32_t i : random_order )
+   {
+      auto m = graphene::net::make_packed_block_message( std::move( *bdb.fetch_packed( blocks[i-1].id() ) ), blocks[i-1].id() );
+      bytes += m.size;
+   }
+   elapsed = fc::time_point::now() - start;
+   ilog( "${n}: block_message from packed blocks ${r} blocks/s (${b} bytes)",
+         ("n",name)("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count()))("b",bytes) );
+
+   bdb.close();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( block_database_fetch_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t block_count = 200000;
+#else
+      const uint32_t block_count = 5000;
+#endif
+      const uint32_t trx_per_block = 10;
+
+      auto blocks = make_blocks( block_count, trx_per_block );
+      vector<uint32_t> random_order( block_count );
+      for( uint32_t i = 0; i < block_count; ++i )
+         random_order[i] = i + 1;
+      std::shuffle( random_order.begin(), random_order.end(), std::mt19937( 42 ) );
+
+      fc::temp_directory fstream_dir( graphene::utilities::temp_directory_path() );
+      bench_fetch<block_database>( "block_database", fstream_dir.path(), blocks, random_order );
+
+      fc::temp_directory mapped_dir( graphene::utilities::temp_directory_path() );
+      bench_fetch<mapped_block_database>( "mapped_block_database", mapped_dir.path(), blocks, random_order );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
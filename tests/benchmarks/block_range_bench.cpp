@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/mapped_block_database.hpp>
+#include <graphene/chain/protocol/protocol.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+using namespace graphene::chain;
+
+/**
+ *  Reads a whole block database from front to back the way an indexer backfilling from the node does, one block
+ *  at a time as block_api::get_blocks does and a page at a time as database_api::get_block_range does.
+ */
+BOOST_AUTO_TEST_CASE( block_range_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t block_count = 1000000;
+#else
+      const uint32_t block_count = 20000;
+#endif
+      const uint32_t trx_per_block = 2;
+      const uint32_t page_size = 1000;
+      const uint32_t json_block_count = std::min<uint32_t>( block_count, 20000 );
+
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      mapped_block_database bdb;
+      bdb.open( dir.path() );
+
+      auto start = fc::time_point::now();
+      signed_block b;
+      for( uint32_t i = 0; i < block_count; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.timestamp = fc::time_point_sec( i * 3 );
+         b.witness = witness_id_type( i % 11 + 1 );
+         b.transactions.clear();
+         for( uint32_t t = 0; t < trx_per_block; ++t )
+         {
+            signed_transaction trx;
+            trx.ref_block_num = i;
+            trx.expiration = b.timestamp + 30;
+            transfer_operation op;
+            op.from = account_id_type( t + 11 );
+            op.to = account_id_type( i + 11 );
+            op.amount = asset( i * trx_per_block + t );
+            trx.operations.push_back( op );
+            b.transactions.push_back( processed_transaction( trx ) );
+         }
+         b.transaction_merkle_root = b.calculate_merkle_root();
+         bdb.store( b.id(), b );
+      }
+      bdb.flush();
+      auto elapsed = fc::time_point::now() - start;
+      ilog( "Stored ${c} blocks in ${t} ms", ("c",block_count)("t",elapsed.count() / 1000) );
+
+      // one block at a time
+      start = fc::time_point::now();
+      uint64_t bytes = 0;
+      for( uint32_t i = 1; i <= block_count; ++i )
+         bytes += bdb.fetch_packed_by_number( i )->size();
+      elapsed = fc::time_point::now() - start;
+      ilog( "fetch_packed_by_number: ${r} blocks/s (${b} bytes)",
+            ("r",uint64_t(block_count * 1000000.0 / elapsed.count()))("b",bytes) );
+
+      start = fc::time_point::now();
+      for( uint32_t i = 1; i <= block_count; ++i )
+         BOOST_CHECK( bdb.fetch_by_number( i ).valid() );
+      elapsed = fc::time_point::now() - start;
+      ilog( "fetch_by_number: ${r} blocks/s", ("r",uint64_t(block_count * 1000000.0 / elapsed.count())) );
+
+      // a page at a time
+      start = fc::time_point::now();
+      uint64_t range_bytes = 0;
+      uint32_t fetched = 0;
+      vector<char> data;
+      vector<uint32_t> sizes;
+      for( uint32_t next = 1; next <= block_count; )
+      {
+         data.clear();
+         sizes.clear();
+         const uint32_t count = bdb.fetch_packed_range( next, page_size, 16 * 1024 * 1024, data, sizes );
+         BOOST_REQUIRE( count > 0 );
+         range_bytes += data.size();
+         fetched += count;
+         next += count;
+      }
+      elapsed = fc::time_point::now() - start;
+      BOOST_CHECK_EQUAL( fetched, block_count );
+      BOOST_CHECK_EQUAL( range_bytes, bytes );
+      ilog( "fetch_packed_range in pages of ${p}: ${r} blocks/s",
+            ("p",page_size)("r",uint64_t(block_count * 1000000.0 / elapsed.count())) );
+
+      // the JSON an API client receives, for the first blocks only
+      start = fc::time_point::now();
+      uint64_t json_bytes = 0;
+      for( uint32_t i = 1; i <= json_block_count; ++i )
+         json_bytes += fc::json::to_string( fc::variant( bdb.fetch_by_number( i ) ) ).size();
+      elapsed = fc::time_point::now() - start;
+      ilog( "fetch_by_number as JSON: ${r} blocks/s (${b} bytes)",
+            ("r",uint64_t(json_block_count * 1000000.0 / elapsed.count()))("b",json_bytes) );
+
+      start = fc::time_point::now();
+      json_bytes = 0;
+      for( uint32_t next = 1; next <= json_block_count; )
+      {
+         data.clear();
+         sizes.clear();
+         const uint32_t count = bdb.fetch_packed_range( next, std::min( page_size, json_block_count - next + 1 ),
+                                                        16 * 1024 * 1024, data, sizes );
+         json_bytes += fc::json::to_string( fc::variant( data ) ).size();
+         next += count;
+      }
+      elapsed = fc::time_point::now() - start;
+      ilog( "fetch_packed_range as JSON: ${r} blocks/s (${b} bytes)",
+            ("r",uint64_t(json_block_count * 1000000.0 / elapsed.count()))("b",json_bytes) );
+
+      // a page covers whole blocks, stopping before the byte limit
+      data.clear();
+      sizes.clear();
+      const uint64_t max_bytes = bytes / block_count * 10;
+      const uint32_t limited = bdb.fetch_packed_range( 1, page_size, max_bytes, data, sizes );
+      BOOST_CHECK( limited >= 1 && limited < page_size );
+      BOOST_CHECK_LE( data.size(), max_bytes );
+      BOOST_CHECK( fc::raw::unpack<signed_block>( vector<char>( data.begin(), data.begin() + sizes[0] ) ).block_num() == 1 );
+
+      bdb.close();
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/deflation_object.hpp>
+#include <graphene/chain/hardfork.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_CASE( deflation_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t account_count = 1000000;
+#else
+      const uint32_t account_count = 100000;
+#endif
+
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const account_object& acct = db.create<account_object>( [&]( account_object& a ) {
+            a.name = "deflate" + fc::to_string( uint64_t(i) );
+            a.registrar = a.referrer = a.lifetime_referrer = GRAPHENE_TEMP_ACCOUNT;
+            a.network_fee_percentage = GRAPHENE_DEFAULT_NETWORK_PERCENT_OF_FEE;
+            a.owner.weight_threshold = 1;
+            a.active.weight_threshold = 1;
+            a.statistics = db.create<account_statistics_object>( [&]( account_statistics_object& s ) {
+               s.owner = a.id;
+            }).id;
+         });
+         db.create<account_balance_object>( [&]( account_balance_object& b ) {
+            b.owner = acct.id;
+            b.asset_type = asset_id_type();
+            b.balance = 1000000 + i;
+         });
+      }
+      ilog( "Created ${n} accounts in ${ms} ms", ("n",account_count)("ms",(fc::time_point::now() - start).count() / 1000) );
+
+      // starts a deflation round the way deflation_evaluator does and produces blocks until it is done
+      auto run_round = [&]( const string& mode ) {
+         const auto& acc_idx = db.get_index_type<account_index>().indices().get<by_id>();
+         const deflation_object& dflt = db.create<deflation_object>( [&]( deflation_object& obj ) {
+            obj.timestamp = db.head_block_time();
+            obj.issuer = GRAPHENE_DEFLATION_ISSUE_ACCOUNT;
+            obj.rate = GRAPHENE_DEFLATION_RATE_SCALE / 100;
+            obj.last_account = acc_idx.rbegin()->id;
+            obj.account_cursor = GRAPHENE_DEFLATION_ACCOUNT_START_MARKER;
+            obj.balance_cleared = false;
+            obj.last_order = limit_order_id_type(0);
+            obj.order_cursor = limit_order_id_type(0);
+            obj.order_cleared = true;
+            obj.total_amount = 0;
+         });
+         const deflation_id_type dflt_id = dflt.id;
+
+         uint32_t blocks = 0;
+         uint64_t bytes = 0;
+         uint64_t ops = 0;
+         start = fc::time_point::now();
+         while( !dflt_id(db).balance_cleared )
+         {
+            signed_block b = generate_block();
+            ++blocks;
+            bytes += fc::raw::pack_size( b );
+            for( const auto& tx : b.transactions )
+               ops += tx.operations.size();
+         }
+         const auto elapsed = fc::time_point::now() - start;
+         ilog( "${mode} deflation of ${n} accounts: ${b} blocks, ${ops} operations, ${bytes} bytes, ${ms} ms, total deflated ${t}",
+               ("mode",mode)("n",account_count)("b",blocks)("ops",ops)("bytes",bytes)
+               ("ms",elapsed.count() / 1000)("t",dflt_id(db).total_amount) );
+         return dflt_id(db).total_amount;
+      };
+
+      generate_block();
+      const share_type per_account_total = run_round( "Per account" );
+
+      generate_blocks( HARDFORK_BULK_DEFLATION_TIME );
+      generate_block();
+      const share_type bulk_total = run_round( "Bulk" );
+
+      // the second round deflates balances already reduced by the first one
+      BOOST_CHECK_GT( per_account_total.value, 0 );
+      BOOST_CHECK_GT( bulk_total.value, 0 );
+      BOOST_CHECK_LT( bulk_total.value, per_account_total.value );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <random>
+
+using namespace graphene::chain;
+
+/**
+ *  Compares find() by id on a generic_index, which walks the by_id tree, with a dense_generic_index holding the
+ *  same account balances.
+ */
+BOOST_AUTO_TEST_CASE( dense_index_lookup_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t object_count = 1000000;
+      const uint32_t lookup_count = 10000000;
+#else
+      const uint32_t object_count = 100000;
+      const uint32_t lookup_count = 1000000;
+#endif
+      typedef generic_index<account_balance_object, account_balance_object_multi_index_type> tree_balance_index;
+      typedef dense_generic_index<account_balance_object, account_balance_object_multi_index_type> dense_balance_index;
+
+      graphene::db::object_database odb;
+      odb._undo_db.disable();
+      primary_index< tree_balance_index > tree_index( odb );
+      primary_index< dense_balance_index > dense_index( odb );
+      for( uint32_t i = 0; i < object_count; ++i )
+      {
+         auto init = [i]( object& o ) {
+            auto& balance = static_cast<account_balance_object&>( o );
+            balance.owner = account_id_type( i );
+            balance.balance = i;
+         };
+         tree_index.create( init );
+         dense_index.create( init );
+      }
+
+      // every tenth balance goes away, leaving tombstones in the dense index
+      for( uint32_t i = 0; i < object_count; i += 10 )
+      {
+         const object_id_type id( account_balance_object::space_id, account_balance_object::type_id, i );
+         tree_index.remove( *tree_index.find( id ) );
+         dense_index.remove( *dense_index.find( id ) );
+      }
+
+      std::vector<object_id_type> ids;
+      ids.reserve( lookup_count );
+      std::mt19937 gen( 42 );
+      std::uniform_int_distribution<uint32_t> dist( 0, object_count - 1 );
+      for( uint32_t i = 0; i < lookup_count; ++i )
+         ids.emplace_back( account_balance_object::space_id, account_balance_object::type_id, dist( gen ) );
+
+      auto lookup_all = [&]( const graphene::db::index& idx, const char* name ) {
+         int64_t total = 0;
+         auto start = fc::time_point::now();
+         for( const auto& id : ids )
+         {
+            const object* o = idx.find( id );
+            if( o != nullptr )
+               total += static_cast<const account_balance_object*>( o )->balance.value;
+         }
+         auto elapsed = fc::time_point::now() - start;
+         ilog( "${n} lookups among ${o} objects in a ${name} index took ${ms} ms, ${ns} ns per lookup",
+               ("n",lookup_count)("o",object_count)("name",name)("ms",elapsed.count() / 1000)
+               ("ns",elapsed.count() * 1000 / lookup_count) );
+         return total;
+      };
+
+      const int64_t tree_total = lookup_all( tree_index, "tree" );
+      const int64_t dense_total = lookup_all( dense_index, "dense" );
+      BOOST_CHECK_EQUAL( tree_total, dense_total );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+/**
+ *  Times applying blocks full of transfers between many accounts, which look up accounts, their statistics and
+ *  their balances by id throughout.  Run it on either side of a change to the index types to compare.
+ */
+BOOST_FIXTURE_TEST_CASE( dense_index_block_apply_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t account_count = 2000;
+      const uint32_t block_count = 50;
+#else
+      const uint32_t account_count = 200;
+      const uint32_t block_count = 5;
+#endif
+      const uint32_t transfers_per_block = account_count;
+
+      vector<account_id_type> accounts;
+      accounts.reserve( account_count );
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const account_object& a = create_account( "bench" + fc::to_string( uint64_t(i) ) );
+         transfer( committee_account, a.id, asset( 1000000 ) );
+         accounts.push_back( a.id );
+      }
+      generate_block();
+
+      const uint32_t skip = ~0;
+      fc::microseconds elapsed;
+      for( uint32_t b = 0; b < block_count; ++b )
+      {
+         for( uint32_t i = 0; i < transfers_per_block; ++i )
+         {
+            signed_transaction tx;
+            transfer_operation op;
+            op.from = accounts[i];
+            op.to = accounts[( i * 7 + b + 1 ) % account_count];
+            op.amount = asset( 1 + b );
+            tx.operations.push_back( op );
+            db.current_fee_schedule().set_fee( tx.operations.back() );
+            set_expiration( db, tx );
+            PUSH_TX( db, tx, skip );
+         }
+         auto start = fc::time_point::now();
+         generate_block( skip );
+         elapsed += fc::time_point::now() - start;
+      }
+      ilog( "Applied ${b} blocks of ${t} transfers among ${a} accounts in ${ms} ms, ${us} us per transfer",
+            ("b",block_count)("t",transfers_per_block)("a",account_count)("ms",elapsed.count() / 1000)
+            ("us",elapsed.count() / ( block_count * transfers_per_block )) );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
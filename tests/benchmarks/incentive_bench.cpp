@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/construction_capital_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_CASE( incentive_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t cc_count = 1000000;
+#else
+      const uint32_t cc_count = 100000;
+#endif
+      const uint32_t due_count = 2000;
+      const uint32_t pending_count = 500;
+      const uint32_t block_count = 20;
+      const uint32_t period = 60 * 60 * 24;
+
+      generate_block();
+      const fc::time_point_sec now = db.head_block_time();
+
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < cc_count; ++i )
+      {
+         db.create<construction_capital_object>( [&]( construction_capital_object& obj ) {
+            obj.owner = account_id_type();
+            obj.amount = 1000000 + i;
+            obj.period = period;
+            obj.total_periods = 12;
+            obj.achieved = 0;
+            obj.pending = i < pending_count ? 1 : 0;
+            obj.left_vote_point = 0;
+            obj.timestamp = now;
+            // a backlog of due capital, the rest spread over the coming period
+            obj.next_slot = i < due_count ? now : now + 1 + ( i % period );
+         });
+      }
+      db.modify( db.get( construction_capital_summary_id_type() ), [&]( construction_capital_summary_object& o ) {
+         o.count_all_time += cc_count;
+         o.count_in_life += cc_count;
+         o.deposit_all_time += uint64_t(cc_count) * 2000000;
+         o.deposit_in_life += uint64_t(cc_count) * 2000000;
+      });
+      ilog( "Created ${n} construction capital objects in ${ms} ms",
+            ("n",cc_count)("ms",(fc::time_point::now() - start).count() / 1000) );
+
+      fc::microseconds total;
+      fc::microseconds slowest;
+      uint64_t incentive_ops = 0;
+      for( uint32_t i = 0; i < block_count; ++i )
+      {
+         start = fc::time_point::now();
+         signed_block b = generate_block();
+         auto elapsed = fc::time_point::now() - start;
+         total += elapsed;
+         slowest = std::max( slowest, elapsed );
+         for( const auto& tx : b.transactions )
+            for( const auto& op : tx.operations )
+               if( op.which() == operation::tag<incentive_operation>::value )
+                  ++incentive_ops;
+      }
+      ilog( "Produced ${b} blocks with ${n} construction capital objects: ${ops} incentive operations, ${avg} ms per block, slowest ${max} ms",
+            ("b",block_count)("n",cc_count)("ops",incentive_ops)
+            ("avg",total.count() / block_count / 1000)("max",slowest.count() / 1000) );
+      BOOST_CHECK_GT( incentive_ops, 0u );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
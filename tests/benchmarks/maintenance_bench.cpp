@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_CASE( maintenance_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t account_count = 1000000;
+#else
+      const uint32_t account_count = 100000;
+#endif
+
+      vector<vote_id_type> witness_votes;
+      for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+         witness_votes.push_back( wit.vote_id );
+
+      // every tenth account pays fees whose cashback goes to the next account, which is tallied after it
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const account_object& acct = db.create<account_object>( [&]( account_object& a ) {
+            a.name = "voter" + fc::to_string( uint64_t( 10000000 + i ) );
+            a.registrar = a.referrer = a.lifetime_referrer = ( i % 10 == 0 ) ? account_id_type( a.id.instance() + 1 )
+                                                                             : GRAPHENE_TEMP_ACCOUNT;
+            a.network_fee_percentage = GRAPHENE_DEFAULT_NETWORK_PERCENT_OF_FEE;
+            a.lifetime_referrer_fee_percentage = GRAPHENE_DEFAULT_LIFETIME_REFERRER_PERCENT_OF_FEE;
+            a.owner.weight_threshold = 1;
+            a.active.weight_threshold = 1;
+            a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+            a.options.num_witness = i % 5;
+            for( uint32_t v = 0; v < 1 + i % 3; ++v )
+               a.options.votes.insert( witness_votes[ ( i + v ) % witness_votes.size() ] );
+            a.statistics = db.create<account_statistics_object>( [&]( account_statistics_object& s ) {
+               s.owner = a.id;
+               if( i % 10 == 0 )
+                  s.pending_fees = 100000;
+            }).id;
+         });
+         db.create<account_balance_object>( [&]( account_balance_object& b ) {
+            b.owner = acct.id;
+            b.asset_type = asset_id_type();
+            b.balance = 1000000 + i;
+         });
+      }
+      ilog( "Created ${n} accounts in ${ms} ms", ("n",account_count)("ms",(fc::time_point::now() - start).count() / 1000) );
+
+      generate_block();
+      const auto interval = db.get_global_properties().parameters.block_interval;
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time - interval );
+
+      // apply the maintenance block with each number of threads, starting from the same state every time
+      auto tally = [&]() {
+         vector<uint64_t> votes;
+         for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+            votes.push_back( wit.total_votes );
+         return votes;
+      };
+      vector<uint64_t> serial_votes;
+      const vector<uint32_t> thread_counts = { 0, 1, 2, 4, 8 };
+      for( uint32_t threads : thread_counts )
+      {
+         db.set_maintenance_threads( threads );
+         const auto maintenance_time = db.get_dynamic_global_properties().next_maintenance_time;
+         start = fc::time_point::now();
+         generate_block();
+         const auto elapsed = fc::time_point::now() - start;
+         BOOST_REQUIRE( db.get_dynamic_global_properties().next_maintenance_time > maintenance_time );
+         ilog( "Applied maintenance block over ${n} accounts with ${t} maintenance thread(s) in ${ms} ms",
+               ("n",account_count)("t",threads)("ms",elapsed.count() / 1000) );
+
+         if( threads == 0 )
+            serial_votes = tally();
+         else
+            BOOST_CHECK( tally() == serial_votes );
+         db.pop_block();
+      }
+      db.set_maintenance_threads( 0 );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
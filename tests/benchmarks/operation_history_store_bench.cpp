@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/account_history/operation_history_store.hpp>
+#include <graphene/chain/protocol/protocol.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace graphene::chain;
+using graphene::account_history::operation_history_store;
+
+BOOST_AUTO_TEST_CASE( operation_history_store_bench )
+{
+   try {
+#ifdef NDEBUG
+      const uint64_t op_count = 2000000;
+#else
+      const uint64_t op_count = 50000;
+#endif
+      // every tenth id is skipped, like with partial-operations
+      const auto skipped = []( uint64_t i ) { return i % 10 == 9; };
+
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      {
+         operation_history_store store;
+         store.open( dir.path() );
+         auto start = fc::time_point::now();
+         operation_history_object op;
+         for( uint64_t i = 0; i < op_count; ++i )
+         {
+            if( skipped( i ) )
+               continue;
+            op.id = operation_history_id_type( i );
+            op.block_num = i / 100 + 1;
+            transfer_operation t;
+            t.from = account_id_type( i % 1000 );
+            t.to = account_id_type( i % 777 );
+            t.amount = asset( i );
+            op.op = t;
+            store.append( op );
+         }
+         store.flush();
+         auto elapsed = fc::time_point::now() - start;
+         ilog( "Appended ${c} operations in ${t} ms", ("c",op_count)("t",elapsed.count() / 1000) );
+      }
+
+      operation_history_store store;
+      auto start = fc::time_point::now();
+      store.open( dir.path() );
+      auto elapsed = fc::time_point::now() - start;
+      ilog( "Reopened the store in ${t} ms", ("t",elapsed.count() / 1000) );
+      BOOST_CHECK_EQUAL( store.next_instance(), op_count - ( skipped( op_count - 1 ) ? 1 : 0 ) );
+
+      vector<uint64_t> random_order( op_count );
+      for( uint64_t i = 0; i < op_count; ++i )
+         random_order[i] = i;
+      std::shuffle( random_order.begin(), random_order.end(), std::mt19937( 42 ) );
+      random_order.resize( std::min<uint64_t>( op_count, 200000 ) );
+
+      start = fc::time_point::now();
+      for( uint64_t i : random_order )
+      {
+         const operation_history_object* op = store.find( i );
+         if( skipped( i ) )
+            BOOST_CHECK( op == nullptr );
+         else
+         {
+            BOOST_REQUIRE( op != nullptr );
+            BOOST_CHECK( op->op.get<transfer_operation>().amount == asset( i ) );
+         }
+      }
+      elapsed = fc::time_point::now() - start;
+      ilog( "Random find ${r} ops/s", ("r",uint64_t(random_order.size() * 1000000.0 / elapsed.count())) );
+
+      // the most recent operations are what the API asks for most of the time
+      start = fc::time_point::now();
+      for( uint32_t round = 0; round < 10; ++round )
+         for( uint64_t i = op_count - 1000; i < op_count; ++i )
+            store.find( i );
+      elapsed = fc::time_point::now() - start;
+      ilog( "Cached find ${r} ops/s", ("r",uint64_t(10000 * 1000000.0 / elapsed.count())) );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_CASE( signature_recovery_bench, database_fixture )
+{
+   try {
+      ACTOR( alice );
+      fund( alice, asset( 100000000 ) );
+      generate_block();
+
+#ifdef NDEBUG
+      const vector<uint32_t> block_sizes = { 1000, 5000, 10000 };
+#else
+      const vector<uint32_t> block_sizes = { 1000 };
+#endif
+      const vector<uint32_t> thread_counts = { 0, 1, 2, 4, 8 };
+
+      for( uint32_t block_size : block_sizes )
+      {
+         for( uint32_t i = 0; i < block_size; ++i )
+         {
+            signed_transaction tx;
+            transfer_operation op;
+            op.from = alice_id;
+            op.to = account_id_type();
+            op.amount = asset( i + 1 );
+            tx.operations.push_back( op );
+            set_expiration( db, tx );
+            tx.sign( alice_private_key, db.get_chain_id() );
+            db.push_transaction( tx, ~0 );
+         }
+         // produce the block once to get a valid signed block, then rewind so it can be pushed again
+         signed_block b = generate_block();
+         BOOST_REQUIRE_EQUAL( b.transactions.size(), block_size );
+         db.pop_block();
+         db.clear_pending();
+         db._popped_tx.clear();
+
+         for( uint32_t threads : thread_counts )
+         {
+            db.set_signature_recovery_threads( threads );
+            auto start = fc::time_point::now();
+            db.push_block( b, database::skip_undo_history_check | database::skip_fork_db );
+            auto elapsed = fc::time_point::now() - start;
+            ilog( "Pushed block of ${n} signed transfers with ${t} signature recovery thread(s) in ${ms} ms, ${r} trx/s",
+                  ("n",block_size)("t",threads)("ms",elapsed.count() / 1000)
+                  ("r",uint64_t(block_size * 1000000.0 / elapsed.count())) );
+            BOOST_CHECK( db.head_block_id() == b.id() );
+            db.pop_block();
+            db.clear_pending();
+            db._popped_tx.clear();
+         }
+         db.set_signature_recovery_threads( 0 );
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
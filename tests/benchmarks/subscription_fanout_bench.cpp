@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/subscription_registry.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::app;
+
+namespace {
+
+struct counting_session : public subscription_session
+{
+   virtual void send_object_updates( const vector<variant>& updates ) override
+   {
+      ++notifications;
+      update_count += updates.size();
+   }
+
+   uint64_t notifications = 0;
+   uint64_t update_count = 0;
+};
+
+}
+
+/**
+ *  Many API sessions follow the same handful of popular accounts while blocks of transfers between them are applied,
+ *  and are served once by one shared registry and once by a registry per session, which converts every object for
+ *  each session the way each database_api used to.
+ */
+BOOST_FIXTURE_TEST_CASE( subscription_fanout_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t session_count = 1000;
+#else
+      const uint32_t session_count = 100;
+#endif
+      const uint32_t popular_count = 10;
+      const uint32_t block_count = 20;
+      const uint32_t trx_per_block = 50;
+
+      vector<account_id_type> popular;
+      for( uint32_t i = 0; i < popular_count; ++i )
+      {
+         const account_object& a = create_account( "popular" + fc::to_string( uint64_t(i) ) );
+         transfer( account_id_type(), a.id, asset( 1000000 ) );
+         popular.push_back( a.id );
+      }
+      generate_block();
+
+      auto apply_blocks = [&]() -> fc::microseconds {
+         fc::microseconds elapsed;
+         for( uint32_t b = 0; b < block_count; ++b )
+         {
+            for( uint32_t t = 0; t < trx_per_block; ++t )
+            {
+               set_expiration( db, trx );
+               transfer_operation op;
+               op.from = popular[ t % popular_count ];
+               op.to = popular[ (t + 1) % popular_count ];
+               op.amount = asset( b * trx_per_block + t + 1 );
+               trx.operations.push_back( op );
+               for( auto& o : trx.operations ) db.current_fee_schedule().set_fee( o );
+               PUSH_TX( db, trx, ~0 );
+               trx.clear();
+            }
+            auto start = fc::time_point::now();
+            generate_block();
+            elapsed += fc::time_point::now() - start;
+         }
+         return elapsed;
+      };
+
+      auto subscribe = [&]( subscription_registry& registry, counting_session& session ) {
+         registry.add_session( &session, false );
+         for( const auto& id : popular )
+         {
+            registry.subscribe_to_account( &session, id );
+            registry.subscribe_to_object( &session, id );
+         }
+      };
+
+      auto baseline = apply_blocks();
+      ilog( "Applied ${b} blocks without sessions in ${t} ms", ("b",block_count)("t",baseline.count() / 1000) );
+
+      uint64_t shared_updates = 0;
+      {
+         vector<counting_session> sessions( session_count );
+         subscription_registry registry( db );
+         for( auto& s : sessions )
+            subscribe( registry, s );
+         auto elapsed = apply_blocks();
+         for( const auto& s : sessions )
+            shared_updates += s.update_count;
+         ilog( "Applied ${b} blocks with ${n} sessions sharing one registry in ${t} ms, ${u} updates delivered",
+               ("b",block_count)("n",session_count)("t",elapsed.count() / 1000)("u",shared_updates) );
+      }
+
+      uint64_t private_updates = 0;
+      {
+         vector<counting_session> sessions( session_count );
+         vector< std::unique_ptr<subscription_registry> > registries;
+         for( auto& s : sessions )
+         {
+            registries.emplace_back( new subscription_registry( db ) );
+            subscribe( *registries.back(), s );
+         }
+         auto elapsed = apply_blocks();
+         for( const auto& s : sessions )
+            private_updates += s.update_count;
+         ilog( "Applied ${b} blocks with ${n} sessions each on its own registry in ${t} ms, ${u} updates delivered",
+               ("b",block_count)("n",session_count)("t",elapsed.count() / 1000)("u",private_updates) );
+      }
+
+      BOOST_CHECK( shared_updates > 0 );
+      BOOST_CHECK_EQUAL( shared_updates, private_updates );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
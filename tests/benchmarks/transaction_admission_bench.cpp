@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+/**
+ *  Load generator for database::admit_transaction(): a burst of signed transfers is admitted by concurrent tasks of
+ *  the chain thread, like transactions arriving from many peers, and the sustained rate is reported.
+ */
+BOOST_FIXTURE_TEST_CASE( transaction_admission_bench, database_fixture )
+{
+   try {
+      ACTOR( alice );
+      fund( alice, asset( 100000000 ) );
+      generate_block();
+
+#ifdef NDEBUG
+      const uint32_t trx_count = 20000;
+#else
+      const uint32_t trx_count = 1000;
+#endif
+      const vector<uint32_t> thread_counts = { 0, 1, 2, 4, 8 };
+
+      vector<signed_transaction> trxs;
+      trxs.reserve( trx_count );
+      for( uint32_t i = 0; i < trx_count; ++i )
+      {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = account_id_type();
+         op.amount = asset( i + 1 );
+         tx.operations.push_back( op );
+         set_expiration( db, tx );
+         tx.sign( alice_private_key, db.get_chain_id() );
+         trxs.push_back( tx );
+      }
+
+      auto admit_all = [&]( uint32_t threads, uint32_t queue_depth )
+      {
+         db.set_transaction_admission( threads, queue_depth );
+         const auto before = db.get_transaction_admission_stats();
+         uint32_t admitted = 0;
+         vector< fc::future<void> > tasks;
+         tasks.reserve( trx_count );
+         auto start = fc::time_point::now();
+         for( const auto& tx : trxs )
+            tasks.push_back( fc::async( [&]()
+            {
+               try
+               {
+                  db.admit_transaction( tx );
+                  ++admitted;
+               }
+               catch( const fc::exception& )
+               {
+               }
+            }, "admit transaction" ) );
+         for( auto& t : tasks )
+            t.wait();
+         auto elapsed = fc::time_point::now() - start;
+         const auto after = db.get_transaction_admission_stats();
+         ilog( "Admitted ${a} of ${n} signed transfers with ${t} admission thread(s) and queue depth ${d} in ${ms} ms, "
+               "${r} trx/s, ${f} rejected as the queue was full",
+               ("a",admitted)("n",trx_count)("t",threads)("d",queue_depth)("ms",elapsed.count() / 1000)
+               ("r",uint64_t(admitted * 1000000.0 / elapsed.count()))
+               ("f",after.rejected_queue_full - before.rejected_queue_full) );
+         BOOST_CHECK_EQUAL( after.queue_depth, 0u );
+         BOOST_CHECK_EQUAL( after.rejected_invalid, before.rejected_invalid );
+         db.clear_pending();
+         return admitted;
+      };
+
+      for( uint32_t threads : thread_counts )
+         BOOST_CHECK_EQUAL( admit_all( threads, trx_count ), trx_count );
+
+      // a queue shorter than the burst rejects the excess instead of stalling the chain thread
+      BOOST_CHECK_LT( admit_all( 4, trx_count / 10 ), trx_count );
+
+      db.set_transaction_admission( 0, 1 );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
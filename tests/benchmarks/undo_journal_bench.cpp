@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace graphene::chain;
+
+static std::atomic<uint64_t> allocation_count( 0 );
+
+void* operator new( size_t size )
+{
+   allocation_count.fetch_add( 1, std::memory_order_relaxed );
+   void* p = std::malloc( size ? size : 1 );
+   if( p == nullptr )
+      throw std::bad_alloc();
+   return p;
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+/**
+ *  Modifies the balance and account object of many accounts in one undo session, the way a large block of payouts
+ *  does, then undoes the session, and reports the time and heap allocations taken by each.
+ */
+BOOST_FIXTURE_TEST_CASE( undo_journal_bench, database_fixture )
+{
+   try {
+#ifdef NDEBUG
+      const uint32_t account_count = 20000;
+#else
+      const uint32_t account_count = 2000;
+#endif
+      const uint32_t rounds = 5;
+
+      vector<account_id_type> accounts;
+      accounts.reserve( account_count );
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const account_object& a = create_account( "undo" + fc::to_string( uint64_t(i) ) );
+         db.adjust_balance( a.id, asset( 1000 ) );
+         accounts.push_back( a.id );
+      }
+      generate_block();
+      db.clear_pending();
+
+      for( uint32_t r = 0; r < rounds; ++r )
+      {
+         auto session = db._undo_db.start_undo_session();
+
+         uint64_t allocations = allocation_count.load();
+         auto start = fc::time_point::now();
+         for( const auto& id : accounts )
+         {
+            db.adjust_balance( id, asset( 1 ) );
+            db.adjust_balance( id, asset( 1 ) );
+            db.modify( id( db ), []( account_object& a ) { ++a.lifetime_referrer_fee_percentage; } );
+         }
+         const auto push_elapsed = fc::time_point::now() - start;
+         const uint64_t push_allocations = allocation_count.load() - allocations;
+
+         allocations = allocation_count.load();
+         start = fc::time_point::now();
+         session.undo();
+         const auto pop_elapsed = fc::time_point::now() - start;
+         const uint64_t pop_allocations = allocation_count.load() - allocations;
+
+         ilog( "Round ${r}: modified ${n} objects in ${pm} ms with ${pa} allocations, undid them in ${um} ms with ${ua} allocations",
+               ("r",r)("n",account_count * 2)("pm",push_elapsed.count() / 1000)("pa",push_allocations)
+               ("um",pop_elapsed.count() / 1000)("ua",pop_allocations) );
+      }
+
+      for( const auto& id : accounts )
+         BOOST_CHECK_EQUAL( db.get_balance( id, asset_id_type() ).amount.value, 1000 );
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -58,6 +58,11 @@ using std::cout;
 using std::cerr;
 
 database_fixture::database_fixture()
+   : database_fixture( boost::program_options::variables_map() )
+{
+}
+
+database_fixture::database_fixture( const boost::program_options::variables_map& plugin_options )
    : app(), db( *app.chain_database() )
 {
    try {
@@ -75,8 +80,6 @@ database_fixture::database_fixture()
    auto mhplugin = app.register_plugin<graphene::market_history::market_history_plugin>();
    init_account_pub_key = init_account_priv_key.get_public_key();
 
-   boost::program_options::variables_map options;
-
    genesis_state.initial_timestamp = time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
 
    genesis_state.initial_active_witnesses = 10;
@@ -95,9 +98,9 @@ database_fixture::database_fixture()
 
    // app.initialize();
    ahplugin->plugin_set_app(&app);
-   ahplugin->plugin_initialize(options);
+   ahplugin->plugin_initialize(plugin_options);
    mhplugin->plugin_set_app(&app);
-   mhplugin->plugin_initialize(options);
+   mhplugin->plugin_initialize(plugin_options);
 
    ahplugin->plugin_startup();
    mhplugin->plugin_startup();
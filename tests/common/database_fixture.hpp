@@ -162,6 +162,8 @@ struct database_fixture {
    uint32_t anon_acct_count;
 
    database_fixture();
+   /// @param plugin_options passed to the plugins, for fixtures of tests that need a plugin configured differently
+   explicit database_fixture( const boost::program_options::variables_map& plugin_options );
    ~database_fixture();
 
    static fc::ecc::private_key generate_private_key(string seed);
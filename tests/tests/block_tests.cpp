@@ -32,10 +32,13 @@
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/witness_object.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
+#include <graphene/transaction_record/transaction_record_store.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/thread/thread.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -125,6 +128,155 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( mapped_block_database_test )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      signed_block b;
+      vector<block_id_type> ids;
+      {
+         mapped_block_database bdb;
+         bdb.open( data_dir.path() );
+         FC_ASSERT( bdb.is_open() );
+         FC_ASSERT( !bdb.last().valid() );
+         FC_ASSERT( !bdb.last_id().valid() );
+         FC_ASSERT( !bdb.fetch_by_number( 1 ).valid() );
+
+         for( uint32_t i = 0; i < 5; ++i )
+         {
+            if( i > 0 ) b.previous = b.id();
+            b.witness = witness_id_type(i+1);
+            bdb.store( b.id(), b );
+            ids.push_back( b.id() );
+
+            auto fetch = bdb.fetch_by_number( b.block_num() );
+            FC_ASSERT( fetch.valid() );
+            FC_ASSERT( fetch->witness == b.witness );
+            fetch = bdb.fetch_optional( b.id() );
+            FC_ASSERT( fetch.valid() );
+            FC_ASSERT( fetch->witness == b.witness );
+            FC_ASSERT( bdb.contains( b.id() ) );
+            FC_ASSERT( bdb.fetch_block_id( b.block_num() ) == b.id() );
+         }
+
+         bdb.remove( ids.back() );
+         FC_ASSERT( !bdb.contains( ids.back() ) );
+         FC_ASSERT( !bdb.fetch_by_number( 5 ).valid() );
+         FC_ASSERT( *bdb.last_id() == ids[3] );
+         bdb.store( ids.back(), b );
+         FC_ASSERT( *bdb.last_id() == ids.back() );
+         bdb.close();
+         FC_ASSERT( !bdb.is_open() );
+      }
+
+      // the on-disk format is shared with the fstream implementation
+      {
+         block_database bdb;
+         bdb.open( data_dir.path() );
+         for( uint32_t i = 0; i < 5; ++i )
+         {
+            auto blk = bdb.fetch_by_number( i+1 );
+            FC_ASSERT( blk.valid() );
+            FC_ASSERT( blk->id() == ids[i] );
+         }
+         FC_ASSERT( bdb.last()->id() == b.id() );
+         b.previous = b.id();
+         b.witness = witness_id_type(6);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+         bdb.close();
+      }
+      {
+         mapped_block_database bdb;
+         bdb.open( data_dir.path() );
+         for( uint32_t i = 0; i < 6; ++i )
+         {
+            auto blk = bdb.fetch_by_number( i+1 );
+            FC_ASSERT( blk.valid() );
+            FC_ASSERT( blk->witness == witness_id_type(blk->block_num()) );
+         }
+         FC_ASSERT( bdb.last()->id() == ids.back() );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( transaction_record_store_test )
+{
+   try {
+      using graphene::transaction_record::transaction_record_store;
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      const uint32_t trx_per_block = 1000;
+      // enough for runs_per_level runs to be merged into the next level
+      const uint32_t block_count = transaction_record_store::runs_per_level * transaction_record_store::run_size / trx_per_block + 10;
+      auto trx_id = []( uint32_t block_num, uint32_t trx_in_block ) {
+         return transaction_id_type::hash( fc::to_string( uint64_t(block_num) ) + "/" + fc::to_string( uint64_t(trx_in_block) ) );
+      };
+      auto check = [&]( const transaction_record_store& store, uint32_t block_num, uint32_t trx_in_block ) {
+         auto r = store.find( trx_id( block_num, trx_in_block ) );
+         BOOST_REQUIRE( r.valid() );
+         BOOST_CHECK_EQUAL( r->block_num, block_num );
+         BOOST_CHECK_EQUAL( r->trx_in_block, trx_in_block );
+      };
+
+      {
+         transaction_record_store store;
+         store.open( data_dir.path() );
+         BOOST_CHECK_EQUAL( store.last_block_num(), 0u );
+         for( uint32_t block_num = 1; block_num <= block_count; ++block_num )
+         {
+            vector<transaction_record_store::record> records( trx_per_block );
+            for( uint32_t i = 0; i < trx_per_block; ++i )
+            {
+               records[i].trx_id = trx_id( block_num, i );
+               records[i].block_num = block_num;
+               records[i].trx_in_block = i;
+            }
+            store.store( block_num, records );
+         }
+         BOOST_CHECK_EQUAL( store.last_block_num(), block_count );
+         // blocks that were stored already are ignored
+         vector<transaction_record_store::record> again( 1 );
+         again[0].trx_id = trx_id( 1, 0 );
+         again[0].block_num = 1;
+         again[0].trx_in_block = 7;
+         store.store( 1, again );
+
+         for( uint32_t block_num = 1; block_num <= block_count; block_num += 37 )
+            check( store, block_num, block_num % trx_per_block );
+         check( store, 1, 0 );
+         check( store, block_count, trx_per_block - 1 );
+         BOOST_CHECK( !store.find( trx_id( block_count + 1, 0 ) ).valid() );
+      }
+
+      // a block whose end marker is missing is dropped when the store is opened
+      {
+         std::ofstream log( ( data_dir.path() / "log" ).generic_string(), std::ios::out | std::ios::binary | std::ios::app );
+         transaction_record_store::record r;
+         r.trx_id = trx_id( block_count + 1, 0 );
+         r.block_num = block_count + 1;
+         log.write( (const char*)&r, sizeof(r) );
+      }
+      {
+         transaction_record_store store;
+         store.open( data_dir.path() );
+         BOOST_CHECK_EQUAL( store.last_block_num(), block_count );
+         BOOST_CHECK( !store.find( trx_id( block_count + 1, 0 ) ).valid() );
+         for( uint32_t block_num = 1; block_num <= block_count; block_num += 41 )
+            check( store, block_num, trx_per_block - 1 - block_num % trx_per_block );
+         store.set_cache_size( 0 );
+         check( store, block_count, 0 );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -180,6 +332,278 @@ BOOST_AUTO_TEST_CASE( generate_empty_blocks )
    }
 }
 
+BOOST_AUTO_TEST_CASE( resume_from_changes_after_unclean_shutdown )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      block_id_type head_id;
+      uint32_t head_num;
+      uint64_t head_aslot;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         BOOST_CHECK( !database::has_snapshot( data_dir.path() ) );
+         // without a full snapshot the first save falls back to flush()
+         db.flush_changes();
+         BOOST_CHECK( database::has_snapshot( data_dir.path() ) );
+
+         for( uint32_t segment = 0; segment < 2; ++segment )
+         {
+            for( uint32_t i = 0; i < 5; ++i )
+               db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+            db.flush_changes();
+         }
+         // these blocks are only in the block log
+         for( uint32_t i = 0; i < 3; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         head_id = db.head_block_id();
+         head_num = db.head_block_num();
+         head_aslot = db.get_dynamic_global_properties().current_aslot;
+         // no close(), as if the process was killed
+      }
+      {
+         database db;
+         db.open(data_dir.path(), []{return genesis_state_type();});
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_num );
+         BOOST_CHECK( db.head_block_id() == head_id );
+         BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().current_aslot, head_aslot );
+         db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_num + 1 );
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( resume_round_trips_changed_objects )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      auto other_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("other_key")) );
+
+      auto state_of = []( const database& db ) {
+         vector<char> state = fc::raw::pack( db.get_dynamic_global_properties() );
+         auto append = [&state]( const vector<char>& data ) { state.insert( state.end(), data.begin(), data.end() ); };
+         for( const auto& a : db.get_index_type<account_index>().indices() )
+            append( fc::raw::pack( a ) );
+         for( const auto& w : db.get_index_type<witness_index>().indices() )
+            append( fc::raw::pack( w ) );
+         return state;
+      };
+
+      vector<char> saved_state;
+      account_object saved_account;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         db.flush_changes();
+
+         // an account with several keys and an account authority, saved in one change segment
+         signed_transaction trx;
+         set_expiration( db, trx );
+         account_create_operation cop;
+         cop.registrar = GRAPHENE_TEMP_ACCOUNT;
+         cop.name = "roundtrip";
+         cop.owner = authority( 2, init_account_priv_key.get_public_key(), 1, other_key.get_public_key(), 1 );
+         cop.owner.add_authority( GRAPHENE_COMMITTEE_ACCOUNT, 1 );
+         cop.active = authority( 1, other_key.get_public_key(), 1 );
+         cop.options.memo_key = other_key.get_public_key();
+         trx.operations.push_back( cop );
+         const account_id_type account_id = db.push_transaction( trx, ~0 ).operation_results[0].get<object_id_type>();
+         db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.flush_changes();
+
+         // and modified in the next one
+         trx.clear();
+         set_expiration( db, trx );
+         account_update_operation uop;
+         uop.account = account_id;
+         uop.new_options = account_id( db ).options;
+         uop.new_options->votes.insert( db.get_index_type<witness_index>().indices().begin()->vote_id );
+         uop.new_options->num_witness = 1;
+         trx.operations.push_back( uop );
+         db.push_transaction( trx, ~0 );
+         db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.flush_changes();
+
+         saved_state = state_of( db );
+         saved_account = account_id( db );
+         BOOST_CHECK_EQUAL( saved_account.options.votes.size(), 1u );
+         // no close(), as if the process was killed
+      }
+      {
+         database db;
+         db.open(data_dir.path(), []{return genesis_state_type();});
+         const auto& by_name = db.get_index_type<account_index>().indices().get<by_name>();
+         BOOST_REQUIRE( by_name.find( "roundtrip" ) != by_name.end() );
+         const account_object& account = *by_name.find( "roundtrip" );
+         BOOST_CHECK( account.id == saved_account.id );
+         BOOST_CHECK( account.owner == saved_account.owner );
+         BOOST_CHECK( account.active == saved_account.active );
+         BOOST_CHECK( account.options.votes == saved_account.options.votes );
+         BOOST_CHECK( fc::raw::pack( account ) == fc::raw::pack( saved_account ) );
+         BOOST_CHECK( state_of( db ) == saved_state );
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( no_resume_after_clean_close )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      block_id_type head_id;
+      uint32_t head_num;
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         for( uint32_t i = 0; i < 5; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.flush_changes();
+         BOOST_CHECK( database::has_resume_point( data_dir.path() ) );
+         db.close();
+      }
+      // the snapshot written by close() is stale as soon as the next session applies a block
+      BOOST_CHECK( database::has_snapshot( data_dir.path() ) );
+      BOOST_CHECK( !database::has_resume_point( data_dir.path() ) );
+      {
+         database db;
+         db.open(data_dir.path(), make_genesis );
+         for( uint32_t i = 0; i < 3; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         // no close() and no flush_changes(), as if the process was killed
+      }
+      BOOST_CHECK( !database::has_resume_point( data_dir.path() ) );
+      {
+         // what the application does without a resume point
+         database db;
+         db.reindex( data_dir.path(), make_genesis() );
+         for( uint32_t i = 0; i < 2; ++i )
+            db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+         db.flush_changes();
+         head_id = db.head_block_id();
+         head_num = db.head_block_num();
+         // killed again, this time after a save
+      }
+      BOOST_CHECK( database::has_resume_point( data_dir.path() ) );
+      {
+         database db;
+         db.open(data_dir.path(), []{return genesis_state_type();});
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_num );
+         BOOST_CHECK( db.head_block_id() == head_id );
+         // opening consumes the resume point
+         BOOST_CHECK( !database::has_resume_point( data_dir.path() ) );
+         db.close();
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+/**
+ *  Reindexing applies the same blocks with and without the replay pipeline, also when the block log has a gap and the
+ *  blocks after it are dropped.
+ */
+BOOST_AUTO_TEST_CASE( reindex_with_replay_threads )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+
+      // the state replays have to agree on
+      auto state_of = []( const database& db ) {
+         vector<char> state = fc::raw::pack( db.get_dynamic_global_properties() );
+         auto append = [&state]( const vector<char>& data ) { state.insert( state.end(), data.begin(), data.end() ); };
+         for( const auto& a : db.get_index_type<account_index>().indices() )
+            append( fc::raw::pack( a ) );
+         for( const auto& w : db.get_index_type<witness_index>().indices() )
+            append( fc::raw::pack( w ) );
+         return state;
+      };
+
+      const uint32_t block_count = 60;
+      const uint32_t gap = 30;
+      vector<signed_block> blocks;
+      {
+         database db;
+         db.open( data_dir.path(), make_genesis );
+         for( uint32_t i = 1; i <= block_count; ++i )
+         {
+            if( i % 5 == 0 )
+            {
+               signed_transaction trx;
+               set_expiration( db, trx );
+               account_create_operation cop;
+               cop.registrar = GRAPHENE_TEMP_ACCOUNT;
+               cop.name = "replay" + fc::to_string( uint64_t( i ) );
+               cop.owner = authority( 1, init_account_priv_key.get_public_key(), 1 );
+               cop.active = cop.owner;
+               trx.operations.push_back( cop );
+               db.push_transaction( trx, ~0 );
+            }
+            blocks.push_back( db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1),
+                                                 init_account_priv_key, database::skip_nothing ) );
+         }
+         db.close();
+      }
+
+      for( bool with_gap : { false, true } )
+      {
+         vector<char> serial_state;
+         for( uint32_t threads : { 0u, 1u, 3u } )
+         {
+            // a block log holding the blocks, and nothing else
+            fc::temp_directory replay_dir( graphene::utilities::temp_directory_path() );
+            {
+               mapped_block_database bdb;
+               bdb.open( replay_dir.path() / "database" / "block_num_to_block" );
+               for( const auto& b : blocks )
+                  if( !with_gap || b.block_num() != gap )
+                     bdb.store( b.id(), b );
+               bdb.close();
+            }
+
+            database db;
+            // a queue shorter than the distance to the gap, and one holding all blocks
+            db.set_replay_pipeline( threads, threads == 3 ? block_count : 4 );
+            db.reindex( replay_dir.path(), make_genesis() );
+
+            const uint32_t expected_head = with_gap ? gap - 1 : block_count;
+            BOOST_CHECK_EQUAL( db.head_block_num(), expected_head );
+            BOOST_CHECK( db.head_block_id() == blocks[expected_head - 1].id() );
+            BOOST_CHECK( db.fetch_block_by_number( gap + 1 ).valid() != with_gap );
+            BOOST_CHECK_EQUAL( db.get_index_type<account_index>().indices().get<by_name>().count( "replay25" ), 1u );
+            BOOST_CHECK_EQUAL( db.get_index_type<account_index>().indices().get<by_name>().count( "replay35" ),
+                               with_gap ? 0u : 1u );
+
+            const vector<char> state = state_of( db );
+            if( serial_state.empty() )
+               serial_state = state;
+            else
+               BOOST_CHECK( state == serial_state );
+
+            // the replayed chain continues
+            db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key,
+                               database::skip_nothing );
+            BOOST_CHECK_EQUAL( db.head_block_num(), expected_head + 1 );
+            db.close();
+         }
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( undo_block )
 {
    try {
@@ -713,6 +1137,94 @@ BOOST_FIXTURE_TEST_CASE( maintenance_interval, database_fixture )
 }
 
 
+BOOST_FIXTURE_TEST_CASE( sharded_maintenance_matches_serial, database_fixture )
+{
+   try {
+      vector<vote_id_type> witness_votes;
+      for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+         witness_votes.push_back( wit.vote_id );
+      BOOST_REQUIRE_GT( witness_votes.size(), 1u );
+      // only the accounts receiving cashback vote for this witness
+      const vote_id_type recipient_vote = witness_votes.back();
+      witness_votes.pop_back();
+
+      // every other account pays fees whose cashback goes to the next one, which is tallied after it in name order
+      const uint32_t account_count = 300;
+      share_type recipient_balances = 0;
+      share_type created = 0;
+      for( uint32_t i = 0; i < account_count; ++i )
+      {
+         const bool payer = i % 2 == 0;
+         const account_object& acct = db.create<account_object>( [&]( account_object& a ) {
+            a.name = "voter" + fc::to_string( uint64_t( 1000 + i ) );
+            a.registrar = a.referrer = a.lifetime_referrer = payer ? account_id_type( a.id.instance() + 1 )
+                                                                   : GRAPHENE_TEMP_ACCOUNT;
+            a.network_fee_percentage = GRAPHENE_DEFAULT_NETWORK_PERCENT_OF_FEE;
+            a.lifetime_referrer_fee_percentage = GRAPHENE_DEFAULT_LIFETIME_REFERRER_PERCENT_OF_FEE;
+            a.owner.weight_threshold = 1;
+            a.active.weight_threshold = 1;
+            a.options.voting_account = GRAPHENE_PROXY_TO_SELF_ACCOUNT;
+            a.options.num_witness = i % 5;
+            if( payer )
+               a.options.votes.insert( witness_votes[ i % witness_votes.size() ] );
+            else
+               a.options.votes.insert( recipient_vote );
+            a.statistics = db.create<account_statistics_object>( [&]( account_statistics_object& s ) {
+               s.owner = a.id;
+               if( payer )
+                  s.pending_fees = 100000;
+            }).id;
+         });
+         db.create<account_balance_object>( [&]( account_balance_object& b ) {
+            b.owner = acct.id;
+            b.asset_type = asset_id_type();
+            b.balance = 1000000 + i;
+         });
+         if( !payer )
+            recipient_balances += 1000000 + i;
+         created += 1000000 + i + ( payer ? 100000 : 0 );
+      }
+      // the balances and fees above were created out of thin air, keep the supply consistent with them
+      db.modify( asset_id_type()(db).dynamic_asset_data_id(db), [&]( asset_dynamic_data_object& d ) {
+         d.current_supply += created;
+      });
+
+      generate_block();
+      const auto interval = db.get_global_properties().parameters.block_interval;
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time - interval );
+
+      auto tally = [&]() {
+         vector<uint64_t> votes;
+         for( const witness_object& wit : db.get_index_type<witness_index>().indices() )
+            votes.push_back( wit.total_votes );
+         return votes;
+      };
+
+      // the same maintenance block, applied serially and then on the maintenance threads
+      db.set_maintenance_threads( 0 );
+      generate_block();
+      const vector<uint64_t> serial_votes = tally();
+      const auto serial_next_maintenance = db.get_dynamic_global_properties().next_maintenance_time;
+      db.pop_block();
+
+      db.set_maintenance_threads( 4 );
+      generate_block();
+      const vector<uint64_t> sharded_votes = tally();
+      BOOST_CHECK( db.get_dynamic_global_properties().next_maintenance_time == serial_next_maintenance );
+      db.set_maintenance_threads( 0 );
+
+      BOOST_CHECK( sharded_votes == serial_votes );
+      // the cashback deposited by the fees of the preceding accounts is part of the recipients' stake
+      const auto& recipient_witness = *std::find_if( db.get_index_type<witness_index>().indices().begin(),
+                                                     db.get_index_type<witness_index>().indices().end(),
+                                                     [&]( const witness_object& w ) { return w.vote_id == recipient_vote; } );
+      BOOST_CHECK_GT( recipient_witness.total_votes, uint64_t( recipient_balances.value ) );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_FIXTURE_TEST_CASE( limit_order_expiration, database_fixture )
 { try {
    //Get a sane head block time
@@ -1257,4 +1769,265 @@ BOOST_FIXTURE_TEST_CASE( miss_many_blocks, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( block_events_in_order, database_fixture )
+{
+   try
+   {
+      ACTOR( alice );
+      generate_block();
+
+      vector<uint32_t> block_nums;
+      bool saw_alice = false;
+      db.block_events().set_max_queued( 2 );
+      db.block_events().add_consumer( "test", [&]( const applied_block_event& e )
+      {
+         block_nums.push_back( e.block_num );
+         if( e.get_impacted_accounts().count( alice_id ) )
+            saw_alice = true;
+      } );
+
+      const uint32_t first = db.head_block_num() + 1;
+      transfer( committee_account, alice_id, asset( 1000 ) );
+      for( int i = 0; i < 10; ++i )
+         generate_block();
+
+      db.block_events().wait_until_handled( "test" );
+      BOOST_REQUIRE_EQUAL( block_nums.size(), 10 );
+      for( uint32_t i = 0; i < block_nums.size(); ++i )
+         BOOST_CHECK_EQUAL( block_nums[i], first + i );
+      BOOST_CHECK( saw_alice );
+
+      auto status = db.block_events().get_consumer_status();
+      BOOST_REQUIRE_EQUAL( status.size(), 1 );
+      BOOST_CHECK_EQUAL( status[0].last_block_num, db.head_block_num() );
+      BOOST_CHECK_EQUAL( status[0].lag, 0 );
+
+      db.block_events().remove_consumer( "test" );
+      BOOST_CHECK( !db.block_events().has_consumers() );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( recent_transaction_cache, database_fixture )
+{
+   try
+   {
+      ACTOR( alice );
+      db.set_recent_transaction_cache_size( 1 );
+      const auto skip = database::skip_transaction_signatures | database::skip_authority_check;
+
+      signed_transaction trx1;
+      transfer_operation t;
+      t.from = committee_account;
+      t.to = alice_id;
+      t.amount = asset( 100 );
+      trx1.operations.push_back( t );
+      set_expiration( db, trx1 );
+      PUSH_TX( db, trx1, skip );
+
+      signed_transaction trx2;
+      t.amount = asset( 200 );
+      trx2.operations.push_back( t );
+      set_expiration( db, trx2 );
+      PUSH_TX( db, trx2, skip );
+
+      // only the body of the last transaction is kept, the duplicate check still knows both
+      GRAPHENE_CHECK_THROW( db.get_recent_transaction( trx1.id() ), fc::exception );
+      BOOST_CHECK( db.get_recent_transaction( trx2.id() ).id() == trx2.id() );
+      BOOST_CHECK( db.is_known_transaction( trx1.id() ) );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db, trx1, skip ), fc::exception );
+
+      generate_block();
+      BOOST_CHECK( db.is_known_transaction( trx1.id() ) );
+      GRAPHENE_CHECK_THROW( PUSH_TX( db, trx1, skip ), fc::exception );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( recent_transaction_cache_skips_failed, database_fixture )
+{
+   try
+   {
+      ACTOR( alice );
+      const auto skip = database::skip_transaction_signatures | database::skip_authority_check;
+
+      // alice has nothing to transfer, so the transaction fails while its operations are evaluated
+      signed_transaction trx;
+      transfer_operation t;
+      t.from = alice_id;
+      t.to = committee_account;
+      t.amount = asset( 100 );
+      trx.operations.push_back( t );
+      set_expiration( db, trx );
+      GRAPHENE_REQUIRE_THROW( PUSH_TX( db, trx, skip ), fc::exception );
+
+      GRAPHENE_CHECK_THROW( db.get_recent_transaction( trx.id() ), fc::exception );
+      BOOST_CHECK( !db.is_known_transaction( trx.id() ) );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_FIXTURE_TEST_CASE( signature_recovery_threads, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 1000000 ) );
+      generate_block();
+
+      for( uint32_t i = 0; i < 20; ++i )
+      {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = ( i % 2 ) ? bob_id : account_id_type();
+         op.amount = asset( i + 1 );
+         tx.operations.push_back( op );
+         set_expiration( db, tx );
+         tx.sign( alice_private_key, db.get_chain_id() );
+         PUSH_TX( db, tx, ~0 );
+      }
+      // produce the block once to get a valid signed block, then rewind so it can be pushed again
+      const signed_block b = generate_block();
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 20u );
+      db.pop_block();
+      db.clear_pending();
+      db._popped_tx.clear();
+
+      // a copy of the block where the first transaction is signed by a key that is not alice's
+      signed_block bad = b;
+      const auto other_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "other" ) ) );
+      bad.transactions[0].signatures[0] = bad.transactions[0].sign( other_key, db.get_chain_id() );
+      bad.transaction_merkle_root = bad.calculate_merkle_root();
+      bad.sign( init_account_priv_key );
+
+      const uint32_t skip = database::skip_undo_history_check | database::skip_fork_db;
+      const auto alice_before = get_balance( alice_id, asset_id_type() );
+      vector<int64_t> serial_balances;
+      for( uint32_t threads : { 0, 4 } )
+      {
+         db.set_signature_recovery_threads( threads );
+
+         GRAPHENE_REQUIRE_THROW( db.push_block( bad, skip ), fc::exception );
+         BOOST_CHECK( db.head_block_id() == b.previous );
+         BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), alice_before );
+
+         db.push_block( b, skip );
+         BOOST_CHECK( db.head_block_id() == b.id() );
+         for( const auto& tx : b.transactions )
+            BOOST_CHECK( db.is_known_transaction( tx.id() ) );
+         const vector<int64_t> balances = { get_balance( alice_id, asset_id_type() ),
+                                            get_balance( bob_id, asset_id_type() ),
+                                            get_balance( account_id_type(), asset_id_type() ) };
+         if( serial_balances.empty() )
+            serial_balances = balances;
+         else
+            BOOST_CHECK( serial_balances == balances );
+
+         db.pop_block();
+         db.clear_pending();
+         db._popped_tx.clear();
+      }
+      db.set_signature_recovery_threads( 0 );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+/**
+ *  Transactions admitted with admission threads are checked there and applied like pushed ones; each outcome is
+ *  counted in the admission stats.
+ */
+BOOST_FIXTURE_TEST_CASE( transaction_admission, database_fixture )
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      fund( alice, asset( 1000000 ) );
+      generate_block();
+
+      auto make_transfer = [&]( int64_t amount, const fc::ecc::private_key& key ) {
+         signed_transaction tx;
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = bob_id;
+         op.amount = asset( amount );
+         tx.operations.push_back( op );
+         set_expiration( db, tx );
+         tx.sign( key, db.get_chain_id() );
+         return tx;
+      };
+      const auto other_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "other" ) ) );
+      const auto& stats = db.get_transaction_admission_stats();
+
+      db.set_transaction_admission( 2, 4 );
+      const int64_t bob_before = get_balance( bob_id, asset_id_type() );
+
+      const signed_transaction good = make_transfer( 100, alice_private_key );
+      db.admit_transaction( good );
+      BOOST_CHECK_EQUAL( stats.admitted, 1u );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), bob_before + 100 );
+
+      // a duplicate and a transaction signed by the wrong key pass the checks but fail to apply
+      GRAPHENE_REQUIRE_THROW( db.admit_transaction( good ), fc::exception );
+      GRAPHENE_REQUIRE_THROW( db.admit_transaction( make_transfer( 200, other_key ) ), fc::exception );
+      BOOST_CHECK_EQUAL( stats.rejected_apply, 2u );
+
+      // an invalid transaction fails the checks on the admission thread
+      GRAPHENE_REQUIRE_THROW( db.admit_transaction( make_transfer( 0, alice_private_key ) ), fc::exception );
+      BOOST_CHECK_EQUAL( stats.rejected_invalid, 1u );
+
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), bob_before + 100 );
+      BOOST_CHECK_EQUAL( stats.admitted, 1u );
+      BOOST_CHECK_EQUAL( stats.rejected_queue_full, 0u );
+      BOOST_CHECK_EQUAL( stats.queue_depth, 0u );
+
+      // while one transaction is checked, a second one finds the queue full
+      db.set_transaction_admission( 1, 1 );
+      const signed_transaction first = make_transfer( 300, alice_private_key );
+      const signed_transaction second = make_transfer( 400, alice_private_key );
+      auto admitted = fc::async( [&]() { db.admit_transaction( first ); } );
+      auto refused = fc::async( [&]() { db.admit_transaction( second ); } );
+      admitted.wait();
+      GRAPHENE_REQUIRE_THROW( refused.wait(), fc::exception );
+      BOOST_CHECK_EQUAL( stats.admitted, 2u );
+      BOOST_CHECK_EQUAL( stats.rejected_queue_full, 1u );
+      BOOST_CHECK_EQUAL( stats.queue_depth, 0u );
+      BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), bob_before + 400 );
+
+      // the admitted transactions go into the next block
+      const signed_block b = generate_block();
+      BOOST_CHECK_EQUAL( b.transactions.size(), 2u );
+      BOOST_CHECK( db.is_known_transaction( good.id() ) );
+      BOOST_CHECK( db.is_known_transaction( first.id() ) );
+
+      // without threads transactions are pushed directly and not counted
+      db.set_transaction_admission( 0, 1 );
+      db.admit_transaction( second );
+      GRAPHENE_REQUIRE_THROW( db.admit_transaction( second ), fc::exception );
+      BOOST_CHECK_EQUAL( stats.admitted, 2u );
+      BOOST_CHECK_EQUAL( stats.rejected_apply, 2u );
+   }
+   catch (fc::exception& e)
+   {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -24,13 +24,34 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api.hpp>
 #include <graphene/app/database_api.hpp>
 
+#include <fc/thread/thread.hpp>
+
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
 using namespace graphene::chain::test;
 
+namespace {
+
+/// a database_fixture whose market history plugin tracks buckets, so that it records fills
+struct market_history_fixture : public database_fixture
+{
+   market_history_fixture()
+   : database_fixture( options() ) {}
+
+   static boost::program_options::variables_map options()
+   {
+      boost::program_options::variables_map result;
+      result.emplace( "bucket-size", boost::program_options::variable_value( string( "[15,60,300,3600,86400]" ), false ) );
+      return result;
+   }
+};
+
+}
+
 BOOST_FIXTURE_TEST_SUITE(database_api_tests, database_fixture)
 
   BOOST_AUTO_TEST_CASE(is_registered) {
@@ -68,4 +89,339 @@ BOOST_FIXTURE_TEST_SUITE(database_api_tests, database_fixture)
       } FC_LOG_AND_RETHROW()
   }
 
+  BOOST_AUTO_TEST_CASE(get_order_book_depth) {
+      try {
+          ACTORS((alice)(bob));
+          const asset_object& test = create_user_issued_asset("DEPTH");
+          const asset_object& core = asset_id_type()(db);
+          transfer(committee_account, alice_id, asset(1000000));
+          transfer(committee_account, bob_id, asset(1000000));
+          issue_uia(alice, test.amount(1000000));
+          issue_uia(bob, test.amount(1000000));
+
+          graphene::app::database_api db_api(db);
+          const double core_scale = pow(10, core.precision);
+          const double test_scale = pow(10, test.precision);
+
+          // two bids at the same price and a lower one
+          create_sell_order(alice, core.amount(100), test.amount(200));
+          create_sell_order(bob, core.amount(300), test.amount(600));
+          create_sell_order(bob, core.amount(100), test.amount(300));
+          const limit_order_object* ask = create_sell_order(alice, test.amount(500), core.amount(1000));
+          BOOST_REQUIRE(ask != nullptr);
+
+          auto book = db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 10);
+          BOOST_REQUIRE_EQUAL(book.bids.size(), 2);
+          BOOST_REQUIRE_EQUAL(book.asks.size(), 1);
+          BOOST_CHECK_EQUAL(book.bids[0].base, 400 / core_scale);
+          BOOST_CHECK_EQUAL(book.bids[0].quote, 800 / test_scale);
+          BOOST_CHECK_EQUAL(book.bids[1].base, 100 / core_scale);
+          BOOST_CHECK_EQUAL(book.asks[0].quote, 500 / test_scale);
+          BOOST_CHECK_EQUAL(book.asks[0].base, 1000 / core_scale);
+          BOOST_CHECK_EQUAL(db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 1).bids.size(), 1);
+
+          // an undone order leaves the book as it was
+          {
+             auto session = db._undo_db.start_undo_session();
+             create_sell_order(alice, core.amount(50), test.amount(100));
+             BOOST_CHECK_EQUAL(db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 10).bids[0].base, 450 / core_scale);
+          }
+          BOOST_CHECK_EQUAL(db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 10).bids[0].base, 400 / core_scale);
+
+          // a partial fill shrinks the level, a cancel removes it
+          create_sell_order(bob, test.amount(100), core.amount(50));
+          book = db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 10);
+          BOOST_CHECK_EQUAL(book.bids[0].base, 350 / core_scale);
+          cancel_limit_order(*ask);
+          BOOST_CHECK(db_api.get_order_book_depth(GRAPHENE_SYMBOL, "DEPTH", 10).asks.empty());
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(get_asset_holders_page) {
+      try {
+          ACTORS((alice)(bob)(carol));
+          const asset_object& test = create_user_issued_asset("HOLD");
+          issue_uia(alice, test.amount(300));
+          issue_uia(bob, test.amount(200));
+          issue_uia(carol, test.amount(100));
+
+          graphene::app::asset_api asset_api(db);
+          BOOST_CHECK_EQUAL(asset_api.get_asset_holders_count(test.id), 3);
+
+          auto page = asset_api.get_asset_holders_page(test.id, {}, 2);
+          BOOST_CHECK_EQUAL(page.total_holders, 3);
+          BOOST_REQUIRE_EQUAL(page.holders.size(), 2);
+          BOOST_CHECK(page.holders[0].account_id == alice_id);
+          BOOST_CHECK(page.holders[1].account_id == bob_id);
+          BOOST_REQUIRE(page.next.valid());
+
+          page = asset_api.get_asset_holders_page(test.id, page.next, 2);
+          BOOST_REQUIRE_EQUAL(page.holders.size(), 1);
+          BOOST_CHECK(page.holders[0].account_id == carol_id);
+          BOOST_CHECK(!page.next.valid());
+
+          // emptying a balance drops the holder, also across undo
+          {
+             auto session = db._undo_db.start_undo_session();
+             transfer(carol, alice, test.amount(100));
+             BOOST_CHECK_EQUAL(asset_api.get_asset_holders_count(test.id), 2);
+             BOOST_CHECK_EQUAL(asset_api.get_asset_holders(test.id).size(), 2);
+          }
+          BOOST_CHECK_EQUAL(asset_api.get_asset_holders_count(test.id), 3);
+          BOOST_CHECK_EQUAL(asset_api.get_asset_holders(test.id).size(), 3);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(get_block_range) {
+      try {
+          generate_blocks(10);
+          const uint32_t head = db.head_block_num();
+          graphene::app::database_api db_api(db);
+
+          // packed and unpacked pages hold the same blocks as fetching them one at a time
+          auto packed = db_api.get_block_range(2, 5, true);
+          auto unpacked = db_api.get_block_range(2, 5, false);
+          BOOST_CHECK_EQUAL(packed.first_block_num, 2);
+          BOOST_CHECK_EQUAL(packed.next_block_num, 7);
+          BOOST_CHECK_EQUAL(unpacked.next_block_num, 7);
+          BOOST_CHECK_EQUAL(packed.head_block_num, head);
+          BOOST_CHECK(packed.blocks.empty());
+          BOOST_CHECK(unpacked.packed_blocks.empty());
+          BOOST_CHECK(unpacked.packed_block_sizes.empty());
+          BOOST_REQUIRE_EQUAL(packed.packed_block_sizes.size(), 5);
+          BOOST_REQUIRE_EQUAL(unpacked.blocks.size(), 5);
+          size_t offset = 0;
+          for( size_t i = 0; i < 5; ++i )
+          {
+             const vector<char> data( packed.packed_blocks.begin() + offset,
+                                      packed.packed_blocks.begin() + offset + packed.packed_block_sizes[i] );
+             offset += packed.packed_block_sizes[i];
+             BOOST_CHECK( data == fc::raw::pack( unpacked.blocks[i] ) );
+             BOOST_CHECK( unpacked.blocks[i].id() == db.fetch_block_by_number( 2 + i )->id() );
+          }
+          BOOST_CHECK_EQUAL(offset, packed.packed_blocks.size());
+
+          // no blocks, or fewer at the head block
+          auto page = db_api.get_block_range(2, 0, true);
+          BOOST_CHECK_EQUAL(page.next_block_num, 2);
+          BOOST_CHECK(page.packed_blocks.empty());
+          page = db_api.get_block_range(head - 1, 10, false);
+          BOOST_CHECK_EQUAL(page.next_block_num, head + 1);
+          BOOST_REQUIRE_EQUAL(page.blocks.size(), 2);
+          BOOST_CHECK(page.blocks.back().id() == db.head_block_id());
+          page = db_api.get_block_range(head + 1, 10, true);
+          BOOST_CHECK_EQUAL(page.next_block_num, head + 1);
+          BOOST_CHECK(page.packed_block_sizes.empty());
+          page = db_api.get_block_range(0, 10, false);
+          BOOST_CHECK_EQUAL(page.next_block_num, 0);
+          BOOST_CHECK(page.blocks.empty());
+          GRAPHENE_REQUIRE_THROW(db_api.get_block_range(1, 1001, true), fc::exception);
+
+          // the byte bound cuts the range short, but lets through a first block larger than it
+          vector<char> data;
+          vector<uint32_t> sizes;
+          const uint64_t two_blocks = packed.packed_block_sizes[0] + packed.packed_block_sizes[1];
+          BOOST_CHECK_EQUAL(db.fetch_packed_block_range(2, 5, two_blocks, data, sizes), 2);
+          BOOST_CHECK_EQUAL(data.size(), two_blocks);
+          BOOST_CHECK( data == vector<char>( packed.packed_blocks.begin(), packed.packed_blocks.begin() + two_blocks ) );
+          data.clear();
+          sizes.clear();
+          BOOST_CHECK_EQUAL(db.fetch_packed_block_range(2, 5, 1, data, sizes), 1);
+          BOOST_REQUIRE_EQUAL(sizes.size(), 1);
+          BOOST_CHECK_EQUAL(sizes[0], packed.packed_block_sizes[0]);
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(object_subscriptions) {
+      try {
+          ACTORS((alice)(bob)(carol));
+          const asset_id_type test_id = create_user_issued_asset("SUBS").id;
+          transfer(committee_account, alice_id, asset(100000));
+          generate_block();
+
+          // each session collects the ids of the objects it is sent, and which of them were sent as removed
+          struct collected
+          {
+             set<object_id_type> objects;
+             set<object_id_type> removed;
+             void clear() { objects.clear(); removed.clear(); }
+          };
+          auto collect_into = []( collected& c ) {
+             return [&c]( const variant& v ) {
+                for( const auto& update : v.get_array() )
+                {
+                   if( update.is_object() )
+                      c.objects.insert( update["id"].as<object_id_type>() );
+                   else
+                   {
+                      c.objects.insert( update.as<object_id_type>() );
+                      c.removed.insert( update.as<object_id_type>() );
+                   }
+                }
+             };
+          };
+          // updates are sent from a task of this thread
+          auto deliver = []() { for( int i = 0; i < 10; ++i ) fc::yield(); };
+
+          collected by_object, by_account, remove_create;
+          graphene::app::database_api object_api(db);
+          graphene::app::database_api account_api(db);
+          graphene::app::database_api remove_create_api(db);
+          object_api.set_subscribe_callback(collect_into(by_object), false);
+          account_api.set_subscribe_callback(collect_into(by_account), false);
+          remove_create_api.set_subscribe_callback(collect_into(remove_create), true);
+
+          const object_id_type alice_stats = alice_id(db).statistics;
+          const object_id_type bob_stats = bob_id(db).statistics;
+          const object_id_type carol_stats = carol_id(db).statistics;
+          BOOST_CHECK(object_api.get_objects({ alice_stats })[0]["id"].as<object_id_type>() == alice_stats);
+          BOOST_CHECK_EQUAL(account_api.get_full_accounts({ "bob" }, true).size(), 1u);
+
+          // changes are notified once per block, a session following an account is sent all objects of a block
+          // impacting it, so each account changes in a block of its own
+          transfer(committee_account, alice_id, asset(1000));
+          generate_block();
+          deliver();
+          BOOST_CHECK(by_object.objects.count(alice_stats));
+          BOOST_CHECK(!by_account.objects.count(alice_stats));
+
+          by_object.clear();
+          transfer(committee_account, bob_id, asset(1000));
+          generate_block();
+          deliver();
+          BOOST_CHECK(by_account.objects.count(bob_stats));
+          BOOST_CHECK(!by_object.objects.count(bob_stats));
+
+          by_object.clear();
+          by_account.clear();
+          transfer(committee_account, carol_id, asset(1000));
+          generate_block();
+          deliver();
+          BOOST_CHECK(!by_object.objects.count(carol_stats));
+          BOOST_CHECK(!by_account.objects.count(carol_stats));
+
+          // only the session asking for them is told of created and removed objects
+          by_object.clear();
+          by_account.clear();
+          remove_create.clear();
+          const limit_order_id_type order = create_sell_order(alice_id, asset(1000), asset(1000, test_id))->id;
+          const object_id_type order_id = order;
+          generate_block();
+          deliver();
+          BOOST_CHECK(remove_create.objects.count(order_id));
+          BOOST_CHECK(!remove_create.removed.count(order_id));
+          BOOST_CHECK(!by_account.objects.count(order_id));
+
+          remove_create.clear();
+          cancel_limit_order(order(db));
+          generate_block();
+          deliver();
+          BOOST_CHECK(remove_create.removed.count(order_id));
+          BOOST_CHECK(!by_account.objects.count(order_id));
+
+          // nothing is sent after the subscriptions are cancelled
+          object_api.cancel_all_subscriptions();
+          account_api.cancel_all_subscriptions();
+          by_object.clear();
+          by_account.clear();
+          transfer(committee_account, alice_id, asset(1000));
+          transfer(committee_account, bob_id, asset(1000));
+          generate_block();
+          deliver();
+          BOOST_CHECK(by_object.objects.empty());
+          BOOST_CHECK(by_account.objects.empty());
+          BOOST_CHECK(!remove_create.objects.empty());
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_FIXTURE_TEST_CASE(get_trade_history_paging, market_history_fixture) {
+      try {
+          ACTORS((alice)(bob));
+          const asset_object& test = create_user_issued_asset("TRADE");
+          const asset_object& other = create_user_issued_asset("OTHER");
+          const asset_object& core = asset_id_type()(db);
+          transfer(committee_account, alice_id, asset(10000000));
+          issue_uia(bob, test.amount(1000000));
+          issue_uia(bob, other.amount(1000000));
+          generate_block();
+
+          // one trade of the market per block, each for a different amount of CORE, with trades of another
+          // market in the same blocks and in blocks of their own
+          const uint32_t trades = 12;
+          vector<fc::time_point_sec> times;
+          for( uint32_t i = 0; i < trades; ++i )
+          {
+             create_sell_order(alice, core.amount(1000 + i), test.amount(10));
+             create_sell_order(bob, test.amount(10), core.amount(1000 + i));
+             create_sell_order(alice, core.amount(2000 + i), other.amount(10));
+             create_sell_order(bob, other.amount(10), core.amount(2000 + i));
+             generate_block();
+             times.push_back(db.head_block_time());
+             create_sell_order(alice, core.amount(3000 + i), other.amount(10));
+             create_sell_order(bob, other.amount(10), core.amount(3000 + i));
+             generate_block();
+          }
+
+          graphene::app::database_api db_api(db);
+          const double core_scale = pow(10, core.precision);
+          const double test_scale = pow(10, test.precision);
+          const fc::time_point_sec after_all = db.head_block_time() + 1;
+
+          // pages continue at the date of the last trade of the previous page, the start is exclusive
+          auto read_pages = [&]( const string& base, const string& quote, fc::time_point_sec stop, unsigned limit ) {
+             vector<market_trade> result;
+             fc::time_point_sec start = after_all;
+             while( true )
+             {
+                const auto page = db_api.get_trade_history(base, quote, start, stop, limit);
+                BOOST_REQUIRE_LE(page.size(), limit);
+                result.insert(result.end(), page.begin(), page.end());
+                if( page.size() < limit )
+                   return result;
+                start = page.back().date;
+             }
+          };
+          // the CORE amount of each trade, newest first
+          auto core_amounts = []( const vector<market_trade>& page, bool core_is_base ) {
+             vector<int64_t> result;
+             for( const auto& trade : page )
+                result.push_back( std::llround( ( core_is_base ? trade.value : trade.amount ) * pow(10, GRAPHENE_BLOCKCHAIN_PRECISION_DIGITS) ) );
+             return result;
+          };
+
+          for( unsigned limit : { 1u, 5u, 12u, 100u } )
+          {
+             // every trade exactly once, in both directions of the market
+             vector<int64_t> expected;
+             for( uint32_t i = trades; i > 0; --i )
+                expected.push_back(1000 + i - 1);
+             const auto forward = read_pages(GRAPHENE_SYMBOL, "TRADE", fc::time_point_sec(), limit);
+             const auto backward = read_pages("TRADE", GRAPHENE_SYMBOL, fc::time_point_sec(), limit);
+             BOOST_CHECK(core_amounts(forward, true) == expected);
+             BOOST_CHECK(core_amounts(backward, false) == expected);
+             BOOST_REQUIRE_EQUAL(forward.size(), trades);
+             BOOST_REQUIRE_EQUAL(backward.size(), trades);
+             for( uint32_t i = 0; i < trades; ++i )
+             {
+                BOOST_CHECK(forward[i].date == times[trades - 1 - i]);
+                BOOST_CHECK(backward[i].date == forward[i].date);
+                BOOST_CHECK_EQUAL(forward[i].amount, 10 / test_scale);
+                BOOST_CHECK_EQUAL(backward[i].value, 10 / test_scale);
+                BOOST_CHECK_CLOSE(forward[i].price * backward[i].price, 1, 0.0001);
+             }
+
+             // a window that ends at the fifth trade, the stop is inclusive
+             expected.resize(trades - 4);
+             BOOST_CHECK(core_amounts(read_pages(GRAPHENE_SYMBOL, "TRADE", times[4], limit), true) == expected);
+             BOOST_CHECK(core_amounts(read_pages("TRADE", GRAPHENE_SYMBOL, times[4], limit), false) == expected);
+          }
+
+          // a window between two trades, and one that starts at a trade, which excludes it
+          BOOST_CHECK(db_api.get_trade_history(GRAPHENE_SYMBOL, "TRADE", times[5], times[4] + 1, 100).empty());
+          const auto window = db_api.get_trade_history(GRAPHENE_SYMBOL, "TRADE", times[5], times[0], 100);
+          BOOST_CHECK(core_amounts(window, true) == vector<int64_t>({ 1004, 1003, 1002, 1001, 1000 }));
+          GRAPHENE_REQUIRE_THROW(db_api.get_trade_history(GRAPHENE_SYMBOL, "TRADE", after_all, times[0], 101), fc::exception);
+      } FC_LOG_AND_RETHROW()
+  }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -59,3 +59,45 @@ BOOST_AUTO_TEST_CASE( undo_test )
       throw;
    }
 }
+
+BOOST_AUTO_TEST_CASE( dense_index_failed_modify )
+{
+   try {
+      graphene::db::object_database odb;
+      odb._undo_db.disable();
+      primary_index< account_index > idx( odb );
+      const auto& alice = static_cast<const account_object&>( idx.create( []( object& o ) {
+         static_cast<account_object&>( o ).name = "alice";
+      }));
+      idx.create( []( object& o ) { static_cast<account_object&>( o ).name = "bob"; } );
+      const object_id_type alice_id = alice.id;
+
+      // the duplicate name makes multi_index erase alice, so find() must not return the freed object
+      GRAPHENE_REQUIRE_THROW( idx.modify( alice, []( object& o ) {
+         static_cast<account_object&>( o ).name = "bob";
+      }), fc::exception );
+      BOOST_CHECK( idx.find( alice_id ) == nullptr );
+      BOOST_CHECK_EQUAL( idx.indices().size(), 1u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( undo_head_old_value )
+{
+   try {
+      database db;
+      auto ses = db._undo_db.start_undo_session( true );
+      const auto& bal = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.owner = account_id_type( 1 );
+      });
+      ses.commit();
+
+      ses = db._undo_db.start_undo_session( true );
+      BOOST_CHECK( !db._undo_db.head_old_value( bal ) );
+      db.modify( bal, []( account_balance_object& obj ){ obj.owner = account_id_type( 2 ); } );
+      db.modify( bal, []( account_balance_object& obj ){ obj.owner = account_id_type( 3 ); } );
+      auto old_bal = db._undo_db.head_old_value( bal );
+      BOOST_REQUIRE( old_bal );
+      BOOST_CHECK( static_cast<const account_balance_object&>( *old_bal ).owner == account_id_type( 1 ) );
+      BOOST_CHECK( bal.owner == account_id_type( 3 ) );
+   } FC_LOG_AND_RETHROW()
+}
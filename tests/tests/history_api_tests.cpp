@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/api.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+BOOST_FIXTURE_TEST_SUITE( history_api_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( get_account_history_operations2_paging )
+{
+   try {
+      ACTORS( (alice)(bob) );
+      const asset_id_type test_id = create_user_issued_asset( "TEST" ).id;
+      transfer( committee_account, alice_id, asset( 1000000 ) );
+      generate_block();
+
+      // transfers, order creations and cancellations interleaved, spread over several blocks
+      for( int i = 0; i < 15; ++i )
+      {
+         transfer( alice_id, bob_id, asset( 100 + i ) );
+         const limit_order_object* order = create_sell_order( alice_id, asset( 1000 ), asset( 1000 + i, test_id ) );
+         BOOST_REQUIRE( order != nullptr );
+         if( i % 3 != 0 )
+            cancel_limit_order( *order );
+         if( i % 4 == 0 )
+            generate_block();
+      }
+      generate_block();
+
+      graphene::app::history_api hist_api( app );
+      const auto all = hist_api.get_account_history( alice_id, operation_history_id_type(), 100, operation_history_id_type() );
+      BOOST_REQUIRE_LT( all.size(), 100u );
+
+      const int transfer_type = operation::tag<transfer_operation>::value;
+      const int create_type = operation::tag<limit_order_create_operation>::value;
+      const int cancel_type = operation::tag<limit_order_cancel_operation>::value;
+      const int unused_type = operation::tag<asset_settle_operation>::value;
+
+      auto ids_of = []( const vector<operation_history_object>& ops ) {
+         vector<operation_history_id_type> result;
+         for( const auto& op : ops )
+            result.push_back( op.id );
+         return result;
+      };
+      // the full history filtered by type, newest first
+      auto filtered = [&]( const vector<int>& types ) {
+         vector<operation_history_id_type> result;
+         for( const auto& op : all )
+            if( std::find( types.begin(), types.end(), op.op.which() ) != types.end() )
+               result.push_back( op.id );
+         return result;
+      };
+
+      const vector< vector<int> > type_sets = {
+         { transfer_type },
+         { create_type, transfer_type },
+         { cancel_type, create_type },
+         { transfer_type, create_type, cancel_type },
+         { cancel_type, unused_type, cancel_type }
+      };
+      for( const auto& types : type_sets )
+      {
+         const auto expected = filtered( types );
+         BOOST_REQUIRE( !expected.empty() );
+         BOOST_CHECK( ids_of( hist_api.get_account_history_operations2( alice_id, types ) ) == expected );
+
+         // pages continue before the last operation of the previous page, no operation is repeated or skipped
+         for( unsigned limit : { 1u, 2u, 7u, 100u } )
+         {
+            vector<operation_history_id_type> paged;
+            operation_history_id_type start;
+            while( true )
+            {
+               const auto page = ids_of( hist_api.get_account_history_operations2( alice_id, types, start,
+                                                                                  operation_history_id_type(), limit ) );
+               BOOST_REQUIRE_LE( page.size(), limit );
+               paged.insert( paged.end(), page.begin(), page.end() );
+               if( page.size() < limit )
+                  break;
+               start = page.back() + (-1);
+            }
+            BOOST_CHECK( paged == expected );
+         }
+
+         // start is inclusive and stop exclusive, as for get_account_history
+         const size_t first = std::min<size_t>( 2, expected.size() - 1 );
+         const size_t last = std::min<size_t>( first + 3, expected.size() - 1 );
+         const auto window = ids_of( hist_api.get_account_history_operations2( alice_id, types,
+                                                                               expected[first], expected[last], 100 ) );
+         BOOST_CHECK( window == vector<operation_history_id_type>( expected.begin() + first, expected.begin() + last ) );
+         const auto limited = ids_of( hist_api.get_account_history_operations2( alice_id, types,
+                                                                                expected[first], operation_history_id_type(), 2 ) );
+         BOOST_CHECK( limited == vector<operation_history_id_type>( expected.begin() + first,
+                                                                    expected.begin() + std::min( first + 2, expected.size() ) ) );
+         BOOST_CHECK( hist_api.get_account_history_operations2( alice_id, types, expected[first], expected[first], 100 ).empty() );
+
+         // a start just before an operation of the types begins at the next older one
+         const auto before = ids_of( hist_api.get_account_history_operations2( alice_id, types, expected[first - 1] + (-1),
+                                                                               operation_history_id_type(), 1 ) );
+         BOOST_CHECK( before == vector<operation_history_id_type>( 1, expected[first] ) );
+      }
+
+      // the single type variant agrees, no types gives nothing, and the limit is checked
+      BOOST_CHECK( ids_of( hist_api.get_account_history_operations( alice_id, create_type ) ) == filtered( { create_type } ) );
+      BOOST_CHECK( hist_api.get_account_history_operations2( alice_id, vector<int>() ).empty() );
+      BOOST_CHECK( hist_api.get_account_history_operations2( alice_id, { unused_type } ).empty() );
+      BOOST_CHECK( hist_api.get_account_history_operations2( alice_id, { transfer_type }, operation_history_id_type(),
+                                                             operation_history_id_type(), 0 ).empty() );
+      GRAPHENE_REQUIRE_THROW( hist_api.get_account_history_operations2( alice_id, { transfer_type }, operation_history_id_type(),
+                                                                        operation_history_id_type(), 101 ), fc::exception );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/api.hpp>
+#include <graphene/app/database_api.hpp>
+#include <graphene/market_history/market_history_plugin.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::market_history;
+
+namespace {
+
+/// a database_fixture whose market history plugin keeps the fills given by the template arguments
+template< uint32_t MaxFillsPerMarket, uint32_t MaxFillSeconds, bool Archive >
+struct fill_history_fixture : public database_fixture
+{
+   fill_history_fixture()
+   : database_fixture( options() )
+   {
+      alice_id = create_account( "alice" ).id;
+      bob_id = create_account( "bob" ).id;
+      test_id = create_user_issued_asset( "TEST" ).id;
+      transfer( committee_account, alice_id, asset( 1000000 ) );
+      issue_uia( bob_id, asset( 1000000, test_id ) );
+      generate_block();
+   }
+
+   static boost::program_options::variables_map options()
+   {
+      namespace bpo = boost::program_options;
+      bpo::variables_map result;
+      result.emplace( "bucket-size", bpo::variable_value( string( "[15,60,300,3600,86400]" ), false ) );
+      result.emplace( "max-fill-history-per-market", bpo::variable_value( MaxFillsPerMarket, false ) );
+      result.emplace( "max-fill-history-seconds", bpo::variable_value( MaxFillSeconds, false ) );
+      result.emplace( "fill-history-archive", bpo::variable_value( Archive, false ) );
+      return result;
+   }
+
+   /// matches count pairs of orders in a new block, each match adds a fill from either side
+   void trade( uint32_t count )
+   {
+      for( uint32_t i = 0; i < count; ++i )
+      {
+         create_sell_order( alice_id, asset( 100 + i ), asset( 100 + i, test_id ) );
+         create_sell_order( bob_id, asset( 100 + i, test_id ), asset( 100 + i ) );
+      }
+      generate_block();
+   }
+
+   /// alice sells core_amount of CORE for test_amount of TEST and bob takes it
+   void trade_at( share_type core_amount, share_type test_amount )
+   {
+      create_sell_order( alice_id, asset( core_amount ), asset( test_amount, test_id ) );
+      create_sell_order( bob_id, asset( test_amount, test_id ), asset( core_amount ) );
+   }
+
+   const market_ticker_object& ticker()const
+   {
+      const auto& idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+      auto itr = idx.find( boost::make_tuple( asset_id_type(), test_id ) );
+      BOOST_REQUIRE( itr != idx.end() );
+      return *itr;
+   }
+
+   vector<order_history_object> fill_history( uint32_t limit = 100 )
+   {
+      return graphene::app::history_api( app ).get_fill_order_history( asset_id_type(), test_id, limit );
+   }
+
+   /// the fills of the market in memory
+   size_t fills_in_memory()const
+   {
+      const auto& idx = db.get_index_type<history_index>().indices().get<by_key>();
+      history_key key;
+      key.base = asset_id_type();
+      key.quote = test_id;
+      key.sequence = std::numeric_limits<int64_t>::min();
+      size_t count = 0;
+      for( auto itr = idx.lower_bound( key ); itr != idx.end() && itr->key.quote == test_id; ++itr )
+         ++count;
+      return count;
+   }
+
+   account_id_type alice_id;
+   account_id_type bob_id;
+   asset_id_type   test_id;
+};
+
+void check_same_fills( const vector<order_history_object>& a, const vector<order_history_object>& b )
+{
+   BOOST_REQUIRE_EQUAL( a.size(), b.size() );
+   for( size_t i = 0; i < a.size(); ++i )
+   {
+      BOOST_CHECK_EQUAL( a[i].key.sequence, b[i].key.sequence );
+      BOOST_CHECK( a[i].time == b[i].time );
+      BOOST_CHECK( a[i].op.pays == b[i].op.pays );
+      BOOST_CHECK( a[i].op.receives == b[i].op.receives );
+   }
+}
+
+typedef fill_history_fixture< 4, 0, false >        count_retention_fixture;
+typedef fill_history_fixture< 0, 3 * 86400, false > age_retention_fixture;
+typedef fill_history_fixture< 2, 0, true >          archive_fixture;
+typedef fill_history_fixture< 1000, 259200, false > ticker_fixture;
+
+void check_ticker( const market_ticker_object& t, share_type latest_base, share_type latest_quote,
+                   share_type day_open_base, share_type day_open_quote,
+                   share_type base_volume, share_type quote_volume )
+{
+   BOOST_CHECK_EQUAL( t.latest_base.value, latest_base.value );
+   BOOST_CHECK_EQUAL( t.latest_quote.value, latest_quote.value );
+   BOOST_CHECK_EQUAL( t.day_open_base.value, day_open_base.value );
+   BOOST_CHECK_EQUAL( t.day_open_quote.value, day_open_quote.value );
+   BOOST_CHECK_EQUAL( t.base_volume.value, base_volume.value );
+   BOOST_CHECK_EQUAL( t.quote_volume.value, quote_volume.value );
+}
+
+/// a ticker rebuilt from the fills, as on the startup of a node that kept its fills but had no tickers
+void check_backfill( database_fixture& f, const market_ticker_object& t )
+{
+   const market_ticker_object expected = t;
+   f.db.remove( t );
+   f.app.get_plugin( "market_history" )->plugin_startup();
+
+   const auto& idx = f.db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   auto itr = idx.find( boost::make_tuple( expected.base, expected.quote ) );
+   BOOST_REQUIRE( itr != idx.end() );
+   check_ticker( *itr, expected.latest_base, expected.latest_quote, expected.day_open_base, expected.day_open_quote,
+                 expected.base_volume, expected.quote_volume );
+   BOOST_CHECK( itr->window_start == expected.window_start );
+   if( expected.window_start != fc::time_point_sec::maximum() )
+      BOOST_CHECK_EQUAL( itr->window_start_sequence, expected.window_start_sequence );
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( market_history_tests )
+
+BOOST_FIXTURE_TEST_CASE( fill_history_pruned_by_count, count_retention_fixture )
+{
+   try {
+      trade( 5 );
+      // fills stay while the ticker window counts them
+      const auto all = fill_history();
+      BOOST_REQUIRE_EQUAL( all.size(), 10 );
+      for( size_t i = 1; i < all.size(); ++i )
+         BOOST_CHECK_LT( all[i-1].key.sequence, all[i].key.sequence );
+
+      generate_blocks( db.head_block_time() + fc::days(2) );
+      generate_block();
+      check_same_fills( fill_history(), vector<order_history_object>( all.begin(), all.begin() + 4 ) );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( fill_history_pruned_by_age, age_retention_fixture )
+{
+   try {
+      trade( 2 );
+      generate_blocks( db.head_block_time() + fc::days(2) );
+      trade( 3 );
+      const auto all = fill_history();
+      BOOST_REQUIRE_EQUAL( all.size(), 10 );
+
+      // the first fills are four days old, the others two
+      generate_blocks( db.head_block_time() + fc::days(2) );
+      generate_block();
+      check_same_fills( fill_history(), vector<order_history_object>( all.begin(), all.begin() + 6 ) );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( fill_history_read_from_archive, archive_fixture )
+{
+   try {
+      trade( 5 );
+      const auto all = fill_history();
+      BOOST_REQUIRE_EQUAL( all.size(), 10 );
+
+      generate_blocks( db.head_block_time() + fc::days(2) );
+      generate_block();
+      BOOST_CHECK_EQUAL( fills_in_memory(), 2 );
+
+      // pruned fills are read back from the archive, continuing the ones in memory
+      check_same_fills( fill_history(), all );
+      check_same_fills( fill_history( 3 ), vector<order_history_object>( all.begin(), all.begin() + 3 ) );
+      check_same_fills( fill_history( 2 ), vector<order_history_object>( all.begin(), all.begin() + 2 ) );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( ticker_rolls_over, ticker_fixture )
+{
+   try {
+      trade_at( 100, 100 );
+      trade_at( 200, 100 );
+      generate_block();
+      const fc::time_point_sec first_trades = db.head_block_time();
+      check_ticker( ticker(), 200, 100, 0, 0, 300, 200 );
+
+      generate_blocks( first_trades + fc::hours(12) );
+      trade_at( 300, 100 );
+      generate_block();
+      check_ticker( ticker(), 300, 100, 0, 0, 600, 300 );
+      check_backfill( *this, ticker() );
+
+      // the first two fills leave the window, the last of them opens the day
+      generate_blocks( first_trades + fc::days(1) + fc::seconds(1) );
+      check_ticker( ticker(), 300, 100, 200, 100, 300, 100 );
+      check_backfill( *this, ticker() );
+
+      graphene::app::database_api db_api( db );
+      const auto t = db_api.get_ticker( GRAPHENE_SYMBOL, "TEST" );
+      BOOST_CHECK_CLOSE( t.percent_change, 50, 0.0001 );
+      BOOST_CHECK_CLOSE( t.base_volume, 300 / 100000.0, 0.0001 );
+      BOOST_CHECK_CLOSE( t.quote_volume, 100 / 100.0, 0.0001 );
+
+      // nothing is left in the window
+      generate_blocks( first_trades + fc::days(2) );
+      check_ticker( ticker(), 300, 100, 300, 100, 0, 0 );
+      BOOST_CHECK( ticker().window_start == fc::time_point_sec::maximum() );
+      check_backfill( *this, ticker() );
+      BOOST_CHECK_EQUAL( db_api.get_ticker( GRAPHENE_SYMBOL, "TEST" ).percent_change, 0 );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
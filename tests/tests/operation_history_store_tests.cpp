@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/account_history/operation_history_store.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/smart_ref_impl.hpp>
+
+#include <fstream>
+
+using namespace graphene::chain;
+using graphene::account_history::operation_history_store;
+using graphene::account_history::operation_history_disk_index;
+using graphene::account_history::operation_history_primary_index;
+
+BOOST_AUTO_TEST_SUITE( operation_history_store_tests )
+
+BOOST_AUTO_TEST_CASE( crash_tail_is_truncated )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      operation_history_object op;
+      {
+         operation_history_store store;
+         store.open( dir.path() );
+         for( uint64_t i = 0; i < 5; ++i )
+         {
+            op.id = operation_history_id_type( i );
+            op.block_num = i + 1;
+            store.append( op );
+         }
+         store.flush();
+      }
+
+      // a crash while appending leaves the offset of an operation whose data did not make it, and part of the next
+      // offset, behind
+      const fc::path log_file = dir.path() / "0.log";
+      const fc::path offsets_file = dir.path() / "0.offsets";
+      const uint64_t log_size = fc::file_size( log_file );
+      {
+         std::ofstream log( log_file.generic_string(), std::ios::binary | std::ios::app );
+         const uint32_t size = 1000;
+         log.write( (const char*)&size, sizeof(size) );
+         log.write( "abc", 3 );
+         std::ofstream offsets( offsets_file.generic_string(), std::ios::binary | std::ios::app );
+         offsets.write( (const char*)&log_size, sizeof(log_size) );
+         offsets.write( "abc", 3 );
+      }
+
+      operation_history_store store;
+      store.open( dir.path() );
+      BOOST_CHECK_EQUAL( store.next_instance(), 5u );
+      BOOST_CHECK_EQUAL( fc::file_size( log_file ), log_size );
+      BOOST_CHECK_EQUAL( fc::file_size( offsets_file ), 5 * sizeof(uint64_t) );
+      BOOST_CHECK( store.find( 5 ) == nullptr );
+      BOOST_REQUIRE( store.find( 4 ) != nullptr );
+      BOOST_CHECK_EQUAL( store.find( 4 )->block_num, 5u );
+
+      op.id = operation_history_id_type( 5 );
+      op.block_num = 6;
+      store.append( op );
+      store.flush();
+      BOOST_REQUIRE( store.find( 5 ) != nullptr );
+      BOOST_CHECK_EQUAL( store.find( 5 )->block_num, 6u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( found_operations_outlive_eviction )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      operation_history_store store;
+      store.open( dir.path() );
+      store.set_cache_size( 1 );
+      operation_history_object op;
+      for( uint64_t i = 0; i < 3; ++i )
+      {
+         op.id = operation_history_id_type( i );
+         op.block_num = i + 1;
+         store.append( op );
+      }
+      store.flush();
+
+      const operation_history_object* first = store.find( 0 );
+      BOOST_REQUIRE( first != nullptr );
+      // evicts the first one from the cache
+      BOOST_REQUIRE( store.find( 1 ) != nullptr );
+      BOOST_REQUIRE( store.find( 2 ) != nullptr );
+      BOOST_CHECK( first->id == operation_history_id_type( 0 ) );
+      BOOST_CHECK_EQUAL( first->block_num, 1u );
+
+      store.release_evicted();
+      BOOST_REQUIRE( store.find( 0 ) != nullptr );
+      BOOST_CHECK_EQUAL( store.find( 0 )->block_num, 1u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( evicted_operations_are_bounded )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      operation_history_store store;
+      store.open( dir.path() );
+      store.set_cache_size( 1 );
+      const size_t kept = operation_history_store::min_evicted_kept;
+      const uint64_t count = 3 * kept;
+      operation_history_object op;
+      for( uint64_t i = 0; i < count; ++i )
+      {
+         op.id = operation_history_id_type( i );
+         op.block_num = i + 1;
+         store.append( op );
+      }
+      store.flush();
+
+      // lookups between two calls of release_evicted(), like those of API calls, do not keep every operation alive
+      const operation_history_object* held = nullptr;
+      for( uint64_t i = 0; i < count; ++i )
+      {
+         const operation_history_object* found = store.find( i );
+         BOOST_REQUIRE( found != nullptr );
+         if( i == count - kept )
+            held = found;
+         BOOST_CHECK_LE( store.evicted_count(), kept );
+      }
+      BOOST_REQUIRE( held != nullptr );
+      BOOST_CHECK_EQUAL( held->block_num, count - kept + 1 );
+
+      store.release_evicted();
+      BOOST_CHECK_EQUAL( store.evicted_count(), 0u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( undo_reinserts_stored_operations )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      database db;
+      auto* idx = db.add_index< operation_history_primary_index >();
+      operation_history_store& store = idx->store();
+      store.open( dir.path() );
+
+      for( uint32_t i = 0; i < 3; ++i )
+         db.create<operation_history_object>( [&]( operation_history_object& o ) { o.block_num = i + 1; } );
+
+      // moves the two oldest operations to disk, like the account history plugin does for irreversible blocks
+      auto move_to_disk = [&]() {
+         for( int i = 0; i < 2; ++i )
+         {
+            store.append( *idx->oldest() );
+            db.remove( *idx->oldest() );
+         }
+         store.flush();
+      };
+
+      {
+         auto session = db._undo_db.start_undo_session( true );
+         move_to_disk();
+         BOOST_CHECK_EQUAL( store.next_instance(), 2u );
+         BOOST_CHECK( idx->oldest()->id == operation_history_id_type( 2 ) );
+         BOOST_REQUIRE( db.find( operation_history_id_type( 0 ) ) != nullptr );
+         BOOST_CHECK_EQUAL( operation_history_id_type( 0 )( db ).block_num, 1u );
+         session.undo();
+      }
+
+      // undo puts the operations back in memory in front of the remaining one
+      BOOST_REQUIRE( idx->oldest() != nullptr );
+      BOOST_CHECK( idx->oldest()->id == operation_history_id_type( 0 ) );
+      BOOST_CHECK_EQUAL( operation_history_id_type( 1 )( db ).block_num, 2u );
+      BOOST_CHECK_EQUAL( operation_history_id_type( 2 )( db ).block_num, 3u );
+
+      // moving them again does not store them twice
+      const uint64_t log_size = fc::file_size( dir.path() / "0.log" );
+      move_to_disk();
+      BOOST_CHECK_EQUAL( store.next_instance(), 2u );
+      BOOST_CHECK_EQUAL( fc::file_size( dir.path() / "0.log" ), log_size );
+      BOOST_CHECK( idx->oldest()->id == operation_history_id_type( 2 ) );
+      BOOST_CHECK_EQUAL( operation_history_id_type( 0 )( db ).block_num, 1u );
+      BOOST_CHECK_EQUAL( operation_history_id_type( 1 )( db ).block_num, 2u );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( far_reinsertion_is_served_by_store )
+{
+   try {
+      fc::temp_directory dir( graphene::utilities::temp_directory_path() );
+      database db;
+      auto* idx = db.add_index< operation_history_primary_index >();
+      operation_history_store& store = idx->store();
+      store.open( dir.path() );
+
+      operation_history_object op;
+      for( uint64_t i = 0; i < 3; ++i )
+      {
+         op.id = operation_history_id_type( i );
+         op.block_num = i + 1;
+         store.append( op );
+      }
+      store.flush();
+
+      const uint64_t newest = 3 + 2 * operation_history_disk_index::max_front_gap;
+      op.id = operation_history_id_type( newest );
+      op.block_num = newest + 1;
+      idx->insert( operation_history_object( op ) );
+      BOOST_CHECK( idx->oldest()->id == op.id );
+
+      // putting back an operation the store holds, far in front of the ones in memory, leaves memory as it is
+      op.id = operation_history_id_type( 1 );
+      op.block_num = 2;
+      const object& reinserted = idx->insert( operation_history_object( op ) );
+      BOOST_CHECK( reinserted.id == op.id );
+      BOOST_CHECK( idx->oldest()->id == operation_history_id_type( newest ) );
+      BOOST_REQUIRE( db.find( operation_history_id_type( 1 ) ) != nullptr );
+      BOOST_CHECK_EQUAL( operation_history_id_type( 1 )( db ).block_num, 2u );
+
+      // one the store does not hold is rejected
+      op.id = operation_history_id_type( 3 );
+      op.block_num = 4;
+      BOOST_REQUIRE_THROW( idx->insert( operation_history_object( op ) ), fc::exception );
+      BOOST_CHECK( db.find( operation_history_id_type( 3 ) ) == nullptr );
+
+      // one close in front of them is kept in memory
+      op.id = operation_history_id_type( newest - operation_history_disk_index::max_front_gap );
+      op.block_num = newest - operation_history_disk_index::max_front_gap + 1;
+      idx->insert( operation_history_object( op ) );
+      BOOST_CHECK( idx->oldest()->id == op.id );
+      BOOST_CHECK_EQUAL( op.id( db ).block_num, op.block_num );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
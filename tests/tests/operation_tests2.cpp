@@ -24,6 +24,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/impacted.hpp>
+
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
@@ -33,6 +35,7 @@
 #include <graphene/chain/balance_object.hpp>
 #include <graphene/chain/budget_record_object.hpp>
 #include <graphene/chain/committee_member_object.hpp>
+#include <graphene/chain/deflation_object.hpp>
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
 #include <graphene/chain/withdraw_permission_object.hpp>
@@ -1695,4 +1698,152 @@ BOOST_AUTO_TEST_CASE( buyback )
    } FC_LOG_AND_RETHROW()
 }
 
+/**
+ *  A deflation whose order cursor passed its last order, which was removed, is cleared by an operation in the
+ *  block, so that every node clears it and not only the one that produced the block.
+ */
+BOOST_AUTO_TEST_CASE( bulk_deflation_clears_removed_last_order )
+{ try {
+   generate_blocks( HARDFORK_BULK_DEFLATION_TIME );
+   generate_block();
+   set_expiration( db, trx );
+
+   ACTORS( (alice) );
+   const asset_id_type test_id = create_user_issued_asset( "TEST" ).id;
+   fund( alice, asset( 1000000 ) );
+   const limit_order_id_type order_id = create_sell_order( alice_id, asset( 500000 ), asset( 100, test_id ) )->id;
+   generate_block();
+
+   const auto& acc_idx = db.get_index_type<account_index>().indices().get<by_id>();
+   const deflation_id_type dflt_id = db.create<deflation_object>( [&]( deflation_object& obj ) {
+      obj.timestamp = db.head_block_time();
+      obj.issuer = GRAPHENE_DEFLATION_ISSUE_ACCOUNT;
+      obj.rate = GRAPHENE_DEFLATION_RATE_SCALE / 100;
+      obj.last_account = acc_idx.rbegin()->id;
+      obj.account_cursor = GRAPHENE_DEFLATION_ACCOUNT_START_MARKER;
+      obj.balance_cleared = false;
+      obj.last_order = order_id;
+      obj.order_cursor = order_id + 1;
+      obj.order_cleared = false;
+      obj.total_amount = 0;
+   }).id;
+
+   generate_block();
+   BOOST_CHECK( dflt_id(db).order_cleared );
+   BOOST_CHECK( order_id(db).for_sale == 500000 );
+
+   const auto block = db.fetch_block_by_number( db.head_block_num() );
+   BOOST_REQUIRE( block.valid() );
+   uint32_t clearing_ops = 0;
+   for( const auto& tx : block->transactions )
+      for( const auto& op : tx.operations )
+         if( op.which() == operation::tag<order_bulk_deflation_operation>::value )
+         {
+            const auto& o = op.get<order_bulk_deflation_operation>();
+            BOOST_CHECK( o.first == order_id + 1 );
+            BOOST_CHECK( o.last == order_id + 1 );
+            ++clearing_ops;
+         }
+   BOOST_CHECK_EQUAL( clearing_ops, 1u );
+
+   // the evaluator clears the deflation, rejects the operation once it is cleared, and a range past the last
+   // order must hold a single id
+   order_bulk_deflation_operation op;
+   op.deflation_id = dflt_id;
+   op.first = order_id + 1;
+   op.last = order_id + 1;
+   trx.clear();
+   trx.operations.push_back( op );
+   GRAPHENE_REQUIRE_THROW( PUSH_TX( db, trx, ~0 ), fc::exception );
+   db.modify( dflt_id(db), []( deflation_object& obj ) { obj.order_cleared = false; } );
+   trx.operations.back().get<order_bulk_deflation_operation>().last = order_id + 2;
+   GRAPHENE_REQUIRE_THROW( PUSH_TX( db, trx, ~0 ), fc::exception );
+   BOOST_CHECK( !dflt_id(db).order_cleared );
+   trx.operations.back().get<order_bulk_deflation_operation>().last = order_id + 1;
+   PUSH_TX( db, trx, ~0 );
+   BOOST_CHECK( dflt_id(db).order_cleared );
+   BOOST_CHECK( order_id(db).for_sale == 500000 );
+   trx.clear();
+} FC_LOG_AND_RETHROW() }
+
+/**
+ *  Bulk deflation covers id ranges, but each deflated balance and order is still recorded for its owner by a
+ *  virtual per-account or per-order deflation operation.
+ */
+BOOST_AUTO_TEST_CASE( bulk_deflation_records_owners )
+{ try {
+   generate_blocks( HARDFORK_BULK_DEFLATION_TIME );
+   generate_block();
+   set_expiration( db, trx );
+
+   ACTORS( (alice)(bob) );
+   const asset_id_type test_id = create_user_issued_asset( "TEST" ).id;
+   fund( alice, asset( 1000000 ) );
+   fund( bob, asset( 2000000 ) );
+   const limit_order_id_type order_id = create_sell_order( alice_id, asset( 500000 ), asset( 100, test_id ) )->id;
+   generate_block();
+
+   const share_type alice_balance = get_balance( alice_id, asset_id_type() );
+   const share_type bob_balance = get_balance( bob_id, asset_id_type() );
+   const uint32_t rate = GRAPHENE_DEFLATION_RATE_SCALE / 100;
+
+   const auto& acc_idx = db.get_index_type<account_index>().indices().get<by_id>();
+   const deflation_id_type dflt_id = db.create<deflation_object>( [&]( deflation_object& obj ) {
+      obj.timestamp = db.head_block_time();
+      obj.issuer = GRAPHENE_DEFLATION_ISSUE_ACCOUNT;
+      obj.rate = rate;
+      obj.last_account = acc_idx.rbegin()->id;
+      obj.account_cursor = GRAPHENE_DEFLATION_ACCOUNT_START_MARKER;
+      obj.balance_cleared = false;
+      obj.last_order = order_id;
+      obj.order_cursor = order_id;
+      obj.order_cleared = false;
+      obj.total_amount = 0;
+   }).id;
+
+   vector<operation> applied;
+   boost::signals2::scoped_connection connection = db.applied_block.connect( [&]( const signed_block& ) {
+      for( const auto& oh : db.get_applied_operations() )
+         if( oh.valid() )
+            applied.push_back( oh->op );
+   });
+   while( !dflt_id(db).balance_cleared || !dflt_id(db).order_cleared )
+      generate_block();
+
+   map< account_id_type, share_type > account_amounts;
+   map< limit_order_id_type, pair<account_id_type,share_type> > order_amounts;
+   uint32_t bulk_ops = 0;
+   for( const auto& op : applied )
+   {
+      if( op.which() == operation::tag<account_deflation_operation>::value )
+         account_amounts[ op.get<account_deflation_operation>().owner ] += op.get<account_deflation_operation>().amount;
+      else if( op.which() == operation::tag<order_deflation_operation>::value )
+      {
+         const auto& o = op.get<order_deflation_operation>();
+         order_amounts[ o.order ] = std::make_pair( o.owner, o.amount );
+      }
+      else if( op.which() == operation::tag<account_bulk_deflation_operation>::value
+               || op.which() == operation::tag<order_bulk_deflation_operation>::value )
+         ++bulk_ops;
+   }
+   BOOST_CHECK_GT( bulk_ops, 0u );
+
+   BOOST_CHECK_EQUAL( account_amounts[ alice_id ].value, alice_balance.value * rate / GRAPHENE_DEFLATION_RATE_SCALE );
+   BOOST_CHECK_EQUAL( account_amounts[ bob_id ].value, bob_balance.value * rate / GRAPHENE_DEFLATION_RATE_SCALE );
+   BOOST_CHECK_EQUAL( get_balance( bob_id, asset_id_type() ), bob_balance.value - account_amounts[ bob_id ].value );
+
+   BOOST_REQUIRE_EQUAL( order_amounts.count( order_id ), 1u );
+   BOOST_CHECK( order_amounts[ order_id ].first == alice_id );
+   BOOST_CHECK_EQUAL( order_amounts[ order_id ].second.value, 500000 * rate / GRAPHENE_DEFLATION_RATE_SCALE );
+
+   // the virtual operations put each owner in the impacted accounts, as the per-account operations did
+   flat_set<account_id_type> impacted;
+   for( const auto& op : applied )
+      if( op.which() == operation::tag<order_deflation_operation>::value
+          || op.which() == operation::tag<account_deflation_operation>::value )
+         graphene::app::operation_get_impacted_accounts( op, impacted );
+   BOOST_CHECK( impacted.count( alice_id ) );
+   BOOST_CHECK( impacted.count( bob_id ) );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()